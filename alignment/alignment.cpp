@@ -221,9 +221,12 @@ void Alignment::checkSeqName() {
     }
     bool listSequences = !Params::getInstance().suppress_list_of_sequences;
     int max_len = getMaxSeqNameLength()+1;
+    // the table is formatted in its own stream, as alignments of partitions may be read in parallel
     if (listSequences) {
-        cout.width(max_len+14);
-        cout << right << "Gap/Ambiguity" << "  Composition  p-value"<< endl;
+        ostringstream header;
+        header.width(max_len+14);
+        header << right << "Gap/Ambiguity" << "  Composition  p-value"<< endl;
+        cout << header.str();
     }
     int num_problem_seq = 0;
     int total_gaps = 0;
@@ -320,37 +323,44 @@ void Alignment::checkSeqName() {
         seqInfo[i].failed = (pvalue < 0.05);
         num_failed += seqInfo[i].failed ? 1 : 0;
     }
+    ostringstream table;
+    table.flags(cout.flags());
+    table.precision(2);
     if (listSequences) {
         for (size_t i = 0; i < numSequences; i++) {
-            cout.width(4);
-            cout << right << i + 1 << "  ";
-            cout.width(max_len);
-            cout << left << seq_names[i] << " ";
-            cout.width(6);
-            cout << right << seqInfo[i].percent_gaps << "%";
+            table.width(4);
+            table << right << i + 1 << "  ";
+            table.width(max_len);
+            table << left << seq_names[i] << " ";
+            table.width(6);
+            table << right << seqInfo[i].percent_gaps << "%";
             if (seqInfo[i].failed) {
-                cout << "    failed ";
+                table << "    failed ";
             }
             else {
-                cout << "    passed ";
+                table << "    passed ";
             }
-            cout.width(9);
-            cout << right << (seqInfo[i].pvalue * 100) << "%";
-            cout << endl;
+            table.width(9);
+            table << right << (seqInfo[i].pvalue * 100) << "%";
+            table << endl;
         }
     }
     delete[] seqInfo;
 
     if (num_problem_seq) {
-        cout << "WARNING: " << num_problem_seq << " sequences contain more than 50% gaps/ambiguity" << endl;
+        table << "WARNING: " << num_problem_seq << " sequences contain more than 50% gaps/ambiguity" << endl;
     }
     if (listSequences) {
-        cout << "**** ";
-        cout.width(max_len+2);
-        cout << left << " TOTAL  ";
-        cout.width(6);
-        cout << right << ((double)total_gaps/getNSite())/getNSeq()*100 << "% ";
-        cout << " " << num_failed << " sequences failed composition chi2 test (p-value<5%; df=" << df << ")" << endl;
+        table << "**** ";
+        table.width(max_len+2);
+        table << left << " TOTAL  ";
+        table.width(6);
+        table << right << ((double)total_gaps/getNSite())/getNSeq()*100 << "% ";
+        table << " " << num_failed << " sequences failed composition chi2 test (p-value<5%; df=" << df << ")" << endl;
+    }
+    cout << table.str();
+    if (listSequences) {
+        cout << right;
         cout.precision(3);
     }
     delete [] count_per_seq;
@@ -2075,26 +2085,30 @@ void Alignment::convertStateStr(string &str, SeqType seq_type) {
 */
 
 boost::bimap<int, char*> getGeneticCodeMap() {
-    if (!genetic_code_map.empty()) return genetic_code_map;
-
-    genetic_code_map.insert({1, genetic_code1});
-    genetic_code_map.insert({2, genetic_code2});
-    genetic_code_map.insert({3, genetic_code3});
-    genetic_code_map.insert({4, genetic_code4});
-    genetic_code_map.insert({5, genetic_code5});
-    genetic_code_map.insert({6, genetic_code6});
-    genetic_code_map.insert({9, genetic_code9});
-    genetic_code_map.insert({10, genetic_code10});
-    genetic_code_map.insert({11, genetic_code11});
-    genetic_code_map.insert({12, genetic_code12});
-    genetic_code_map.insert({13, genetic_code13});
-    genetic_code_map.insert({14, genetic_code14});
-    genetic_code_map.insert({16, genetic_code16});
-    genetic_code_map.insert({21, genetic_code21});
-    genetic_code_map.insert({22, genetic_code22});
-    genetic_code_map.insert({23, genetic_code23});
-    genetic_code_map.insert({24, genetic_code24});
-    genetic_code_map.insert({25, genetic_code25});
+    // codon alignments may be read in parallel
+#ifdef _OPENMP
+#pragma omp critical(genetic_code_map)
+#endif
+    if (genetic_code_map.empty()) {
+        genetic_code_map.insert({1, genetic_code1});
+        genetic_code_map.insert({2, genetic_code2});
+        genetic_code_map.insert({3, genetic_code3});
+        genetic_code_map.insert({4, genetic_code4});
+        genetic_code_map.insert({5, genetic_code5});
+        genetic_code_map.insert({6, genetic_code6});
+        genetic_code_map.insert({9, genetic_code9});
+        genetic_code_map.insert({10, genetic_code10});
+        genetic_code_map.insert({11, genetic_code11});
+        genetic_code_map.insert({12, genetic_code12});
+        genetic_code_map.insert({13, genetic_code13});
+        genetic_code_map.insert({14, genetic_code14});
+        genetic_code_map.insert({16, genetic_code16});
+        genetic_code_map.insert({21, genetic_code21});
+        genetic_code_map.insert({22, genetic_code22});
+        genetic_code_map.insert({23, genetic_code23});
+        genetic_code_map.insert({24, genetic_code24});
+        genetic_code_map.insert({25, genetic_code25});
+    }
 
     return genetic_code_map;
 }
@@ -4415,25 +4429,37 @@ void Alignment::createBootstrapAlignment(Alignment *aln, IntVector* pattern_freq
 	IntVector site_vec;
     if (!spec) {
 		// standard bootstrap
+        // patterns of aln are distinct, so each resampled pattern is copied once and
+        // weighted by its number of resampled sites, without hashing every site again.
+        // Patterns keep the order of their first resampled site.
         int added_sites = 0;
         IntVector sample;
         random_resampling(nsite, sample);
+        IntVector boot_ptn(aln->getNPattern(), -1);
         for (size_t site = 0; site < nsite; ++site) {
-            for (int rep = 0; rep < sample[site]; ++rep) {
-                int ptn_id = aln->getPatternID(site);
-                Pattern pat = aln->at(ptn_id);
-                int nptn = getNPattern();
-                addPattern(pat, added_sites);
-                if (!aln->site_state_freq.empty() && getNPattern() > nptn) {
+            if (sample[site] == 0) {
+                continue;
+            }
+            int ptn_id = aln->getPatternID(site);
+            if (boot_ptn[ptn_id] < 0) {
+                boot_ptn[ptn_id] = size();
+                push_back(aln->at(ptn_id));
+                back().frequency = 0;
+                computeConst(back());
+                pattern_index[back()] = boot_ptn[ptn_id];
+                if (!aln->site_state_freq.empty()) {
                     // a new pattern is added, copy state frequency vector
                     double *state_freq = new double[num_states];
                     memcpy(state_freq, aln->site_state_freq[ptn_id], num_states*sizeof(double));
                     site_state_freq.push_back(state_freq);
                 }
-                if (pattern_freq) {
-                    ((*pattern_freq)[ptn_id])++;
-                }
-                added_sites++;
+            }
+            at(boot_ptn[ptn_id]).frequency += sample[site];
+            for (int rep = 0; rep < sample[site]; ++rep) {
+                site_pattern[added_sites++] = boot_ptn[ptn_id];
+            }
+            if (pattern_freq) {
+                (*pattern_freq)[ptn_id] += sample[site];
             }
         }
         if (added_sites < nsite) {
@@ -6596,6 +6622,45 @@ bool Alignment::readSiteStateFreq(const char* site_freq_file)
     return aln_changed;
 }
 
+int Alignment::mergeSiteStateFreq(double epsilon) {
+    size_t num_freqs = site_state_freq.size();
+    // key of a vector: its frequencies, or grid cells if epsilon > 0; empty for default frequencies
+    map<vector<double>, int> freq_index;
+    IntVector new_id(num_freqs);
+    vector<double*> merged_freq;
+    for (size_t i = 0; i < num_freqs; i++) {
+        vector<double> key;
+        if (site_state_freq[i]) {
+            key.assign(site_state_freq[i], site_state_freq[i] + num_states);
+            if (epsilon > 0.0)
+                for (auto &f : key)
+                    f = floor(f / epsilon);
+        }
+        auto it = freq_index.find(key);
+        if (it == freq_index.end()) {
+            new_id[i] = merged_freq.size();
+            freq_index[key] = new_id[i];
+            merged_freq.push_back(site_state_freq[i]);
+        } else {
+            new_id[i] = it->second;
+            delete [] site_state_freq[i];
+        }
+    }
+    site_state_freq = merged_freq;
+    if (merged_freq.size() == num_freqs)
+        return num_freqs;
+
+    for (auto &model : site_model)
+        model = new_id[model];
+    cout << "Merged " << num_freqs << " site frequency vectors into " << merged_freq.size();
+    if (epsilon > 0.0)
+        cout << " (epsilon = " << epsilon << ")";
+    cout << endl;
+    // consecutive patterns then share frequency vectors, thus the eigensystems in the likelihood kernel
+    regroupSitePattern(merged_freq.size(), site_model);
+    return merged_freq.size();
+}
+
 /**
  * set the expected_num_sites (for alisim)
  * @param the expected_num_sites
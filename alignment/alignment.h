@@ -1010,6 +1010,15 @@ public:
 	 */
 	bool readSiteStateFreq(const char* site_freq_file);
 
+    /**
+     * merge identical site-specific state frequency vectors so that they share one model,
+     * then regroup site patterns such that patterns of the same vector are consecutive
+     * @param epsilon if positive, also merge vectors falling into the same cell of a grid
+     *        with this spacing, i.e. differing by less than epsilon in every state
+     * @return number of distinct vectors
+     */
+    int mergeSiteStateFreq(double epsilon);
+
     // added by TD
     /**
      * Compute pairwise summary statistics between two sequences, resulting in 26 values:
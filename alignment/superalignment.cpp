@@ -47,6 +47,111 @@ Alignment *createAlignment(string aln_file, const char *sequence_type, InputType
     return aln;
 }
 
+/**
+    stream buffer keeping the output of each OpenMP thread in a separate string,
+    so that the messages of alignments read in parallel can be printed in input order
+*/
+class ThreadOutputBuffer : public streambuf {
+public:
+    ThreadOutputBuffer(int num_threads) : outputs(num_threads) {}
+
+    /** @return the output of the calling thread since the last call */
+    string take() {
+        string str;
+        str.swap(outputs[threadID()]);
+        return str;
+    }
+
+protected:
+    vector<string> outputs;
+
+    int threadID() {
+#ifdef _OPENMP
+        return omp_get_thread_num();
+#else
+        return 0;
+#endif
+    }
+
+    virtual int overflow(int c) {
+        if (c != EOF)
+            outputs[threadID()].push_back(c);
+        return c;
+    }
+
+    virtual streamsize xsputn(const char *s, streamsize n) {
+        outputs[threadID()].append(s, n);
+        return n;
+    }
+};
+
+/**
+    read one alignment per file, in parallel if several threads are available
+    @param filenames alignment files
+    @param sequence_type sequence type
+    @param[out] intype input type of the last file
+    @param model model name
+    @param remove_empty_seq TRUE to remove sequences with only gaps
+    @param[out] alns alignments in the order of the files
+*/
+static void readAlignmentFiles(StrVector &filenames, char *sequence_type, InputType &intype,
+                               string model, bool remove_empty_seq, vector<Alignment*> &alns)
+{
+    double start_time = getRealTime();
+    int num_files = filenames.size();
+    alns.resize(num_files, nullptr);
+    vector<InputType> intypes(num_files, IN_OTHER);
+    int num_threads = 1;
+#ifdef _OPENMP
+    // files inside a directory of a list are read by the thread of the directory
+    if (!omp_in_parallel())
+        num_threads = min(omp_get_max_threads(), num_files);
+#endif
+    // messages of each file are collected and printed after all files are read
+    StrVector outputs(num_files);
+    ThreadOutputBuffer thread_buf(num_threads);
+    streambuf *cout_buf = nullptr;
+    if (num_threads > 1)
+        cout_buf = cout.rdbuf(&thread_buf);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads) if(num_threads > 1)
+#endif
+    for (int i = 0; i < num_files; i++) {
+        Alignment *part_aln;
+        if (num_threads > 1 && detectInputFile(filenames[i].c_str()) == IN_NEXUS) {
+            // the NEXUS reader is not thread-safe
+#ifdef _OPENMP
+#pragma omp critical(nexus_reader)
+#endif
+            part_aln = createAlignment(filenames[i], sequence_type, intypes[i], model);
+        } else {
+            part_aln = createAlignment(filenames[i], sequence_type, intypes[i], model);
+        }
+        Alignment *new_aln;
+        if (remove_empty_seq) {
+            new_aln = part_aln->removeGappySeq();
+        } else {
+            new_aln = part_aln;
+        }
+        if (part_aln != new_aln) {
+            delete part_aln;
+        }
+        alns[i] = new_aln;
+        if (num_threads > 1)
+            outputs[i] = thread_buf.take();
+    }
+
+    if (num_threads > 1) {
+        cout.rdbuf(cout_buf);
+        for (auto &output : outputs)
+            cout << output;
+    }
+    intype = intypes.back();
+    cout << num_files << " alignment files read in " << getRealTime() - start_time
+         << " seconds using " << num_threads << " thread(s)" << endl;
+}
+
 SuperAlignment::SuperAlignment() : Alignment() {
     max_num_states = 0;
 }
@@ -194,24 +299,45 @@ void SuperAlignment::init(StrVector *sequence_names) {
             i->resize(nsite, -1);
     }
 
+    double start_time = getRealTime();
+    // assign taxon IDs in the order of first occurrence
+    unordered_map<string, int> name_ids;
+    for (size_t id = 0; id < seq_names.size(); ++id)
+        name_ids[seq_names[id]] = id;
+    vector<IntVector> part_ids(nsite);
     size_t site = 0;
 	for (auto it = partitions.begin(); it != partitions.end(); ++it, ++site) {
 		size_t nseq = (*it)->getNSeq();
-		//cout << "nseq  = " << nseq << endl;
+		part_ids[site].resize(nseq);
 		for (size_t seq = 0; seq < nseq; ++seq) {
-			int id = getSeqID((*it)->getSeqName(seq));
-			if (id < 0) {
+			auto ins = name_ids.insert({(*it)->getSeqName(seq), (int)seq_names.size()});
+			if (ins.second)
 				seq_names.push_back((*it)->getSeqName(seq));
-				id = seq_names.size()-1;
-				IntVector vec(nsite, -1);
-				vec[site] = seq;
-				taxa_index.push_back(vec);
-			} else
-				taxa_index[id][site] = seq;
+			part_ids[site][seq] = ins.first->second;
 		}
 	}
+	taxa_index.resize(seq_names.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+	for (size_t id = 0; id < taxa_index.size(); ++id)
+		taxa_index[id].resize(nsite, -1);
+	// each partition fills its own column
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (size_t part = 0; part < nsite; ++part)
+		for (size_t seq = 0; seq < part_ids[part].size(); ++seq)
+			taxa_index[part_ids[part][seq]][part] = seq;
+    if (verbose_mode >= VB_MED) {
+        cout << "Time to build taxon index of " << seq_names.size() << " taxa was " << getRealTime() - start_time << " sec." << endl;
+    }
 	// now the patterns of sequence-genes presence/absence
+    start_time = getRealTime();
 	buildPattern();
+    if (verbose_mode >= VB_MED) {
+        cout << "Time to build presence/absence patterns was " << getRealTime() - start_time << " sec." << endl;
+    }
 }
 
 void SuperAlignment::buildPattern() {
@@ -225,12 +351,23 @@ void SuperAlignment::buildPattern() {
 	VerboseMode save_mode = verbose_mode; 
 	verbose_mode = min(verbose_mode, VB_MIN); // to avoid printing gappy sites in addPattern
 	size_t nseq = getNSeq();
-	for (size_t site = 0; site < nsite; site++) {
- 		Pattern pat;
- 		pat.resize(nseq, 0);
-		for (size_t seq = 0; seq < nseq; seq++)
-			pat[seq] = (taxa_index[seq][site] >= 0)? 1 : 0;
-		addPattern(pat, site);
+	// patterns are built in parallel in blocks to bound the memory, then added in order
+	const size_t block_size = 4096;
+	vector<Pattern> pats(min(nsite, block_size));
+	for (size_t block = 0; block < nsite; block += block_size) {
+		size_t block_end = min(nsite, block + block_size);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+		for (size_t site = block; site < block_end; site++) {
+			Pattern &pat = pats[site - block];
+			pat = Pattern();
+			pat.resize(nseq, 0);
+			for (size_t seq = 0; seq < nseq; seq++)
+				pat[seq] = (taxa_index[seq][site] >= 0)? 1 : 0;
+		}
+		for (size_t site = block; site < block_end; site++)
+			addPattern(pats[site - block], site);
 	}
 	verbose_mode = save_mode;
 	countConstSite();
@@ -704,31 +841,17 @@ void SuperAlignment::readPartitionDir(string partition_dir, char *sequence_type,
     std::sort(filenames.begin(), filenames.end());
     cout << "Reading " << filenames.size() << " alignment files in directory " << partition_dir << endl;
     
+    StrVector paths;
     for (auto it = filenames.begin(); it != filenames.end(); it++)
+        paths.push_back(dir + *it);
+    vector<Alignment*> alns;
+    readAlignmentFiles(paths, sequence_type, intype, model_name, remove_empty_seq, alns);
+    for (size_t i = 0; i < alns.size(); i++)
     {
-        Alignment *part_aln;
-        part_aln = createAlignment(dir+*it, sequence_type, intype, model_name);
-//        if (part_aln->seq_type == SEQ_DNA && (strncmp(params.sequence_type, "CODON", 5) == 0 || strncmp(params.sequence_type, "NT2AA", 5) == 0)) {
-//            Alignment *new_aln = new Alignment();
-//            new_aln->convertToCodonOrAA(part_aln, params.sequence_type+5, strncmp(params.sequence_type, "NT2AA", 5) == 0);
-//            delete part_aln;
-//            part_aln = new_aln;
-//        }
-        Alignment *new_aln;
-        if (remove_empty_seq) {
-            new_aln = part_aln->removeGappySeq();
-        } else {
-            new_aln = part_aln;
-        }
-        // also rebuild states set of each sequence for likelihood computation
-//        new_aln->buildSeqStates();
-        
-        if (part_aln != new_aln) {
-            delete part_aln;
-        }
-        new_aln->name = *it;
+        Alignment *new_aln = alns[i];
+        new_aln->name = filenames[i];
         new_aln->model_name = model_name;
-        new_aln->aln_file = dir + *it;
+        new_aln->aln_file = paths[i];
         new_aln->position_spec = "";
         if (sequence_type) {
             new_aln->sequence_type = sequence_type;
@@ -752,31 +875,14 @@ void SuperAlignment::readPartitionList(string file_list, char *sequence_type,
     }
     cout << "Reading " << filenames.size() << " alignment files..." << endl;
     
-    for (auto it = filenames.begin(); it != filenames.end(); it++)
+    vector<Alignment*> alns;
+    readAlignmentFiles(filenames, sequence_type, intype, model_name, remove_empty_seq, alns);
+    for (size_t i = 0; i < alns.size(); i++)
     {
-        Alignment *part_aln;
-        part_aln = createAlignment(*it, sequence_type, intype, model_name);
-        //        if (part_aln->seq_type == SEQ_DNA && (strncmp(params.sequence_type, "CODON", 5) == 0 || strncmp(params.sequence_type, "NT2AA", 5) == 0)) {
-        //            Alignment *new_aln = new Alignment();
-        //            new_aln->convertToCodonOrAA(part_aln, params.sequence_type+5, strncmp(params.sequence_type, "NT2AA", 5) == 0);
-        //            delete part_aln;
-        //            part_aln = new_aln;
-        //        }
-        Alignment *new_aln;
-        if (remove_empty_seq) {
-            new_aln = part_aln->removeGappySeq();
-        } else {
-            new_aln = part_aln;
-        }
-        // also rebuild states set of each sequence for likelihood computation
-//        new_aln->buildSeqStates();
-        
-        if (part_aln != new_aln) {
-            delete part_aln;
-        }
-        new_aln->name = *it;
+        Alignment *new_aln = alns[i];
+        new_aln->name = filenames[i];
         new_aln->model_name = model_name;
-        new_aln->aln_file = *it;
+        new_aln->aln_file = filenames[i];
         new_aln->position_spec = "";
         if (sequence_type) {
             new_aln->sequence_type = sequence_type;
@@ -0,0 +1,647 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+    iqtree-bench: micro-benchmark of the likelihood and parsimony kernels on
+    synthetic data. Build it with "make iqtree-bench" and run "iqtree-bench -h".
+
+    Every line of the tab-separated output is one kernel on one configuration.
+    FLOP and byte counts are estimates from the kernel structure (per pattern and
+    rate/mixture category, n = number of states):
+      partial: 6n^2 flops and 3n doubles per internal node (two children in, one out)
+      branch:  3n flops and 2n doubles
+      derv:    6n flops and n doubles (theta already computed, as in Newton-Raphson)
+      transmat: 2n^3 flops and n^2 doubles per matrix
+    Kernels without floating point work (parsimony, patterns, newick, rebuild, copy)
+    and the library calls (-api 1) report NA. patterns_per_sec counts pattern updates, i.e. patterns times internal
+    nodes for the full traversals (partial, parsimony) and alignment sites for patterns.
+    allocs_per_call counts the calls of the global operator new.
+*/
+
+#include <iqtree_config.h>
+#include "tree/phylotree.h"
+#include "model/modelfactory.h"
+#include "model/modelsubst.h"
+#include "model/rateheterogeneity.h"
+#include "alignment/alignment.h"
+#include "utils/tools.h"
+#include "utils/timeutil.h"
+#include "utils/MPIHelper.h"
+#include "vectorclass/instrset.h"
+#include "main/libiqtree_fun.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <atomic>
+#include <new>
+
+/** number of calls of the global operator new */
+static std::atomic<uint64_t> num_allocs(0);
+
+void *operator new(size_t size) {
+    num_allocs.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+/** stream buffer swallowing the messages of IQ-TREE during the benchmark */
+class NullStreamBuf : public streambuf {
+protected:
+    virtual int overflow(int c) override { return c; }
+    virtual streamsize xsputn(const char *s, streamsize n) override { return n; }
+};
+
+/** options of the benchmark */
+struct BenchOptions {
+    IntVector states;
+    IntVector ncats;
+    IntVector nmixs;
+    StrVector isas;
+    int ntaxa;
+    int nsites;
+    int num_threads;
+    double min_time;
+    int seed;
+    bool api;
+    const char *out_file;
+};
+
+/** one result line */
+struct BenchResult {
+    string kernel, isa;
+    int nstates, ncat, nmix, ntaxa, nptn;
+    double calls, seconds, patterns, flops, bytes, allocs;
+};
+
+static void printUsage() {
+    cout << "Usage: iqtree-bench [OPTIONS]" << endl
+         << "  -states LIST   Numbers of states: 2,4,20,61 (default: 2,4,20,61)" << endl
+         << "  -cat LIST      Numbers of Gamma rate categories (default: 1,4)" << endl
+         << "  -mix LIST      Numbers of mixture classes (default: 1,4)" << endl
+         << "  -isa LIST      Kernels: sse,avx,fma,avx512 (default: all supported)" << endl
+         << "  -taxa NUM      Number of taxa (default: 32)" << endl
+         << "  -sites NUM     Number of sites (default: 10000)" << endl
+         << "  -T NUM         Number of threads (default: 1)" << endl
+         << "  -time NUM      Minimum time per kernel in seconds (default: 0.3)" << endl
+         << "  -seed NUM      Random seed (default: 1)" << endl
+         << "  -api 0|1       Also time fit_tree() against the session API (default: 0)" << endl
+         << "  -o FILE        Write results to FILE instead of the screen" << endl;
+}
+
+static IntVector parseIntList(const char *str) {
+    IntVector list;
+    convert_int_vec(str, list);
+    return list;
+}
+
+/** @return LikelihoodKernel of an ISA name, or -1 if unknown */
+static int getKernel(const string &isa) {
+    if (isa == "sse") return LK_SSE2;
+    if (isa == "avx") return LK_AVX;
+    if (isa == "fma") return LK_AVX_FMA;
+    if (isa == "avx512") return LK_AVX512;
+    return -1;
+}
+
+/** @return TRUE if the CPU and this build support the kernel */
+static bool isKernelSupported(int lk) {
+    int instruction_set = instrset_detect();
+#if defined(BINARY32) || defined(__NOAVX__)
+    instruction_set = min(instruction_set, (int)LK_SSE42);
+#endif
+    if (instruction_set >= LK_AVX && hasFMA3() && instruction_set < LK_AVX_FMA)
+        instruction_set = LK_AVX_FMA;
+#ifndef __AVX512KNL
+    // without the AVX-512 kernel setLikelihoodKernel falls back to FMA
+    if (lk >= LK_AVX512)
+        return false;
+#endif
+    return lk <= instruction_set;
+}
+
+/** @return random sequences of a data type, codons as nucleotide triplets */
+static void generateSequences(int nstates, int ntaxa, int nsites, StrVector &names, StrVector &seqs, string &seq_type) {
+    string alphabet;
+    StrVector codons;
+    switch (nstates) {
+    case 2: alphabet = "01"; seq_type = "BIN"; break;
+    case 4: alphabet = "ACGT"; seq_type = "DNA"; break;
+    case 20: alphabet = "ARNDCQEGHILKMFPSTWYV"; seq_type = "AA"; break;
+    case 61:
+        seq_type = "CODON";
+        for (char a : string("ACGT"))
+            for (char b : string("ACGT"))
+                for (char c : string("ACGT")) {
+                    string codon = {a, b, c};
+                    if (codon != "TAA" && codon != "TAG" && codon != "TGA")
+                        codons.push_back(codon);
+                }
+        break;
+    default:
+        outError("Unsupported number of states: " + convertIntToString(nstates));
+    }
+    names.clear();
+    seqs.clear();
+    for (int i = 0; i < ntaxa; i++) {
+        names.push_back("T" + convertIntToString(i+1));
+        string seq;
+        for (int site = 0; site < nsites; site++) {
+            if (codons.empty())
+                seq += alphabet[random_int(alphabet.length())];
+            else
+                seq += codons[random_int(codons.size())];
+        }
+        seqs.push_back(seq);
+    }
+}
+
+/** @return random binary tree in Newick format with branch lengths */
+static string generateNewick(StrVector &names) {
+    StrVector subtrees;
+    for (auto &name : names)
+        subtrees.push_back(name + ":" + convertDoubleToString(0.01 + 0.2*random_double()));
+    while (subtrees.size() > 3) {
+        int i = random_int(subtrees.size());
+        string left = subtrees[i];
+        subtrees[i] = subtrees.back();
+        subtrees.pop_back();
+        int j = random_int(subtrees.size());
+        subtrees[j] = "(" + left + "," + subtrees[j] + "):" + convertDoubleToString(0.01 + 0.1*random_double());
+    }
+    string newick = "(";
+    for (int i = 0; i < subtrees.size(); i++)
+        newick += (i ? "," : "") + subtrees[i];
+    return newick + ");";
+}
+
+/** @return model name for a number of states, rate categories and mixture classes */
+static string getModelName(int nstates, int ncat, int nmix) {
+    string model;
+    switch (nstates) {
+    case 2: model = "GTR2"; break;
+    case 4: model = "GTR"; break;
+    case 20: model = "LG"; break;
+    default: model = "GY"; break;
+    }
+    if (nmix > 1) {
+        string mix = "MIX{";
+        for (int i = 0; i < nmix; i++)
+            mix += (i ? "," : "") + model;
+        model = mix + "}";
+    }
+    if (ncat > 1)
+        model += "+G" + convertIntToString(ncat);
+    return model;
+}
+
+/**
+    call a function until the minimum time is reached, after one untimed warm-up call
+    @return number of calls
+*/
+template <class Func>
+static double timeCalls(Func func, double min_time, double &seconds, double &allocs) {
+    double calls = 0;
+    size_t batch = 1;
+    func();
+    uint64_t begin_allocs = num_allocs;
+    double begin_time = getRealTime();
+    do {
+        for (size_t i = 0; i < batch; i++)
+            func();
+        calls += batch;
+        batch *= 2;
+        seconds = getRealTime() - begin_time;
+    } while (seconds < min_time);
+    allocs = (num_allocs - begin_allocs) / calls;
+    return calls;
+}
+
+static void printHeader(ostream &out) {
+    out << "kernel\tisa\tstates\tncat\tnmix\ttaxa\tpatterns\tthreads\tcalls\tseconds\tus_per_call"
+        << "\tpatterns_per_sec\tgflops\tgbytes_per_sec\tallocs_per_call" << endl;
+}
+
+static void printResult(ostream &out, BenchResult &res, int num_threads) {
+    out << res.kernel << "\t" << res.isa << "\t" << res.nstates << "\t" << res.ncat << "\t" << res.nmix
+        << "\t" << res.ntaxa << "\t" << res.nptn << "\t" << num_threads << "\t" << (int64_t)res.calls
+        << "\t" << res.seconds << "\t" << res.seconds*1e6/res.calls << "\t";
+    if (res.patterns > 0)
+        out << res.patterns*res.calls/res.seconds;
+    else
+        out << "NA";
+    out << "\t";
+    if (res.flops > 0)
+        out << res.flops*res.calls/res.seconds*1e-9;
+    else
+        out << "NA";
+    out << "\t";
+    if (res.bytes > 0)
+        out << res.bytes*res.calls/res.seconds*1e-9;
+    else
+        out << "NA";
+    out << "\t" << res.allocs << endl;
+}
+
+/**
+    benchmark the likelihood and parsimony kernels of one configuration
+    @param names, seqs, seq_type synthetic alignment
+    @param newick synthetic tree
+*/
+static void benchConfiguration(BenchOptions &opt, StrVector &names, StrVector &seqs, string &seq_type,
+                               string &newick, int nstates, int ncat, int nmix, const string &isa, ostream &out)
+{
+    Params &params = Params::getInstance();
+    int lk = getKernel(isa);
+    params.SSE = (LikelihoodKernel)lk;
+
+    BenchResult res;
+    res.isa = isa;
+    res.nstates = nstates;
+    res.ncat = ncat;
+    res.nmix = nmix;
+    res.ntaxa = opt.ntaxa;
+
+    // pattern building, only once per data type
+    Alignment *aln = nullptr;
+    double seconds, allocs;
+    double calls = timeCalls([&]() {
+        delete aln;
+        aln = new Alignment;
+        for (auto &name : names)
+            aln->addSeqName(name);
+        aln->buildPattern(seqs, (char*)seq_type.c_str(), opt.ntaxa, seqs[0].length());
+        aln->countConstSite();
+    }, opt.min_time, seconds, allocs);
+    res.nptn = aln->getNPattern();
+    if (ncat == opt.ncats[0] && nmix == opt.nmixs[0] && isa == opt.isas[0]) {
+        res.kernel = "patterns";
+        res.calls = calls;
+        res.seconds = seconds;
+        res.allocs = allocs;
+        res.patterns = opt.nsites;
+        res.flops = res.bytes = 0;
+        printResult(out, res, opt.num_threads);
+    }
+
+    // Newick parsing, only once per data type
+    if (ncat == opt.ncats[0] && nmix == opt.nmixs[0] && isa == opt.isas[0]) {
+        res.kernel = "newick";
+        res.calls = timeCalls([&]() {
+            MTree mtree;
+            stringstream ss(newick);
+            bool rooted = false;
+            mtree.readTree(ss, rooted);
+        }, opt.min_time, res.seconds, res.allocs);
+        res.patterns = 0;
+        res.flops = 0;
+        res.bytes = newick.length();
+        printResult(out, res, opt.num_threads);
+    }
+
+    PhyloTree *tree = new PhyloTree(aln);
+    tree->setParams(&params);
+    tree->aln = aln;
+    tree->readTreeStringSeqName(newick);
+
+    // rebuilding and copying a tree, only once per data type
+    if (ncat == opt.ncats[0] && nmix == opt.nmixs[0] && isa == opt.isas[0]) {
+        res.kernel = "rebuild";
+        res.calls = timeCalls([&]() {
+            tree->readTreeStringSeqName(newick);
+        }, opt.min_time, res.seconds, res.allocs);
+        res.patterns = res.flops = 0;
+        res.bytes = newick.length();
+        printResult(out, res, opt.num_threads);
+
+        res.kernel = "copy";
+        PhyloTree copy_tree;
+        copy_tree.setParams(&params);
+        res.calls = timeCalls([&]() {
+            copy_tree.copyPhyloTree(tree, false);
+        }, opt.min_time, res.seconds, res.allocs);
+        res.bytes = 0;
+        printResult(out, res, opt.num_threads);
+    }
+    ModelsBlock *models_block = readModelsDefinition(params);
+    string model_name = getModelName(nstates, ncat, nmix);
+    tree->setModelFactory(new ModelFactory(params, model_name, tree, models_block));
+    delete models_block;
+    tree->setModel(tree->getModelFactory()->model);
+    tree->setRate(tree->getModelFactory()->site_rate);
+    tree->setLikelihoodKernel((LikelihoodKernel)lk);
+    tree->setNumThreads(opt.num_threads);
+    tree->initializeAllPartialLh();
+
+    size_t ncat_mix = tree->getRate()->getNDiscreteRate() * tree->getModel()->getNMixtures();
+    double nptn = aln->getNPattern();
+    double n = tree->getModel()->num_states;
+    int num_internal = opt.ntaxa - 2;
+    PhyloNeighbor *branch = (PhyloNeighbor*)tree->root->neighbors[0];
+    PhyloNode *dad = (PhyloNode*)tree->root;
+
+    // partial likelihoods of all internal nodes towards the root
+    res.kernel = "partial";
+    res.calls = timeCalls([&]() {
+        tree->clearAllPartialLH();
+        tree->computeLikelihood();
+    }, opt.min_time, res.seconds, res.allocs);
+    res.patterns = nptn*num_internal;
+    res.flops = 6*n*n*ncat_mix*nptn*num_internal;
+    res.bytes = 3*n*ncat_mix*nptn*num_internal*sizeof(double);
+    printResult(out, res, opt.num_threads);
+
+    // likelihood at a branch with all partial likelihoods computed
+    res.kernel = "branch";
+    res.calls = timeCalls([&]() {
+        tree->computeLikelihoodBranch(branch, dad);
+    }, opt.min_time, res.seconds, res.allocs);
+    res.patterns = nptn;
+    res.flops = 3*n*ncat_mix*nptn;
+    res.bytes = 2*n*ncat_mix*nptn*sizeof(double);
+    printResult(out, res, opt.num_threads);
+
+    // derivatives of a Newton-Raphson step
+    double df, ddf;
+    tree->theta_computed = false;
+    tree->computeLikelihoodDerv(branch, dad, &df, &ddf);
+    res.kernel = "derv";
+    res.calls = timeCalls([&]() {
+        tree->computeLikelihoodDerv(branch, dad, &df, &ddf);
+    }, opt.min_time, res.seconds, res.allocs);
+    res.patterns = nptn;
+    res.flops = 6*n*ncat_mix*nptn;
+    res.bytes = n*ncat_mix*nptn*sizeof(double);
+    printResult(out, res, opt.num_threads);
+
+    // transition probability matrices of all rate categories and mixture classes
+    double *trans_matrix = aligned_alloc<double>(nstates*nstates);
+    ModelSubst *model = tree->getModel();
+    RateHeterogeneity *site_rate = tree->getRate();
+    res.kernel = "transmat";
+    res.calls = timeCalls([&]() {
+        for (int m = 0; m < model->getNMixtures(); m++)
+            for (int c = 0; c < site_rate->getNDiscreteRate(); c++)
+                model->computeTransMatrix(0.1*site_rate->getRate(c), trans_matrix, m);
+    }, opt.min_time, res.seconds, res.allocs);
+    aligned_free(trans_matrix);
+    res.patterns = 0;
+    res.flops = 2*n*n*n*ncat_mix;
+    res.bytes = n*n*ncat_mix*sizeof(double);
+    printResult(out, res, opt.num_threads);
+
+    // parsimony score, independent of rates and mixtures
+    if (ncat == opt.ncats[0] && nmix == opt.nmixs[0]) {
+        if (aln->ordered_pattern.empty())
+            aln->orderPatternByNumChars(PAT_VARIANT);
+        tree->setParsimonyKernel((LikelihoodKernel)lk);
+        tree->initializeAllPartialPars();
+        res.kernel = "parsimony";
+        res.ncat = res.nmix = 1;
+        res.calls = timeCalls([&]() {
+            tree->clearAllPartialLH();
+            tree->computeParsimony();
+        }, opt.min_time, res.seconds, res.allocs);
+        res.patterns = nptn*num_internal;
+        res.flops = res.bytes = 0;
+        printResult(out, res, opt.num_threads);
+    }
+
+    delete tree;
+    delete aln;
+}
+
+/**
+    benchmark repeated fits through the library: fit_tree() against a session
+    @param names, seqs, seq_type synthetic alignment
+    @param newick synthetic tree
+*/
+static void benchAPI(BenchOptions &opt, StrVector &names, StrVector &seqs, string &seq_type,
+                     string &newick, int nstates, ostream &out)
+{
+    vector<const char*> name_ptrs, seq_ptrs;
+    for (int i = 0; i < names.size(); i++) {
+        name_ptrs.push_back(names[i].c_str());
+        seq_ptrs.push_back(seqs[i].c_str());
+    }
+    StringArray name_arr = {name_ptrs.data(), name_ptrs.size()};
+    StringArray seq_arr = {seq_ptrs.data(), seq_ptrs.size()};
+    StringArray tree_arr = {nullptr, 1};
+    const char *tree_str = newick.c_str();
+    tree_arr.strings = &tree_str;
+    string model = getModelName(nstates, 4, 1);
+
+    BenchResult res;
+    res.isa = "auto";
+    res.nstates = nstates;
+    res.ncat = 4;
+    res.nmix = 1;
+    res.ntaxa = opt.ntaxa;
+    res.nptn = 0;
+    res.patterns = res.flops = res.bytes = 0;
+
+    // the old entry point: alignment, checkpoint and output files on every call
+    res.kernel = "api_fit_tree";
+    string checkpoint_file = "fit_tree_" + convertIntToString(opt.seed) + ".ckp.gz";
+    res.calls = timeCalls([&]() {
+        // a finished checkpoint stops fit_tree() before its options are parsed
+        remove(checkpoint_file.c_str());
+        StringResult result = fit_tree(name_arr, seq_arr, model.c_str(), tree_str, false, opt.seed,
+                                       opt.num_threads, "-redo");
+        if (strlen(result.errorStr))
+            outError(result.errorStr);
+        if (strlen(result.value))
+            delete[] result.value;
+        free(result.errorStr);
+    }, opt.min_time, res.seconds, res.allocs);
+    printResult(out, res, opt.num_threads);
+
+    SessionResult session = session_create(name_arr, seq_arr, seq_type.c_str(), opt.num_threads);
+    if (strlen(session.errorStr))
+        outError(session.errorStr);
+    free(session.errorStr);
+
+    // every fit starts from the same tree, so the model is re-estimated from its last values
+    res.kernel = "api_session_fit";
+    res.calls = timeCalls([&]() {
+        FitResult result = session_fit(session.value, model.c_str(), tree_str);
+        if (strlen(result.errorStr))
+            outError(result.errorStr);
+        free_fit_result(result);
+        free(result.errorStr);
+    }, opt.min_time, res.seconds, res.allocs);
+    printResult(out, res, opt.num_threads);
+
+    res.kernel = "api_session_evaluate";
+    double logl;
+    res.calls = timeCalls([&]() {
+        DoubleResult result = session_evaluate(session.value, tree_arr, &logl);
+        if (strlen(result.errorStr))
+            outError(result.errorStr);
+        free(result.errorStr);
+    }, opt.min_time, res.seconds, res.allocs);
+    printResult(out, res, opt.num_threads);
+    session_free(session.value);
+}
+
+int main(int argc, char *argv[]) {
+    MPIHelper::getInstance().init(argc, argv);
+    Params &params = Params::getInstance();
+    params.setDefault();
+
+    BenchOptions opt;
+    opt.states = {2, 4, 20, 61};
+    opt.ncats = {1, 4};
+    opt.nmixs = {1, 4};
+    opt.ntaxa = 32;
+    opt.nsites = 10000;
+    opt.num_threads = 1;
+    opt.min_time = 0.3;
+    opt.seed = 1;
+    opt.api = false;
+    opt.out_file = nullptr;
+    try {
+        for (int cnt = 1; cnt < argc; cnt++) {
+            string arg = argv[cnt];
+            if (arg == "-h" || arg == "--help") {
+                printUsage();
+                return 0;
+            }
+            if (cnt+1 >= argc)
+                throw "Missing value for option " + arg;
+            const char *value = argv[++cnt];
+            if (arg == "-states")
+                opt.states = parseIntList(value);
+            else if (arg == "-cat")
+                opt.ncats = parseIntList(value);
+            else if (arg == "-mix")
+                opt.nmixs = parseIntList(value);
+            else if (arg == "-isa")
+                convert_string_vec(value, opt.isas);
+            else if (arg == "-taxa")
+                opt.ntaxa = convert_int(value);
+            else if (arg == "-sites")
+                opt.nsites = convert_int(value);
+            else if (arg == "-T")
+                opt.num_threads = convert_int(value);
+            else if (arg == "-time")
+                opt.min_time = convert_double(value);
+            else if (arg == "-seed")
+                opt.seed = convert_int(value);
+            else if (arg == "-api")
+                opt.api = convert_int(value);
+            else if (arg == "-o")
+                opt.out_file = value;
+            else
+                throw "Unknown option " + arg;
+        }
+        if (opt.ntaxa < 4)
+            throw string("At least 4 taxa please");
+        if (opt.nsites < 1 || opt.num_threads < 1)
+            throw string("Number of sites and threads must be positive");
+    } catch (string &str) {
+        cerr << "ERROR: " << str << endl;
+        printUsage();
+        return 2;
+    } catch (const char *str) {
+        cerr << "ERROR: " << str << endl;
+        return 2;
+    }
+
+    if (opt.isas.empty()) {
+        for (string isa : {"sse", "avx", "fma", "avx512"})
+            if (isKernelSupported(getKernel(isa)))
+                opt.isas.push_back(isa);
+    } else {
+        StrVector isas;
+        for (auto &isa : opt.isas) {
+            if (getKernel(isa) < 0)
+                outError("Unknown kernel " + isa);
+            if (isKernelSupported(getKernel(isa)))
+                isas.push_back(isa);
+            else
+                cerr << "WARNING: Kernel " << isa << " not supported by this CPU or build, skipped" << endl;
+        }
+        opt.isas = isas;
+    }
+    if (opt.isas.empty())
+        outError("No supported kernel to benchmark");
+
+#ifdef _OPENMP
+    omp_set_num_threads(opt.num_threads);
+#else
+    opt.num_threads = 1;
+#endif
+    params.num_threads = opt.num_threads;
+    verbose_mode = VB_QUIET;
+    init_random(opt.seed);
+
+    // results go to the file or the original standard output, IQ-TREE messages are dropped
+    ofstream out_file;
+    streambuf *cout_buf = cout.rdbuf();
+    streambuf *out_buf = cout_buf;
+    if (opt.out_file) {
+        out_file.open(opt.out_file);
+        if (!out_file.is_open())
+            outError(ERR_WRITE_OUTPUT, opt.out_file);
+        out_buf = out_file.rdbuf();
+    }
+    ostream out(out_buf);
+    out.precision(6);
+    // static, the log streams of the library calls keep a pointer to it until the exit
+    static NullStreamBuf null_buf;
+    cout.rdbuf(&null_buf);
+
+    printHeader(out);
+    for (int nstates : opt.states) {
+        // same data for all kernels of a data type
+        StrVector names, seqs;
+        string seq_type;
+        generateSequences(nstates, opt.ntaxa, opt.nsites, names, seqs, seq_type);
+        string newick = generateNewick(names);
+        for (int ncat : opt.ncats)
+            for (int nmix : opt.nmixs)
+                for (auto &isa : opt.isas)
+                    benchConfiguration(opt, names, seqs, seq_type, newick, nstates, ncat, nmix, isa, out);
+        if (opt.api) {
+            benchAPI(opt, names, seqs, seq_type, newick, nstates, out);
+            // the library calls reset the global parameters
+            params.num_threads = opt.num_threads;
+            verbose_mode = VB_QUIET;
+        }
+    }
+
+    cout.rdbuf(cout_buf);
+    if (out_file.is_open())
+        out_file.close();
+    MPIHelper::getInstance().finalize();
+    return 0;
+}
@@ -147,4 +147,104 @@ extern "C" StringResult simulate_alignment(const char* tree, const char* subst_m
  */
 extern "C" void iqtree_free(void *p);
 
+/*
+ * Session API: an alignment is loaded once into a session, then many fit, evaluate
+ * and simulate calls reuse its patterns, model, likelihood buffers and threads.
+ * Results are returned as arrays instead of text, the per-site and per-tree
+ * outputs are written to buffers owned by the caller.
+ * All sessions share the global settings of IQ-TREE: use one session at a time.
+ */
+typedef struct IQTreeSession IQTreeSession;
+
+#ifdef _MSC_VER
+#pragma pack(push, 1)
+#else
+#pragma pack(1)
+#endif
+
+typedef struct {
+  IQTreeSession* value;
+  char* errorStr;
+} SessionResult;
+
+typedef struct {
+  double value;
+  char* errorStr;
+} DoubleResult;
+
+/*
+ * nodes 0..num_seqs-1 are the sequences in input order, the remaining ones are internal.
+ * parents[i] is the parent of node i when rooting at sequence 0 (-1 for sequence 0),
+ * branch_lengths[i] the length of the branch to the parent.
+ */
+typedef struct {
+  double logl;
+  double tree_length;
+  int* parents;
+  double* branch_lengths;
+  size_t num_nodes;
+  double* rates;        // rate matrix entries of the upper triangle, row by row
+  size_t num_rates;
+  double* state_freqs;
+  size_t num_states;
+  double gamma_shape;   // 0 without Gamma rate heterogeneity
+  double prop_invar;    // 0 without invariable sites
+  char* errorStr;
+} FitResult;
+
+#ifdef _MSC_VER
+#pragma pack(pop)
+#else
+#pragma pack()
+#endif
+
+/*
+ * Create a session from an alignment, the buffers are only read during the call
+ * seq_type -- sequence type as for option -st, "" to detect it automatically
+ * num_thres -- number of cpu threads used by all calls of the session, default: 1
+ * output: the session, release it with session_free()
+ */
+extern "C" SessionResult session_create(StringArray& names, StringArray& seqs, const char* seq_type = "", int num_thres = 1);
+
+/*
+ * Fit a model and the branch lengths on a tree topology, mixture and site-specific models are not supported
+ * The estimates of the previous fit with the same model are the starting values,
+ * and are used by session_evaluate() and session_simulate()
+ * tree -- the NEWICK tree string, NULL to reuse the tree of the previous call
+ * blfix -- whether to fix the branch lengths as those on the given tree, default: false
+ * output: the log-likelihood, the tree as parent and branch length arrays and the model parameters,
+ *         release it with free_fit_result()
+ */
+extern "C" FitResult session_fit(IQTreeSession* session, const char* model, const char* tree = NULL, bool blfix = false);
+
+/*
+ * Compute the log-likelihoods of a batch of trees under the model of the last session_fit()
+ * trees -- NEWICK tree strings
+ * optimize_brlen -- whether to optimize the branch lengths of every tree, default: false
+ * logl -- (OUT) log-likelihood of every tree, trees.length elements
+ * site_logl -- (OUT) if not NULL, site log-likelihoods of every tree, trees.length * num_sites elements
+ * output: the highest log-likelihood
+ */
+extern "C" DoubleResult session_evaluate(IQTreeSession* session, StringArray& trees, double* logl,
+                                         double* site_logl = NULL, bool optimize_brlen = false);
+
+/*
+ * Simulate an alignment under the model of the last session_fit() without indels
+ * tree -- the NEWICK tree string, NULL to reuse the tree of the previous call
+ * seqs -- (OUT) num_seqs rows of seq_length characters (3*seq_length for codons),
+ *         in the order of the sequences of the session, without separators
+ * output: the number of characters written
+ */
+extern "C" IntegerResult session_simulate(IQTreeSession* session, const char* tree, int seq_length, int seed, char* seqs);
+
+/*
+ * free the arrays of a FitResult
+ */
+extern "C" void free_fit_result(FitResult& result);
+
+/*
+ * free a session
+ */
+extern "C" void session_free(IQTreeSession* session);
+
 #endif /* LIBIQTREE2_FUN */
@@ -45,6 +45,7 @@
 #include "pda/splitgraph.h"
 #include "pda/circularnetwork.h"
 #include "tree/mtreeset.h"
+#include "tree/splitcounter.h"
 #include "tree/mexttree.h"
 #include "ncl/ncl.h"
 #include "nclextra/msetsblock.h"
@@ -2400,7 +2401,11 @@ int main(int argc, char *argv[]) {
 
     checkpoint->get("iqtree.seed", Params::getInstance().ran_seed);
     cout << "Seed:    " << Params::getInstance().ran_seed <<  " ";
-    init_random(Params::getInstance().ran_seed + MPIHelper::getInstance().getProcessID(), true);
+    // processes sharing the alignment patterns (--mpi-patterns) must take the same random decisions
+    if (Params::getInstance().mpi_patterns)
+        init_random(Params::getInstance().ran_seed, true);
+    else
+        init_random(Params::getInstance().ran_seed + MPIHelper::getInstance().getProcessID(), true);
     // initialize multiple random streams if needed
     if (Params::getInstance().multi_rstreams_used)
         init_multi_rstreams();
@@ -2611,6 +2616,10 @@ int main(int argc, char *argv[]) {
                     Params::getInstance().split_weight_summary, Params::getInstance().split_weight_threshold, Params::getInstance().out_file, Params::getInstance().out_prefix, Params::getInstance().tree_weight_file);
                 break;
             case CT_ASSIGN_SUPPORT:
+                if (Params::getInstance().transfer_bootstrap) {
+                    runTransferBootstrap(Params::getInstance(), Params::getInstance().second_tree, Params::getInstance().user_file);
+                    break;
+                }
                 assignBootstrapSupport(Params::getInstance().user_file, Params::getInstance().tree_burnin, Params::getInstance().tree_max_count, 
                     Params::getInstance().second_tree, Params::getInstance().is_rooted, Params::getInstance().out_file,
                     Params::getInstance().out_prefix, tree, Params::getInstance().tree_weight_file, &Params::getInstance());
@@ -3081,23 +3090,16 @@ extern "C" StringResult consensus_tree(StringArray& trees, double minsup) {
             params.split_threshold = max_split_threshold;
         bool rooted = false;
 
-        // // get a set of taxa names
-        vector<string> taxa_names;
-        MTree mtree;
-        mtree.read_TreeString(trees_vec[0], rooted);
-        mtree.getTaxaName(taxa_names);
-
-        // read the trees
-        MTreeSet boot_trees;
-        boot_trees.init(trees_vec, taxa_names, rooted);
+        // count the splits tree by tree
+        SplitCounter counter(rooted);
+        counter.countTrees(trees_vec);
 
         SplitGraph sg;
-        SplitIntMap hash_ss;
         double scale = 100.0;
         if (params.scaling_factor > 0)
             scale = params.scaling_factor;
-        boot_trees.convertSplits(sg, params.split_threshold, SW_COUNT, params.split_weight_threshold);
-        scale /= boot_trees.sumTreeWeights();
+        counter.convertSplits(sg, params.split_threshold, params.split_weight_threshold);
+        scale /= counter.sumTreeWeights();
         cout << sg.size() << " splits found" << endl;
 
         if (params.scaling_factor < 0)
@@ -3699,6 +3701,323 @@ extern "C" void iqtree_free(void *p) {
         free(p);
 }
 
+// --------------------------------------------------
+// Session API
+// --------------------------------------------------
+
+struct IQTreeSession {
+    Alignment *aln;
+    IQTree *tree;
+    ModelsBlock *models_block;
+    // model of the model factory of the tree
+    string model_name;
+    // tree string last read into the tree
+    string tree_string;
+};
+
+// copy the error message of an exception for a result
+static char* copyErrorStr(const exception& e) {
+    char* str = new char[strlen(e.what())+1];
+    strcpy(str, e.what());
+    return str;
+}
+
+// read a tree into the session, keeping the likelihood buffers
+static void setSessionTree(IQTreeSession* session, const char* tree_str) {
+    IQTree *tree = session->tree;
+    if (!tree_str) {
+        if (!tree->root)
+            outError("No tree given to the session yet");
+        return;
+    }
+    if (tree->root && session->tree_string == tree_str)
+        return;
+    tree->rooted = false;
+    tree->readTreeStringSeqName(tree_str);
+    if (tree->rooted)
+        tree->convertToUnrooted();
+    if (tree->leafNum != session->aln->getNSeq())
+        outError("The tree must contain all sequences of the session");
+    // branches without lengths get parsimony estimates
+    tree->wrapperFixNegativeBranch(false);
+    session->tree_string = tree_str;
+    if (tree->getModelFactory())
+        tree->initializeAllPartialLh();
+}
+
+// set up the model of the session, the previous estimates are kept for the same model
+static void setSessionModel(IQTreeSession* session, const char* model) {
+    IQTree *tree = session->tree;
+    if (tree->getModelFactory() && session->model_name == model)
+        return;
+    Params &params = Params::getInstance();
+    if (tree->getModelFactory()) {
+        tree->deleteAllPartialLh();
+        delete tree->getModelFactory();
+        tree->setModelFactory(nullptr);
+    }
+    session->model_name = "";
+    string model_name = model;
+    tree->setModelFactory(new ModelFactory(params, model_name, tree, session->models_block));
+    tree->setModel(tree->getModelFactory()->model);
+    tree->setRate(tree->getModelFactory()->site_rate);
+    if (tree->getModel()->isMixture() || tree->getModel()->isSiteSpecificModel())
+        outError("Mixture and site-specific models are not supported by the session API");
+    tree->setLikelihoodKernel(params.SSE);
+    tree->setNumThreads(params.num_threads);
+    tree->initializeAllPartialLh();
+    session->model_name = model;
+}
+
+extern "C" SessionResult session_create(StringArray& names, StringArray& seqs, const char* seq_type, int num_thres) {
+    SessionResult output;
+    output.value = NULL;
+    output.errorStr = strdup("");
+
+    IQTreeSession* session = NULL;
+    try {
+        progress_display::setProgressDisplay(false);
+        Params& params = Params::getInstance();
+        params.setDefault();
+        params.ignore_identical_seqs = false;
+        params.ignore_checkpoint = true;
+        // nothing is written, the prefix only names files of the tree
+        params.out_prefix = (char*) "iqtree_session";
+        verbose_mode = VB_QUIET;
+
+        int instruction_set = instrset_detect();
+#if defined(BINARY32) || defined(__NOAVX__)
+        instruction_set = min(instruction_set, (int)LK_SSE42);
+#endif
+        if (instruction_set < LK_SSE2)
+            outError("Your CPU does not support SSE2!");
+        if (instruction_set >= LK_AVX && hasFMA3() && instruction_set < LK_AVX_FMA)
+            instruction_set = LK_AVX_FMA;
+        params.SSE = min(params.SSE, (LikelihoodKernel)instruction_set);
+
+        if (num_thres < 1)
+            outError("Number of threads must be positive");
+#ifdef _OPENMP
+        omp_set_num_threads(num_thres);
+        omp_set_max_active_levels(1);
+#else
+        if (num_thres != 1)
+            outError("Number of threads must be 1 for sequential version.");
+#endif
+        params.num_threads = num_thres;
+
+        session = new IQTreeSession;
+        session->aln = NULL;
+        session->tree = NULL;
+        session->models_block = NULL;
+
+        // the sequences are compressed into patterns, the temporary strings are released here
+        {
+            vector<string> names_vec, seqs_vec;
+            convertToVectorStr(names, seqs, names_vec, seqs_vec);
+            char* sequence_type = (seq_type && strlen(seq_type) > 0) ? (char*)seq_type : NULL;
+            session->aln = new Alignment(names_vec, seqs_vec, sequence_type, "");
+        }
+        session->tree = new IQTree(session->aln);
+        session->tree->setParams(&params);
+        session->models_block = readModelsDefinition(params);
+        output.value = session;
+    } catch (const exception& e) {
+        output.errorStr = copyErrorStr(e);
+        if (session)
+            session_free(session);
+        funcExit();
+    }
+    return output;
+}
+
+extern "C" FitResult session_fit(IQTreeSession* session, const char* model, const char* tree_str, bool blfix) {
+    FitResult output;
+    memset(&output, 0, sizeof(output));
+    output.errorStr = strdup("");
+
+    try {
+        setSessionTree(session, tree_str);
+        setSessionModel(session, model);
+        IQTree *tree = session->tree;
+        Params& params = Params::getInstance();
+        output.logl = tree->getModelFactory()->optimizeParameters(blfix ? BRLEN_FIX : BRLEN_OPTIMIZE, false, params.modelEps);
+        output.tree_length = tree->treeLength();
+
+        // tree as parent array rooted at the first sequence
+        output.num_nodes = tree->nodeNum;
+        output.parents = (int*)malloc(sizeof(int) * tree->nodeNum);
+        output.branch_lengths = (double*)malloc(sizeof(double) * tree->nodeNum);
+        NodeVector nodes, dads;
+        Node *root = tree->findNodeID(0);
+        tree->getPreOrderBranches(nodes, dads, root);
+        output.parents[root->id] = -1;
+        output.branch_lengths[root->id] = 0.0;
+        for (int i = 0; i < nodes.size(); i++) {
+            output.parents[nodes[i]->id] = dads[i]->id;
+            output.branch_lengths[nodes[i]->id] = nodes[i]->findNeighbor(dads[i])->length;
+        }
+
+        ModelSubst *model = tree->getModel();
+        output.num_rates = model->getNumRateEntries();
+        output.rates = (double*)malloc(sizeof(double) * output.num_rates);
+        model->getRateMatrix(output.rates);
+        output.num_states = model->num_states;
+        output.state_freqs = (double*)malloc(sizeof(double) * output.num_states);
+        model->getStateFrequency(output.state_freqs);
+        output.gamma_shape = tree->getRate()->getGammaShape();
+        output.prop_invar = tree->getRate()->getPInvar();
+    } catch (const exception& e) {
+        free_fit_result(output);
+        output.errorStr = copyErrorStr(e);
+        funcExit();
+    }
+    return output;
+}
+
+extern "C" DoubleResult session_evaluate(IQTreeSession* session, StringArray& trees, double* logl,
+                                         double* site_logl, bool optimize_brlen) {
+    DoubleResult output;
+    output.value = -DBL_MAX;
+    output.errorStr = strdup("");
+
+    try {
+        IQTree *tree = session->tree;
+        if (!tree->getModelFactory())
+            outError("Call session_fit() before session_evaluate()");
+        size_t nsite = session->aln->getNSite();
+        double *pattern_lh = site_logl ? new double[session->aln->getNPattern()] : NULL;
+        for (size_t i = 0; i < trees.length; i++) {
+            setSessionTree(session, trees.strings[i]);
+            if (optimize_brlen)
+                logl[i] = tree->optimizeAllBranches();
+            else
+                logl[i] = tree->computeLikelihood();
+            if (site_logl) {
+                tree->computePatternLikelihood(pattern_lh, &logl[i]);
+                for (size_t site = 0; site < nsite; site++)
+                    site_logl[i*nsite + site] = pattern_lh[session->aln->getPatternID(site)];
+            }
+            output.value = max(output.value, logl[i]);
+        }
+        delete[] pattern_lh;
+    } catch (const exception& e) {
+        output.errorStr = copyErrorStr(e);
+        funcExit();
+    }
+    return output;
+}
+
+extern "C" IntegerResult session_simulate(IQTreeSession* session, const char* tree_str, int seq_length, int seed, char* seqs) {
+    IntegerResult output;
+    output.value = 0;
+    output.errorStr = strdup("");
+
+    int *rstream = NULL;
+    try {
+        IQTree *tree = session->tree;
+        if (!tree->getModelFactory())
+            outError("Call session_fit() before session_simulate()");
+        if (seq_length < 1)
+            outError("Positive sequence please.");
+        setSessionTree(session, tree_str);
+        init_random(seed, false, &rstream);
+
+        ModelSubst *model = tree->getModel();
+        RateHeterogeneity *site_rate = tree->getRate();
+        Alignment *aln = session->aln;
+        int nstates = model->num_states;
+        int ncat = site_rate->getNDiscreteRate();
+        double pinvar = site_rate->getPInvar();
+        int state_len = (aln->seq_type == SEQ_CODON) ? 3 : 1;
+        int row_len = seq_length * state_len;
+
+        // cumulative state frequencies and transition probabilities of every branch and category
+        DoubleVector freq(nstates);
+        model->getStateFrequency(freq.data());
+        for (int i = 1; i < nstates; i++)
+            freq[i] += freq[i-1];
+        DoubleVector cat_prop(ncat);
+        for (int c = 0; c < ncat; c++)
+            cat_prop[c] = site_rate->getProp(c) + (c ? cat_prop[c-1] : 0.0);
+        NodeVector nodes, dads;
+        Node *root = tree->findNodeID(0);
+        tree->getPreOrderBranches(nodes, dads, root);
+        size_t mat_size = nstates*nstates;
+        DoubleVector trans(nodes.size() * ncat * mat_size);
+        for (int i = 0; i < nodes.size(); i++) {
+            double len = nodes[i]->findNeighbor(dads[i])->length;
+            for (int c = 0; c < ncat; c++) {
+                double *mat = &trans[(i*ncat + c)*mat_size];
+                model->computeTransMatrix(len * site_rate->getRate(c), mat);
+                for (int row = 0; row < nstates; row++)
+                    for (int col = 1; col < nstates; col++)
+                        mat[row*nstates+col] += mat[row*nstates+col-1];
+            }
+        }
+        auto drawState = [&](double *cumul) {
+            double r = random_double(rstream) * cumul[nstates-1];
+            int state = 0;
+            while (state < nstates-1 && cumul[state] < r)
+                state++;
+            return state;
+        };
+
+        IntVector states(tree->nodeNum);
+        for (int site = 0; site < seq_length; site++) {
+            states[root->id] = drawState(freq.data());
+            if (random_double(rstream) < pinvar) {
+                for (int i = 0; i < nodes.size(); i++)
+                    states[nodes[i]->id] = states[root->id];
+            } else {
+                double r = random_double(rstream) * cat_prop[ncat-1];
+                int cat = 0;
+                while (cat < ncat-1 && cat_prop[cat] < r)
+                    cat++;
+                // parents come before their children in pre-order
+                for (int i = 0; i < nodes.size(); i++)
+                    states[nodes[i]->id] = drawState(&trans[(i*ncat + cat)*mat_size + states[dads[i]->id]*nstates]);
+            }
+            for (int seq = 0; seq < aln->getNSeq(); seq++) {
+                string chars = aln->convertStateBackStr(states[seq]);
+                memcpy(seqs + (size_t)seq*row_len + site*state_len, chars.c_str(), state_len);
+            }
+        }
+        finish_random(rstream);
+        output.value = row_len * aln->getNSeq();
+    } catch (const exception& e) {
+        output.errorStr = copyErrorStr(e);
+        if (rstream)
+            finish_random(rstream);
+        funcExit();
+    }
+    return output;
+}
+
+extern "C" void free_fit_result(FitResult& result) {
+    free(result.parents);
+    free(result.branch_lengths);
+    free(result.rates);
+    free(result.state_freqs);
+    result.parents = NULL;
+    result.branch_lengths = NULL;
+    result.rates = NULL;
+    result.state_freqs = NULL;
+}
+
+extern "C" void session_free(IQTreeSession* session) {
+    if (!session)
+        return;
+    if (session->tree) {
+        delete session->tree->getModelFactory();
+        session->tree->setModelFactory(NULL);
+        delete session->tree;
+    }
+    delete session->aln;
+    delete session->models_block;
+    delete session;
+}
+
 // --------------------------------------------------
 // Handle the input options of PiQTREE
 // --------------------------------------------------
@@ -63,6 +63,7 @@
 #include "utils/timeutil.h"
 #include "tree/upperbounds.h"
 #include "utils/MPIHelper.h"
+#include "utils/profiler.h"
 #include "timetree.h"
 #include <Eigen/Eigenvalues>
 #include <unsupported/Eigen/MatrixFunctions>
@@ -71,11 +72,8 @@ using namespace Eigen;
 using Eigen::Map;
 
 
-#ifdef USE_BOOSTER
-extern "C" {
-#include "booster/booster.h"
-}
-#endif
+#include "tree/transferbootstrap.h"
+#include "tree/splitcounter.h"
 
 #ifdef IQTREE_TERRAPHAST
     #include "terracetphast/terracetphast.h"
@@ -3587,6 +3585,8 @@ void runTreeReconstruction(Params &params, IQTree* &iqtree) {
     if (iqtree->getRate()->isHeterotachy() && !iqtree->isMixlen()) {
         ASSERT(0 && "Heterotachy tree not properly created");
     }
+    if (params.mpi_patterns)
+        iqtree->distributePatterns();
 //    iqtree.restoreCheckpoint();
 
     delete models_block;
@@ -3834,7 +3834,8 @@ void runTreeReconstruction(Params &params, IQTree* &iqtree) {
     NodeVector pruned_taxa;
     StrVector linked_name;
     double *saved_dist_mat = iqtree->dist_matrix;
-    double *pattern_lh = new double[iqtree->getAlnNPattern()];
+    // large enough for all partitions of a super tree and for the full alignment of --mpi-patterns
+    double *pattern_lh = new double[max(iqtree->getAlnNPattern(), iqtree->getFullAlignment()->getNPattern())];
     // prune stable taxa
     pruneTaxa(params, *iqtree, pattern_lh, pruned_taxa, linked_name);
 
@@ -3859,6 +3860,8 @@ void runTreeReconstruction(Params &params, IQTree* &iqtree) {
     }
     // restore pruned taxa
     restoreTaxa(*iqtree, saved_dist_mat, pruned_taxa, linked_name);
+    if (params.mpi_patterns)
+        iqtree->collectPatterns();
     double search_cpu_time = getCPUTime() - cputime_search_start;
     double search_real_time = getRealTime() - realtime_search_start;
 
@@ -3871,6 +3874,12 @@ void runTreeReconstruction(Params &params, IQTree* &iqtree) {
         return;
     }
 
+    if (params.mpi_patterns) {
+        // only the master reports, on the full alignment
+        iqtree->initializeAllPartialLh();
+        iqtree->clearAllPartialLH();
+    }
+
     if (params.snni && params.min_iterations && verbose_mode >= VB_MED) {
         cout << "Log-likelihoods of " << params.popSize << " best candidate trees: " << endl;
         iqtree->printBestScores();
@@ -4518,6 +4527,30 @@ void exhaustiveSearchGAMMAInvar(Params &params, IQTree &iqtree) {
 /**********************************************************
  * STANDARD NON-PARAMETRIC BOOTSTRAP
  ***********************************************************/
+void runTransferBootstrap(Params &params, const char *target_tree, const char *input_trees) {
+    cout << "Performing transfer bootstrap expectation..." << endl;
+    string out_tree = (string)params.out_prefix + ".tbe.tree";
+    string out_raw_tree = (string)params.out_prefix + ".tbe.rawtree";
+    string stat_out = (string)params.out_prefix + ".tbe.stat";
+    bool rooted = false;
+    MTree ref_tree(target_tree, rooted);
+    MTreeSet trees(input_trees, rooted, 0, INT_MAX);
+    TransferBootstrap tbe(&ref_tree);
+    tbe.compute_moved = params.transfer_bootstrap_stat;
+    tbe.addTrees(trees);
+    tbe.writeTree(out_tree.c_str());
+    cout << "TBE tree written to " << out_tree << endl;
+    if (params.transfer_bootstrap == 2) {
+        tbe.writeTree(out_raw_tree.c_str(), true);
+        cout << "TBE raw tree written to " << out_raw_tree << endl;
+    }
+    if (params.transfer_bootstrap_stat) {
+        tbe.writeStatistics(stat_out.c_str());
+        cout << "TBE statistic written to " << stat_out << endl;
+    }
+    cout << endl;
+}
+
 void runStandardBootstrap(Params &params, Alignment *alignment, IQTree *tree) {
     ModelCheckpoint *model_info = new ModelCheckpoint;
     StrVector removed_seqs, twin_seqs;
@@ -4752,25 +4785,11 @@ void runStandardBootstrap(Params &params, Alignment *alignment, IQTree *tree) {
     } else
         cout << endl;
 
-#ifdef USE_BOOSTER
-    if (params.transfer_bootstrap) {
-        // transfer bootstrap expectation (TBE)
-        cout << "Performing transfer bootstrap expectation..." << endl;
+    if (params.transfer_bootstrap && MPIHelper::getInstance().isMaster()) {
         string input_tree = (string)params.out_prefix + ".treefile";
         string boot_trees = (string)params.out_prefix + ".boottrees";
-        string out_tree = (string)params.out_prefix + ".tbe.tree";
-        string out_raw_tree = (string)params.out_prefix + ".tbe.rawtree";
-        string stat_out = (string)params.out_prefix + ".tbe.stat";
-        main_booster(input_tree.c_str(), boot_trees.c_str(), out_tree.c_str(),
-                     (params.transfer_bootstrap==2) ? out_raw_tree.c_str() : nullptr,
-                     stat_out.c_str(), (verbose_mode >= VB_MED) ? 0 : 1);
-        cout << "TBE tree written to " << out_tree << endl;
-        if (params.transfer_bootstrap == 2)
-            cout << "TBE raw tree written to " << out_raw_tree << endl;
-        cout << "TBE statistic written to " << stat_out << endl;
-        cout << endl;
+        runTransferBootstrap(params, input_tree.c_str(), boot_trees.c_str());
     }
-#endif
     
     if (MPIHelper::getInstance().isMaster()) {
         cout << "Total CPU time for " << RESAMPLE_NAME << ": " << (getCPUTime() - start_time) << " seconds." << endl;
@@ -5181,6 +5200,7 @@ void runPhyloAnalysis(Params &params, Checkpoint *checkpoint, IQTree *&tree, Ali
 {
     checkpoint->putBool("finished", false);
     checkpoint->setDumpInterval(params.checkpoint_dump_interval);
+    Profiler::enabled = params.profile;
 
     /****************** read in alignment **********************/
     if (params.partition_file) {
@@ -5215,6 +5235,8 @@ void runPhyloAnalysis(Params &params, Checkpoint *checkpoint, IQTree *&tree, Ali
         if (params.site_freq_file) {
             alignment->readSiteStateFreq(params.site_freq_file);
         }
+        if (!alignment->site_state_freq.empty())
+            alignment->mergeSiteStateFreq(params.site_freq_epsilon);
     }
 
     if (params.symtest) {
@@ -5383,6 +5405,13 @@ void runPhyloAnalysis(Params &params, Checkpoint *checkpoint, IQTree *&tree, Ali
 
     checkpoint->putBool("finished", true);
     checkpoint->dump(true);
+
+    if (params.profile && MPIHelper::getInstance().isMaster()) {
+        string profile_file = (string)params.out_prefix + ".profile.json";
+        Profiler::printSummary(cout);
+        Profiler::writeTrace(profile_file.c_str());
+        cout << "Profile of the run written to " << profile_file << endl;
+    }
 }
 
 void runPhyloAnalysis(Params &params, Checkpoint *checkpoint) {
@@ -6101,7 +6130,6 @@ void computeConsensusTree(const char *input_trees, int burnin, int max_count,
     if (params->scaling_factor > 0)
         scale = params->scaling_factor;
 
-    MTreeSet boot_trees;
     if (params && detectInputFile(input_trees) == IN_NEXUS) {
         char *user_file = params->user_file;
         params->user_file = (char*) input_trees;
@@ -6130,10 +6158,11 @@ void computeConsensusTree(const char *input_trees, int burnin, int max_count,
          }*/
         scale /= sg.maxWeight();
     } else {
-        boot_trees.init(input_trees, rooted, burnin, max_count,
-                tree_weight_file);
-        boot_trees.convertSplits(sg, cutoff, SW_COUNT, weight_threshold);
-        scale /= boot_trees.sumTreeWeights();
+        // count splits tree by tree, without loading all trees into memory
+        SplitCounter counter(rooted);
+        counter.countTrees(input_trees, burnin, max_count, tree_weight_file);
+        counter.convertSplits(sg, cutoff, weight_threshold);
+        scale /= counter.sumTreeWeights();
         cout << sg.size() << " splits found" << endl;
     }
     //sg.report(cout);
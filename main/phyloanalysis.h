@@ -79,6 +79,14 @@ void assignBootstrapSupport(const char *input_trees, int burnin, int max_count,
 	bool rooted, const char *output_tree, const char *out_prefix, MExtTree &mytree, 
 	const char* tree_weight_file, Params *params);
 
+/**
+	Compute the transfer bootstrap expectation (TBE) of the branches of target_tree
+	and write it to out_prefix.tbe.tree (and .tbe.rawtree, .tbe.stat if requested)
+	@param target_tree tree to assign support value
+	@param input_trees bootstrap trees
+*/
+void runTransferBootstrap(Params &params, const char *target_tree, const char *input_trees);
+
 /**
  * assign branch supports from params.user_tree trees file to params.second_tree
  * @param params program parameters
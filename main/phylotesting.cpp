@@ -42,6 +42,7 @@
 #include "phyloanalysis.h"
 #include "gsl/mygsl.h"
 #include "utils/MPIHelper.h"
+#include "utils/profiler.h"
 //#include "vectorclass/vectorclass.h"
 
 #if defined(_NN) || defined(_OLD_NN)
@@ -3358,6 +3359,7 @@ CandidateModel CandidateModelSet::evaluateAll(Params &params, PhyloTree* in_tree
                                     ModelsBlock *models_block, int num_threads, int brlen_type,
                                     string in_model_name, bool merge_phase, bool write_info)
 {
+    PROFILE_SCOPE("model testing");
     //ModelCheckpoint *checkpoint = &model_info;
 
     in_tree->params = &params;
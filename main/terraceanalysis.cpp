@@ -258,6 +258,13 @@ void run_generate_trees(Terrace *terrace, Params &params,const int m){
     
     
     init_terrace->trees_out_lim = params.terrace_print_lim;
+    if(params.terrace_count_only){
+        if(params.print_terrace_trees){
+            cout<<"WARNING: -g_count is ignored, because species-trees are written (-g_print).\n";
+        }else{
+            init_terrace->count_only = true;
+        }
+    }
     init_terrace->linkTrees(true, false); // branch_back_map, taxon_back_map; in this case you only want to map branches
 
     vector<Terrace*> part_tree_pairs;
@@ -306,17 +313,22 @@ void run_generate_trees(Terrace *terrace, Params &params,const int m){
     init_terrace->matrix->uniq_taxa_num = terrace->matrix->uniq_taxa_num;
     init_terrace->matrix->uniq_taxa_to_insert_num = terrace->matrix->uniq_taxa_to_insert_num;
     cout<<"\n"<<"Generating trees from a stand...."<<"\n";
+    if(params.num_threads > 1){
+        cout<<"Using "<<params.num_threads<<" threads\n";
+    }
     
     bool use_dynamic_taxon_order = true;
+    vector<string> ordered_taxa_to_insert;
+    // TAXON ORDER: Based on the number of allowed branches. The taxon order is dynamicly adapted using information about allowed branches
+    // Otherwise taxon order is fixed. Taxa inserted in order they appear in list_taxa_to_insert
     if(use_dynamic_taxon_order){
-        // TAXON ORDER: Based on the number of allowed branches.
-        vector<string> ordered_taxa_to_insert;
         ordered_taxa_to_insert = list_taxa_to_insert;
-        // The taxon order is dynamicly adapted using information about allowed branches
-        init_terrace->generateTerraceTrees(terrace, part_tree_pairs, list_taxa_to_insert, 0, &ordered_taxa_to_insert);
+    }
+    init_terrace->generation_start_time = getRealTime();
+    if(params.num_threads > 1 && list_taxa_to_insert.size() > 1){
+        init_terrace->generateTerraceTreesParallel(terrace, part_tree_pairs, list_taxa_to_insert, use_dynamic_taxon_order ? &ordered_taxa_to_insert : nullptr, params.num_threads);
     }else{
-        // Taxon order is fixed. Taxa inserted in order they appear in list_taxa_to_insert
-        init_terrace->generateTerraceTrees(terrace, part_tree_pairs, list_taxa_to_insert, 0, nullptr);
+        init_terrace->generateTerraceTrees(terrace, part_tree_pairs, list_taxa_to_insert, 0, use_dynamic_taxon_order ? &ordered_taxa_to_insert : nullptr);
     }
     cout<<"\n"<<"---------------------------------------------------------"<<"\n";
     cout<<"\n"<<"Done!"<<"\n"<<"\n";
@@ -18,6 +18,8 @@
 #include "tree/phylosuperhmm.h"
 #include "tree/iqtreemix.h"
 #include "tree/iqtreemixhmm.h"
+#include "tree/bootweights.h"
+#include "tree/splitfingerprint.h"
 #include "gsl/mygsl.h"
 #include "utils/timeutil.h"
 
@@ -479,7 +481,11 @@ void printSiteStateFreq(const char* filename, Alignment *aln) {
 }
 
 int countDistinctTrees(istream &in, bool rooted, IQTree *tree, IntVector &distinct_ids, bool exclude_duplicate) {
-    StringIntMap treels;
+    // trees are identified by a digest of their sorted split fingerprints
+    unordered_map<SplitFingerprint, int, SplitFingerprintHash> treels;
+    SplitFingerprinter *fingerprinter = nullptr;
+    int fingerprint_ntaxa = 0;
+    SplitFingerprintVector fps;
     int tree_id;
     for (tree_id = 0; !in.eof(); tree_id++) {
         if (exclude_duplicate) {
@@ -487,15 +493,20 @@ int countDistinctTrees(istream &in, bool rooted, IQTree *tree, IntVector &distin
             tree->readTree(in, rooted);
             tree->setAlignment(tree->aln);
             tree->setRootNode(tree->params->root);
-            StringIntMap::iterator it = treels.end();
-            ostringstream ostr;
-            tree->printTree(ostr, WT_TAXON_ID | WT_SORT_TAXA);
-            it = treels.find(ostr.str());
+            if (!fingerprinter || fingerprint_ntaxa != tree->leafNum) {
+                delete fingerprinter;
+                fingerprint_ntaxa = tree->leafNum;
+                fingerprinter = new SplitFingerprinter(fingerprint_ntaxa);
+            }
+            fingerprinter->computeFingerprints(tree, fps);
+            SplitFingerprinter::sortFingerprints(fps);
+            SplitFingerprint key = SplitFingerprinter::digest(fps);
+            auto it = treels.find(key);
             if (it != treels.end()) { // already in treels
                 distinct_ids.push_back(it->second);
             } else {
                 distinct_ids.push_back(-1);
-                treels[ostr.str()] = tree_id;
+                treels[key] = tree_id;
             }
         } else {
             // ignore tree
@@ -513,6 +524,7 @@ int countDistinctTrees(istream &in, bool rooted, IQTree *tree, IntVector &distin
         in.exceptions(ios::failbit | ios::badbit);
     }
     in.clear();
+    delete fingerprinter;
     if (exclude_duplicate)
         return treels.size();
     else
@@ -803,6 +815,66 @@ int mlecoef(double *cnts, double *rr, double bb, int kk,
 
 /* END CODE WAS TAKEN FROM CONSEL PROGRAM */
 
+/** number of bootstrap replicates generated and scored together in performAUTest */
+const size_t AU_BOOT_BLOCK = 256;
+
+/** maximum number of histogram bins per tree and scale in performAUTest */
+const size_t AU_HIST_BINS = 4096;
+
+/**
+    distribution of the AU statistic of one tree at one scale, as a histogram
+    of equal-width bins; values outside the range are counted in the first or last bin
+*/
+struct AUHistogram {
+    /** range of the statistic */
+    double lo, hi;
+
+    /** counts per bin */
+    uint32_t *counts;
+
+    /** number of bins and replicates */
+    size_t nbins, nboot;
+
+    /** @return bin of a value of the statistic */
+    size_t getBin(double t) {
+        if (hi <= lo)
+            return 0;
+        size_t bin = (size_t)((t - lo) / (hi - lo) * nbins);
+        return min(bin, nbins-1);
+    }
+
+    /**
+        number of replicates below t, linear within a bin;
+        replaces cntdist3() on the sorted replicates
+    */
+    double countBelow(double t) {
+        if (t < lo)
+            return 0.0;
+        if (t >= hi)
+            return nboot;
+        double width = (hi - lo) / nbins;
+        size_t bin = getBin(t);
+        double cnt = 0.0;
+        for (size_t i = 0; i < bin; i++)
+            cnt += counts[i];
+        return cnt + counts[bin] * min(1.0, (t - lo - bin*width) / width);
+    }
+
+    /** @return the value below which cnt replicates are */
+    double getQuantile(double cnt) {
+        if (hi <= lo)
+            return lo;
+        double width = (hi - lo) / nbins;
+        double sum = 0.0;
+        for (size_t i = 0; i < nbins; i++) {
+            if (counts[i] > 0 && sum + counts[i] >= cnt)
+                return lo + width * (i + (cnt - sum) / counts[i]);
+            sum += counts[i];
+        }
+        return hi;
+    }
+};
+
 /**
  @param tree_lhs RELL score matrix of size #trees x #replicates
  */
@@ -812,7 +884,7 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
         outWarning("Too few replicates for AU test. At least -zb 10000 for reliable results!");
     
     /* STEP 1: specify scale factors */
-    size_t nscales = 10;
+    const size_t nscales = 10;
     double r[] = {0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.1, 1.2, 1.3, 1.4};
     double rr[] = {sqrt(0.5), sqrt(0.6), sqrt(0.7), sqrt(0.8), sqrt(0.9), 1.0,
         sqrt(1.1), sqrt(1.2), sqrt(1.3), sqrt(1.4)};
@@ -827,123 +899,133 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
     size_t nptn = tree->getAlnNPattern();
     size_t maxnptn = get_safe_upper_limit(nptn);
     
-    //    double *bp = new double[ntrees*nscales];
-    //    memset(bp, 0, sizeof(double)*ntrees*nscales);
-    
-    double *treelhs;
-    cout << (ntrees*nscales*nboot*sizeof(double) >> 20) << " MB required for AU test" << endl;
-    treelhs = new double[ntrees*nscales*nboot];
-    if (!treelhs)
-        outError("Not enough memory to perform AU test!");
+    // instead of all sorted statistics, only a histogram per tree and scale is kept
+    size_t nbins = min(nboot, AU_HIST_BINS);
+    vector<AUHistogram> hists(ntrees*nscales);
+    vector<uint32_t> hist_counts(ntrees*nscales*nbins, 0);
+    for (size_t item = 0; item < hists.size(); item++) {
+        hists[item].lo = DBL_MAX;
+        hists[item].hi = -DBL_MAX;
+        hists[item].counts = &hist_counts[item*nbins];
+        hists[item].nbins = nbins;
+        hists[item].nboot = nboot;
+    }
     
-    size_t k, tid, ptn;
+    size_t k, tid;
     
     double start_time = getRealTime();
     
     cout << "Generating " << nscales << " x " << nboot << " multiscale bootstrap replicates... ";
     
+    // work is split into blocks of replicates of one scale, each with its own random stream,
+    // so that the result does not depend on the number of threads.
+    // The first block of every scale is a pilot run, whose range of the statistic, widened
+    // on both sides by its width, sets the bins of each tree and scale for all blocks
+    size_t nblocks = (nboot + AU_BOOT_BLOCK - 1) / AU_BOOT_BLOCK;
+    for (int pass = 0; pass < 2; pass++) {
+    size_t nitems = (pass == 0) ? nscales : nscales*nblocks;
 #ifdef _OPENMP
-#pragma omp parallel private(k, tid, ptn)
-    {
-    int *rstream;
-    init_random(params.ran_seed + omp_get_thread_num(), false, &rstream);
-#else
-    int *rstream = randstream;
+#pragma omp parallel
 #endif
-    size_t boot;
-    int *boot_sample = aligned_alloc<int>(maxnptn);
-    memset(boot_sample, 0, maxnptn*sizeof(int));
-    
-    double *boot_sample_dbl = aligned_alloc<double>(maxnptn);
-    
+    {
+    BootWeightMatrix boot_weights;
+    boot_weights.init(AU_BOOT_BLOCK, nptn);
+    IntVector boot_sample(maxnptn, 0);
+    DoubleVector block_lh(AU_BOOT_BLOCK*ntrees);
+    DoubleVector stat_min, stat_max;
+    if (pass == 0) {
+        stat_min.resize(hists.size(), DBL_MAX);
+        stat_max.resize(hists.size(), -DBL_MAX);
+    }
+
 #ifdef _OPENMP
 #pragma omp for schedule(dynamic)
 #endif
-    for (int k = 0; k < nscales; ++k) {
+    for (size_t i = 0; i < nitems; i++) {
+        size_t item = (pass == 0) ? i*nblocks : i;
+        size_t k = item / nblocks;
+        size_t boot_start = (item % nblocks) * AU_BOOT_BLOCK;
+        size_t boot_end = min(boot_start + AU_BOOT_BLOCK, nboot);
         string str = "SCALE=" + convertDoubleToString(r[k]);
-        for (boot = 0; boot < nboot; boot++) {
+        int *rstream;
+        init_random(params.ran_seed + item, false, &rstream);
+        for (size_t boot = boot_start; boot < boot_end; boot++) {
             if (r[k] == 1.0 && boot == 0)
                 // 2018-10-23: get one of the bootstrap sample as the original alignment
-                tree->aln->getPatternFreq(boot_sample);
+                tree->aln->getPatternFreq(boot_sample.data());
             else
-                tree->aln->createBootstrapAlignment(boot_sample, str.c_str(), rstream);
-            for (ptn = 0; ptn < maxnptn; ptn++)
-                boot_sample_dbl[ptn] = boot_sample[ptn];
+                tree->aln->createBootstrapAlignment(boot_sample.data(), str.c_str(), rstream);
+            boot_weights.setSample(boot - boot_start, boot_sample);
+        }
+        finish_random(rstream);
+
+        // RELL scores of all trees for all replicates of this block
+        boot_weights.computeRELL(pattern_lhs, ntrees, maxnptn, 0, boot_end - boot_start, block_lh.data());
+
+        for (size_t boot = boot_start; boot < boot_end; boot++) {
+            double *tree_lh = &block_lh[(boot - boot_start)*ntrees];
             double max_lh = -DBL_MAX, second_max_lh = -DBL_MAX;
-            int max_tid = -1;
-            for (tid = 0; tid < ntrees; tid++) {
-                double *pattern_lh = pattern_lhs + (tid*maxnptn);
-                double tree_lh;
-                if (params.SSE == LK_386) {
-                    tree_lh = 0.0;
-                    for (ptn = 0; ptn < nptn; ptn++)
-                        tree_lh += pattern_lh[ptn] * boot_sample_dbl[ptn];
-                } else {
-                    tree_lh = tree->dotProductDoubleCall(pattern_lh, boot_sample_dbl, nptn);
-                }
+            size_t max_tid = ntrees;
+            for (size_t tid = 0; tid < ntrees; tid++) {
                 // rescale lh
-                tree_lh /= r[k];
-                
+                tree_lh[tid] /= r[k];
                 // find the max and second max
-                if (tree_lh > max_lh) {
+                if (tree_lh[tid] > max_lh) {
                     second_max_lh = max_lh;
-                    max_lh = tree_lh;
+                    max_lh = tree_lh[tid];
                     max_tid = tid;
-                } else if (tree_lh > second_max_lh)
-                    second_max_lh = tree_lh;
-                
-                treelhs[(tid*nscales+k)*nboot + boot] = tree_lh;
+                } else if (tree_lh[tid] > second_max_lh)
+                    second_max_lh = tree_lh[tid];
+            }
+            for (size_t tid = 0; tid < ntrees; tid++) {
+                // difference from max_lh
+                double stat = (tid != max_tid) ? max_lh - tree_lh[tid] : second_max_lh - max_lh;
+                size_t hist = tid*nscales+k;
+                if (pass == 0) {
+                    stat_min[hist] = min(stat_min[hist], stat);
+                    stat_max[hist] = max(stat_max[hist], stat);
+                } else {
+                    uint32_t &count = hists[hist].counts[hists[hist].getBin(stat)];
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+                    count++;
+                }
             }
-            
-            // compute difference from max_lh
-            for (tid = 0; tid < ntrees; tid++)
-                if (tid != max_tid)
-                    treelhs[(tid*nscales+k)*nboot + boot] = max_lh - treelhs[(tid*nscales+k)*nboot + boot];
-                else
-                    treelhs[(tid*nscales+k)*nboot + boot] = second_max_lh - max_lh;
-            //            bp[k*ntrees+max_tid] += nboot_inv;
         } // for boot
-        
-        // sort the replicates
-        for (tid = 0; tid < ntrees; tid++) {
-            quicksort<double,int>(treelhs + (tid*nscales+k)*nboot, 0, nboot-1);
-        }
-        
-    } // for scale
-    
-    aligned_free(boot_sample_dbl);
-    aligned_free(boot_sample);
-    
+    } // for item
+    if (pass == 0) {
+        // minimum and maximum do not depend on the order of the threads
 #ifdef _OPENMP
-    finish_random(rstream);
-    }
+#pragma omp critical(au_range)
 #endif
-    
-    //    if (verbose_mode >= VB_MED) {
-    //        cout << "scale";
-    //        for (k = 0; k < nscales; k++)
-    //            cout << "\t" << r[k];
-    //        cout << endl;
-    //        for (tid = 0; tid < ntrees; tid++) {
-    //            cout << tid;
-    //            for (k = 0; k < nscales; k++) {
-    //                cout << "\t" << bp[tid+k*ntrees];
-    //            }
-    //            cout << endl;
-    //        }
-    //    }
+        for (size_t hist = 0; hist < hists.size(); hist++) {
+            hists[hist].lo = min(hists[hist].lo, stat_min[hist]);
+            hists[hist].hi = max(hists[hist].hi, stat_max[hist]);
+        }
+    }
+    } // omp parallel
+    if (pass == 0)
+        for (auto &hist : hists) {
+            double width = max(hist.hi - hist.lo, 1.0);
+            hist.lo -= width;
+            hist.hi += width;
+        }
+    } // for pass
     
     cout << getRealTime() - start_time << " seconds" << endl;
     
     /* STEP 3: weighted least square fit */
     
-    double *cc = new double[nscales];
-    double *w = new double[nscales];
-    double *this_bp = new double[nscales];
-    cout << "TreeID\tAU\tRSS\td\tc" << endl;
-    for (tid = 0; tid < ntrees; tid++) {
-        double *this_stat = treelhs + tid*nscales*nboot;
-        double xn = this_stat[(nscales/2)*nboot + nboot/2], x;
+    DoubleVector au_rss(ntrees), au_d(ntrees), au_c(ntrees), au_pchi2(ntrees);
+    // trees are fitted independently; the fitting trace is only printed in serial mode
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) private(k) if(verbose_mode < VB_MED)
+#endif
+    for (size_t tid = 0; tid < ntrees; tid++) {
+        double cc[nscales], w[nscales], this_bp[nscales];
+        AUHistogram *this_hist = &hists[tid*nscales];
+        double xn = this_hist[nscales/2].getQuantile(0.5*nboot), x;
         double c, d; // c, d in original paper
         int idf0 = -2;
         double z = 0.0, z0 = 0.0, thp = 0.0, th = 0.0, ze = 0.0, ze0 = 0.0;
@@ -957,7 +1039,7 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
             x = xn;
             int num_k = 0;
             for (k = 0; k < nscales; k++) {
-                this_bp[k] = cntdist3(this_stat + k*nboot, nboot, x) / nboot;
+                this_bp[k] = this_hist[k].countBelow(x) / nboot;
                 if (this_bp[k] <= 0 || this_bp[k] >= 1) {
                     cc[k] = w[k] = 0.0;
                 } else {
@@ -1057,24 +1139,164 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
             failed = true;
         }
         
-        double pchi2 = (failed) ? 0.0 : computePValueChiSquare(rss, df);
-        cout << tid+1 << "\t" << info[tid].au_pvalue << "\t" << rss << "\t" << d << "\t" << c;
+        au_pchi2[tid] = (failed) ? 0.0 : computePValueChiSquare(rss, df);
+        au_rss[tid] = rss;
+        au_d[tid] = d;
+        au_c[tid] = c;
+    }
+    
+    cout << "TreeID\tAU\tRSS\td\tc" << endl;
+    for (tid = 0; tid < ntrees; tid++) {
+        cout << tid+1 << "\t" << info[tid].au_pvalue << "\t" << au_rss[tid] << "\t" << au_d[tid] << "\t" << au_c[tid];
         
         // warning if p-value of chi-square < 0.01 (rss too high)
-        if (pchi2 < 0.01)
+        if (au_pchi2[tid] < 0.01)
             cout << " !!!";
         cout << endl;
     }
     
-    delete [] this_bp;
-    delete [] w;
-    delete [] cc;
-    
     cout << "Time for AU test: " << getRealTime() - start_time << " seconds" << endl;
     //    delete [] bp;
 }
 
 
+/** number of trees per thread read ahead and evaluated together with --test-parallel */
+const size_t EVAL_TREES_PER_THREAD = 4;
+
+/**
+    create a tree for concurrent evaluation of user trees, which shares
+    alignment, model and rate heterogeneity of the main tree
+    @param params program parameters
+    @param tree main tree
+    @return new tree, to be released with deleteSharedModelTree()
+ */
+PhyloTree *newSharedModelTree(Params &params, PhyloTree *tree) {
+    PhyloTree *eval_tree = new PhyloTree(tree->aln);
+    eval_tree->setParams(&params);
+    eval_tree->optimize_by_newton = params.optimize_by_newton;
+    eval_tree->setLikelihoodKernel(params.SSE);
+    eval_tree->setNumThreads(1);
+    eval_tree->rooted = tree->rooted;
+    // model parameters are not re-optimized, so the model does not need to know this tree
+    eval_tree->setModelFactory(tree->getModelFactory());
+    eval_tree->setModel(tree->getModel());
+    eval_tree->setRate(tree->getRate());
+    return eval_tree;
+}
+
+/** release a tree created by newSharedModelTree() without deleting the shared model */
+void deleteSharedModelTree(PhyloTree *eval_tree) {
+    eval_tree->setModelFactory(nullptr);
+    eval_tree->setModel(nullptr);
+    eval_tree->setRate(nullptr);
+    delete eval_tree;
+}
+
+/**
+    read the next batch of distinct user trees
+    @param in input stream positioned at tree tree_index
+    @param distinct_ids ID of identical tree, or -1 if tree is distinct
+    @param tree_index index of the first tree to read
+    @param batch_size maximal number of distinct trees to read
+    @param[out] batch_trees NEWICK strings of distinct trees
+    @return index of the tree following the batch
+ */
+int readTreeBatch(istream &in, IntVector &distinct_ids, int tree_index, size_t batch_size, StrVector &batch_trees) {
+    batch_trees.clear();
+    for (; tree_index < distinct_ids.size() && batch_trees.size() < batch_size; tree_index++) {
+        string tree_str;
+        char ch;
+        while (in.get(ch) && ch != ';')
+            tree_str += ch;
+        tree_str += ';';
+        if (distinct_ids[tree_index] < 0)
+            batch_trees.push_back(tree_str);
+    }
+    return tree_index;
+}
+
+/**
+    optimize branch lengths of a batch of trees concurrently, one tree per thread
+    @param params program parameters
+    @param eval_trees one tree per thread from newSharedModelTree()
+    @param[in,out] batch_trees input trees, replaced by trees with optimized branch lengths
+    @param[out] batch_logl tree log-likelihoods
+    @param[out] batch_ptnlh pattern log-likelihoods, one row of lh_stride per tree
+    @param lh_stride distance between rows of batch_ptnlh
+ */
+void evaluateTreeBatch(Params &params, vector<PhyloTree*> &eval_trees, StrVector &batch_trees,
+                       DoubleVector &batch_logl, double *batch_ptnlh, size_t lh_stride)
+{
+    batch_logl.resize(batch_trees.size());
+    memset(batch_ptnlh, 0, batch_trees.size()*lh_stride*sizeof(double));
+    // outError() must not be called by the worker threads: the syntax is checked here,
+    // the other errors are collected and reported after the parallel loop
+    for (size_t i = 0; i < batch_trees.size(); i++) {
+        MTree check_tree;
+        stringstream in(batch_trees[i]);
+        bool rooted = eval_trees[0]->rooted;
+        check_tree.readTree(in, rooted);
+    }
+    StrVector errors(batch_trees.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (size_t i = 0; i < batch_trees.size(); i++) {
+#ifdef _OPENMP
+        PhyloTree *eval_tree = eval_trees[omp_get_thread_num()];
+#else
+        PhyloTree *eval_tree = eval_trees[0];
+#endif
+        stringstream in(batch_trees[i]);
+        eval_tree->freeNode();
+        eval_tree->readTree(in, eval_tree->rooted);
+        if (!eval_tree->findNodeName(eval_tree->aln->getSeqName(0))) {
+            errors[i] = "Taxon " + eval_tree->aln->getSeqName(0) + " not found in tree";
+            continue;
+        }
+        if (eval_tree->rooted && eval_tree->getModelFactory()->isReversible()) {
+            if (eval_tree->leafNum != eval_tree->aln->getNSeq()+1) {
+                errors[i] = "Tree does not have same number of taxa as alignment";
+                continue;
+            }
+            eval_tree->convertToUnrooted();
+        } else if (!eval_tree->rooted && !eval_tree->getModelFactory()->isReversible()) {
+            if (eval_tree->leafNum != eval_tree->aln->getNSeq()) {
+                errors[i] = "Tree does not have same number of taxa as alignment";
+                continue;
+            }
+            eval_tree->convertToRooted();
+        }
+        // setAlignment() stops if a sequence is missing
+        map<string, Node*> taxa;
+        eval_tree->getMapOfTaxonNameToNode(nullptr, nullptr, taxa);
+        for (size_t seq = 0; seq < eval_tree->aln->getNSeq() && errors[i].empty(); seq++)
+            if (taxa.find(eval_tree->aln->getSeqName(seq)) == taxa.end())
+                errors[i] = "Alignment sequence " + eval_tree->aln->getSeqName(seq) + " does not appear in the tree";
+        if (!errors[i].empty())
+            continue;
+        eval_tree->setAlignment(eval_tree->aln);
+        eval_tree->setRootNode(params.root);
+        eval_tree->initializeAllPartialLh();
+        eval_tree->fixNegativeBranch(false);
+        if (params.fixed_branch_length) {
+            eval_tree->setCurScore(eval_tree->computeLikelihood());
+        } else {
+            eval_tree->setCurScore(eval_tree->optimizeAllBranches(100, 0.001));
+        }
+        double logl = eval_tree->getCurScore();
+        eval_tree->computePatternLikelihood(batch_ptnlh + i*lh_stride, &logl);
+        batch_logl[i] = logl;
+        ostringstream out;
+        eval_tree->printTree(out);
+        batch_trees[i] = out.str();
+    }
+    // the first error in the order of the trees
+    for (auto &error : errors)
+        if (!error.empty())
+            outError(error);
+}
+
 void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &info, IntVector &distinct_ids)
 {
     cout << endl;
@@ -1123,7 +1345,7 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
     
     double time_start = getRealTime();
     
-    int *boot_samples = nullptr;
+    BootWeightMatrix boot_samples;
     //double *saved_tree_lhs = nullptr;
     double *tree_lhs = nullptr; // RELL score matrix of size #trees x #replicates
     double *pattern_lh = nullptr;
@@ -1135,7 +1357,7 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
     size_t maxnptn = get_safe_upper_limit(nptn);
     
     if (params.topotest_replicates && ntrees > 1) {
-        size_t mem_size = (size_t)params.topotest_replicates*nptn*sizeof(int) +
+        size_t mem_size = (size_t)params.topotest_replicates*nptn*sizeof(uint8_t) +
         ntrees*params.topotest_replicates*sizeof(double) +
         (nptn + ntrees*3 + params.topotest_replicates*2)*sizeof(double) +
         ntrees*sizeof(TreeInfo) +
@@ -1144,22 +1366,26 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
         if (mem_size > getMemorySize()-100000)
             outWarning("The required memory does not fit in RAM!");
         cout << "Creating " << params.topotest_replicates << " bootstrap replicates..." << endl;
-        if (!(boot_samples = new int [params.topotest_replicates*nptn]))
-            outError(ERR_NO_MEMORY);
+        boot_samples.init(params.topotest_replicates, nptn);
 #ifdef _OPENMP
 #pragma omp parallel if(nptn > 10000)
         {
         int *rstream;
         init_random(params.ran_seed + omp_get_thread_num(), false, &rstream);
-#pragma omp for schedule(static)
 #else
         int *rstream = randstream;
 #endif
-        for (size_t boot = 0; boot < params.topotest_replicates; boot++)
+        IntVector boot_sample(maxnptn, 0);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (size_t boot = 0; boot < params.topotest_replicates; boot++) {
             if (boot == 0)
-                tree->aln->getPatternFreq(boot_samples + (boot*nptn));
+                tree->aln->getPatternFreq(boot_sample.data());
             else
-                tree->aln->createBootstrapAlignment(boot_samples + (boot*nptn), params.bootstrap_spec, rstream);
+                tree->aln->createBootstrapAlignment(boot_sample.data(), params.bootstrap_spec, rstream);
+            boot_samples.setSample(boot, boot_sample);
+        }
 #ifdef _OPENMP
         finish_random(rstream);
         }
@@ -1184,6 +1410,32 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
         if (!(max_lh = new double[params.topotest_replicates]))
             outError(ERR_NO_MEMORY);
     }
+    // concurrent evaluation of trees, each thread with its own tree sharing the model
+    bool parallel_eval = params.topotest_parallel;
+    if (parallel_eval && (params.topotest_optimize_model || tree->isSuperTree() || tree->isTreeMix() ||
+                          tree->isMixlen() || tree->isHMM() || params.print_partition_lh)) {
+        outWarning("--test-parallel is not supported with this model or option, trees are evaluated one by one");
+        parallel_eval = false;
+    }
+    vector<PhyloTree*> eval_trees;
+    StrVector batch_trees;
+    DoubleVector batch_logl;
+    double *batch_ptnlh = nullptr;
+    size_t batch_size = 0, batch_pos = 0;
+    int batch_end = 0;
+    if (parallel_eval) {
+#ifdef _OPENMP
+        int num_eval_threads = omp_get_max_threads();
+#else
+        int num_eval_threads = 1;
+#endif
+        cout << "Evaluating trees concurrently with " << num_eval_threads << " threads" << endl;
+        for (int i = 0; i < num_eval_threads; i++)
+            eval_trees.push_back(newSharedModelTree(params, tree));
+        batch_size = EVAL_TREES_PER_THREAD * num_eval_threads;
+        batch_ptnlh = aligned_alloc<double>(batch_size*maxnptn);
+    }
+
     int tree_index, tid, tid2;
     info.resize(ntrees);
     string saved_tree;
@@ -1194,6 +1446,8 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
         cout << "Tree " << tree_index + 1;
         if (distinct_ids[tree_index] >= 0) {
             cout << " / identical to tree " << distinct_ids[tree_index]+1 << endl;
+            if (parallel_eval)
+                continue; // already consumed by readTreeBatch()
             // ignore tree
             char ch;
             do {
@@ -1201,60 +1455,87 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
             } while (!in.eof() && ch != ';');
             continue;
         }
-        tree->freeNode();
-        tree->readTree(in, tree->rooted);
-        if (!tree->findNodeName(tree->aln->getSeqName(0))) {
-            outError("Taxon " + tree->aln->getSeqName(0) + " not found in tree");
-        }
+        if (parallel_eval) {
+            if (tree_index >= batch_end) {
+                batch_end = readTreeBatch(in, distinct_ids, tree_index, batch_size, batch_trees);
+                evaluateTreeBatch(params, eval_trees, batch_trees, batch_logl, batch_ptnlh, maxnptn);
+                batch_pos = 0;
+            }
+            double *tree_ptnlh = batch_ptnlh + batch_pos*maxnptn;
+            tree->setCurScore(batch_logl[batch_pos]);
+            treeout << "[ tree " << tree_index+1 << " lh=" << tree->getCurScore() << " ]";
+            treeout << batch_trees[batch_pos] << endl;
+            if (params.print_tree_lh)
+                scoreout << tree->getCurScore() << endl;
+            
+            cout << " / LogL: " << tree->getCurScore() << endl;
+            
+            if (pattern_lh) {
+                memcpy(pattern_lh, tree_ptnlh, maxnptn*sizeof(double));
+                if (params.do_weighted_test || params.do_au_test)
+                    memcpy(pattern_lhs + tid*maxnptn, pattern_lh, maxnptn*sizeof(double));
+            }
+            if (params.print_site_lh) {
+                string tree_name = "Tree" + convertIntToString(tree_index+1);
+                printSiteLh(site_lh_file.c_str(), tree, tree_ptnlh, true, tree_name.c_str());
+            }
+            batch_pos++;
+        } else {
+            tree->freeNode();
+            tree->readTree(in, tree->rooted);
+            if (!tree->findNodeName(tree->aln->getSeqName(0))) {
+                outError("Taxon " + tree->aln->getSeqName(0) + " not found in tree");
+            }
         
-        if (tree->rooted && tree->getModelFactory()->isReversible()) {
-            if (tree->leafNum != tree->aln->getNSeq()+1)
-                outError("Tree does not have same number of taxa as alignment");
-            tree->convertToUnrooted();
+            if (tree->rooted && tree->getModelFactory()->isReversible()) {
+                if (tree->leafNum != tree->aln->getNSeq()+1)
+                    outError("Tree does not have same number of taxa as alignment");
+                tree->convertToUnrooted();
 //            cout << "convertToUnrooted" << endl;
-        } else if (!tree->rooted && !tree->getModelFactory()->isReversible()) {
-            if (tree->leafNum != tree->aln->getNSeq())
-                outError("Tree does not have same number of taxa as alignment");
-            tree->convertToRooted();
+            } else if (!tree->rooted && !tree->getModelFactory()->isReversible()) {
+                if (tree->leafNum != tree->aln->getNSeq())
+                    outError("Tree does not have same number of taxa as alignment");
+                tree->convertToRooted();
 //            cout << "convertToRooted" << endl;
-        }
-        tree->setAlignment(tree->aln);
-        tree->setRootNode(params.root);
-        if (tree->isSuperTree())
-            ((PhyloSuperTree*) tree)->mapTrees();
+            }
+            tree->setAlignment(tree->aln);
+            tree->setRootNode(params.root);
+            if (tree->isSuperTree())
+                ((PhyloSuperTree*) tree)->mapTrees();
         
-        tree->initializeAllPartialLh();
-        tree->fixNegativeBranch(false);
-        if (params.fixed_branch_length) {
-            tree->setCurScore(tree->computeLikelihood());
-        } else if (params.topotest_optimize_model) {
-            tree->getModelFactory()->optimizeParameters(BRLEN_OPTIMIZE, false, params.modelEps);
-            tree->setCurScore(tree->computeLikelihood());
-        } else {
-            tree->setCurScore(tree->optimizeAllBranches(100, 0.001));
-        }
-        treeout << "[ tree " << tree_index+1 << " lh=" << tree->getCurScore() << " ]";
-        tree->printTree(treeout);
-        treeout << endl;
-        if (params.print_tree_lh)
-            scoreout << tree->getCurScore() << endl;
+            tree->initializeAllPartialLh();
+            tree->fixNegativeBranch(false);
+            if (params.fixed_branch_length) {
+                tree->setCurScore(tree->computeLikelihood());
+            } else if (params.topotest_optimize_model) {
+                tree->getModelFactory()->optimizeParameters(BRLEN_OPTIMIZE, false, params.modelEps);
+                tree->setCurScore(tree->computeLikelihood());
+            } else {
+                tree->setCurScore(tree->optimizeAllBranches(100, 0.001));
+            }
+            treeout << "[ tree " << tree_index+1 << " lh=" << tree->getCurScore() << " ]";
+            tree->printTree(treeout);
+            treeout << endl;
+            if (params.print_tree_lh)
+                scoreout << tree->getCurScore() << endl;
         
-        cout << " / LogL: " << tree->getCurScore() << endl;
+            cout << " / LogL: " << tree->getCurScore() << endl;
         
-        if (pattern_lh) {
-            double curScore = tree->getCurScore();
-            memset(pattern_lh, 0, maxnptn*sizeof(double));
-            tree->computePatternLikelihood(pattern_lh, &curScore);
-            if (params.do_weighted_test || params.do_au_test)
-                memcpy(pattern_lhs + tid*maxnptn, pattern_lh, maxnptn*sizeof(double));
-        }
-        if (params.print_site_lh) {
-            string tree_name = "Tree" + convertIntToString(tree_index+1);
-            printSiteLh(site_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
-        }
-        if (params.print_partition_lh) {
-            string tree_name = "Tree" + convertIntToString(tree_index+1);
-            printPartitionLh(part_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
+            if (pattern_lh) {
+                double curScore = tree->getCurScore();
+                memset(pattern_lh, 0, maxnptn*sizeof(double));
+                tree->computePatternLikelihood(pattern_lh, &curScore);
+                if (params.do_weighted_test || params.do_au_test)
+                    memcpy(pattern_lhs + tid*maxnptn, pattern_lh, maxnptn*sizeof(double));
+            }
+            if (params.print_site_lh) {
+                string tree_name = "Tree" + convertIntToString(tree_index+1);
+                printSiteLh(site_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
+            }
+            if (params.print_partition_lh) {
+                string tree_name = "Tree" + convertIntToString(tree_index+1);
+                printPartitionLh(part_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
+            }
         }
         info[tid].logl = tree->getCurScore();
         
@@ -1265,18 +1546,16 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
         // now compute RELL scores
         orig_tree_lh[tid] = tree->getCurScore();
         double *tree_lhs_offset = tree_lhs + (tid*params.topotest_replicates);
-        for (size_t boot = 0; boot < params.topotest_replicates; boot++) {
-            double lh = 0.0;
-            int *this_boot_sample = boot_samples + (boot*nptn);
-            for (size_t ptn = 0; ptn < nptn; ptn++)
-                lh += pattern_lh[ptn] * this_boot_sample[ptn];
-            tree_lhs_offset[boot] = lh;
-        }
+        boot_samples.computeRELL(pattern_lh, 1, maxnptn, 0, params.topotest_replicates, tree_lhs_offset);
         tid++;
     }
     
     ASSERT(tid == ntrees);
     
+    for (auto eval_tree : eval_trees)
+        deleteSharedModelTree(eval_tree);
+    aligned_free(batch_ptnlh);
+    
     if (params.topotest_replicates && ntrees > 1) {
         double *tree_probs = new double[ntrees];
         memset(tree_probs, 0, ntrees*sizeof(double));
@@ -1499,7 +1778,6 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
     aligned_free(pattern_lhs);
     delete [] lhdiff_weights;
     delete [] tree_lhs;
-    delete [] boot_samples;
     
     if (params.print_tree_lh) {
         scoreout.close();
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by BUI Quang Minh   *
+ *   minh.bui@univie.ac.at   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "jointoptimizer.h"
+#include "modelfactory.h"
+#include "modelmarkov.h"
+#include "tree/phylotree.h"
+
+/** step of the forward differences for model and rate parameters */
+const double JOINT_ERROR_X = 1.0e-4;
+
+/**
+    minimum improvement of one L-BFGS-B iteration as a fraction of logl_epsilon;
+    the steps are much smaller than a round of the alternating scheme
+*/
+const double JOINT_FTOL_FRACTION = 0.01;
+
+JointOptimizer::JointOptimizer(ModelFactory *model_factory, PhyloTree *tree) {
+    this->model_factory = model_factory;
+    this->tree = tree;
+    num_traversals = 0;
+    num_gradients = 0;
+    NodeVector all_nodes, all_nodes2;
+    tree->computeBestTraversal(all_nodes, all_nodes2);
+    for (int i = 0; i < all_nodes.size(); i++) {
+        // the virtual branch to the root of a rooted tree is not optimized
+        if (tree->rooted && (all_nodes[i] == tree->root || all_nodes2[i] == tree->root))
+            continue;
+        nodes.push_back(all_nodes[i]);
+        nodes2.push_back(all_nodes2[i]);
+    }
+    nparam = model_factory->getNDim();
+}
+
+int JointOptimizer::getNDim() {
+    return nodes.size() + nparam;
+}
+
+void JointOptimizer::setBranchLengths(double x[]) {
+    for (int i = 0; i < nodes.size(); i++) {
+        nodes[i]->findNeighbor(nodes2[i])->length = x[i+1];
+        nodes2[i]->findNeighbor(nodes[i])->length = x[i+1];
+    }
+}
+
+double JointOptimizer::targetFunk(double x[]) {
+    setBranchLengths(x);
+    num_traversals++;
+    if (nparam > 0) {
+        double *param = x + nodes.size();
+        if (last_param.empty() || !equal(param+1, param+1+nparam, last_param.begin())) {
+            // new rate matrix or rates, computes the likelihood from scratch
+            last_param.assign(param+1, param+1+nparam);
+            return model_factory->targetFunk(param);
+        }
+    }
+    tree->clearAllPartialLH();
+    return -tree->computeLikelihood();
+}
+
+double JointOptimizer::derivativeFunk(double x[], double dfx[]) {
+    double fx = targetFunk(x);
+    num_gradients++;
+    int nbranch = nodes.size();
+
+    // analytic derivatives of branch lengths, in pre-order to reuse the partial likelihoods
+    for (int i = 0; i < nbranch; i++) {
+        PhyloNeighbor *nei = (PhyloNeighbor*)nodes[i]->findNeighbor(nodes2[i]);
+        double df, ddf;
+        tree->theta_computed = false;
+        tree->computeLikelihoodDerv(nei, (PhyloNode*)nodes[i], &df, &ddf);
+        dfx[i+1] = -df;
+    }
+
+    // forward differences of model and rate parameters, backward at the upper bound
+    for (int dim = nbranch+1; dim <= nbranch+nparam; dim++) {
+        double temp = x[dim];
+        double h = JOINT_ERROR_X * fabs(temp);
+        if (h == 0.0)
+            h = JOINT_ERROR_X;
+        if (temp + h > upper_bound[dim])
+            h = -h;
+        x[dim] = temp + h;
+        h = x[dim] - temp;
+        dfx[dim] = (targetFunk(x) - fx) / h;
+        x[dim] = temp;
+    }
+    return fx;
+}
+
+double JointOptimizer::optimize(double logl_epsilon, int max_iterations) {
+    int nbranch = nodes.size();
+    int ndim = getNDim();
+    DoubleVector variables(ndim+1), lower(ndim+1);
+    upper_bound.resize(ndim+1);
+    bool *bound_check = new bool[ndim+1];
+
+    for (int i = 0; i < nbranch; i++) {
+        variables[i+1] = nodes[i]->findNeighbor(nodes2[i])->length;
+        lower[i+1] = tree->params->min_branch_length;
+        upper_bound[i+1] = tree->params->max_branch_length;
+    }
+
+    if (nparam > 0) {
+        // bounds of the model, including mixture weights and state frequencies
+        model_factory->setVariables(&variables[nbranch]);
+        ModelSubst *model = model_factory->model;
+        int model_ndim = model->getNDim();
+        ModelMarkov *markov = dynamic_cast<ModelMarkov*>(model);
+        if (markov) {
+            markov->setBounds(&lower[nbranch], &upper_bound[nbranch], bound_check+nbranch);
+        } else {
+            for (int i = 1; i <= model_ndim; i++) {
+                lower[nbranch+i] = MIN_RATE;
+                upper_bound[nbranch+i] = MAX_RATE;
+            }
+        }
+        model_factory->site_rate->setBounds(&lower[nbranch+model_ndim], &upper_bound[nbranch+model_ndim],
+                                            bound_check+nbranch+model_ndim);
+    }
+    for (int i = 1; i <= ndim; i++)
+        variables[i] = max(lower[i], min(upper_bound[i], variables[i]));
+
+    last_param.clear();
+    L_BFGS_B(ndim, &variables[1], &lower[1], &upper_bound[1], 1e-5, max_iterations, logl_epsilon * JOINT_FTOL_FRACTION);
+
+    // leave the tree and the model at the optimum
+    last_param.clear();
+    double score = -targetFunk(&variables[0]);
+    delete [] bound_check;
+    return score;
+}
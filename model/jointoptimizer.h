@@ -0,0 +1,107 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by BUI Quang Minh   *
+ *   minh.bui@univie.ac.at   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef JOINTOPTIMIZER_H
+#define JOINTOPTIMIZER_H
+
+#include "utils/tools.h"
+#include "utils/optimization.h"
+#include "tree/node.h"
+
+class ModelFactory;
+class PhyloTree;
+
+/**
+    optimizes branch lengths, model and rate parameters as one vector by L-BFGS-B
+    instead of alternating optimizeAllBranches() and optimizeParametersOnly().
+    Variables 1..nbranch are branch lengths, followed by the model and rate
+    parameters as in ModelFactory::setVariables().
+    The gradient of the branch lengths is analytic: computeLikelihoodDerv() on every
+    branch in pre-order reuses the partial likelihoods, so all of them cost one
+    post-order and one pre-order traversal. The gradient of the model and rate
+    parameters is approximated by forward differences, one traversal each.
+*/
+class JointOptimizer : public Optimization {
+public:
+
+    /**
+        constructor
+        @param model_factory model factory of the tree
+        @param tree the tree, not a super tree or a tree with mixed branch lengths
+    */
+    JointOptimizer(ModelFactory *model_factory, PhyloTree *tree);
+
+    /**
+        optimize all branch lengths and parameters
+        @param logl_epsilon log-likelihood epsilon, see JOINT_FTOL_FRACTION
+        @param max_iterations maximum number of L-BFGS-B iterations
+        @return log-likelihood of the optimized tree
+    */
+    double optimize(double logl_epsilon, int max_iterations);
+
+    /** @return number of variables */
+    virtual int getNDim();
+
+    /**
+        set branch lengths and parameters and compute the likelihood
+        @param x variables, starting at index 1
+        @return negative log-likelihood
+    */
+    virtual double targetFunk(double x[]);
+
+    /**
+        @param x variables, starting at index 1
+        @param dfx (OUT) gradient of the negative log-likelihood
+        @return negative log-likelihood
+    */
+    virtual double derivativeFunk(double x[], double dfx[]);
+
+    /** number of likelihood evaluations with all partial likelihoods recomputed */
+    int num_traversals;
+
+    /** number of gradients computed */
+    int num_gradients;
+
+protected:
+
+    ModelFactory *model_factory;
+
+    PhyloTree *tree;
+
+    /** branches to optimize, between nodes[i] and nodes2[i] in pre-order */
+    NodeVector nodes, nodes2;
+
+    /** number of model and rate parameters */
+    int nparam;
+
+    /** model and rate parameters of the last likelihood evaluation */
+    DoubleVector last_param;
+
+    /** upper bounds of the variables, starting at index 1 */
+    DoubleVector upper_bound;
+
+    /**
+        set the branch lengths of the tree
+        @param x branch lengths, starting at index 1
+    */
+    void setBranchLengths(double x[]);
+
+};
+
+#endif
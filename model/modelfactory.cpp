@@ -39,9 +39,11 @@
 #include "ratefreeinvar.h"
 #include "rateheterotachy.h"
 #include "rateheterotachyinvar.h"
+#include "jointoptimizer.h"
 //#include "ngs.h"
 #include <string>
 #include "utils/timeutil.h"
+#include "utils/profiler.h"
 #include "nclextra/myreader.h"
 #include <sstream>
 
@@ -671,7 +673,7 @@ ModelFactory::ModelFactory(Params &params, string &model_name, PhyloTree *tree,
         delete [] rates;
         delete [] state_freq;
 
-        models->joinEigenMemory();
+        models->shareEigenMemory();
         models->decomposeRateMatrix();
 
         // delete information of the old alignment
@@ -1557,6 +1559,7 @@ vector<double> ModelFactory::optimizeGammaInvWithInitValue(int fixed_len, double
 
 double ModelFactory::optimizeParameters(int fixed_len, bool write_info,
                                         double logl_epsilon, double gradient_epsilon) {
+    PROFILE_SCOPE("model optimization");
     ASSERT(model);
     ASSERT(site_rate);
 
@@ -1621,7 +1624,24 @@ double ModelFactory::optimizeParameters(int fixed_len, bool write_info,
     }
 #endif
     
-    for (i = 2; i < tree->params->num_param_iterations; i++) {
+    // optimize branch lengths together with the parameters instead of alternating
+    bool joint_brlen = tree->params->optimize_brlen_joint && fixed_len == BRLEN_OPTIMIZE &&
+        !tree->isSuperTree() && !tree->isMixlen() && !tree->isTreeMix() && !model->isSiteSpecificModel();
+    if (joint_brlen) {
+        JointOptimizer joint(this, tree);
+        cur_lh = joint.optimize(logl_epsilon, tree->params->num_param_iterations);
+        site_rate->classifyRates(cur_lh);
+        if (verbose_mode >= VB_MED) {
+            model->writeInfo(cout);
+            site_rate->writeInfo(cout);
+            cout << "Joint optimization: " << joint.num_gradients << " gradients, "
+                 << joint.num_traversals << " likelihood evaluations" << endl;
+        }
+        if (write_info)
+            cout << "2. Current log-likelihood: " << cur_lh << endl;
+    }
+
+    for (i = 2; !joint_brlen && i < tree->params->num_param_iterations; i++) {
         double new_lh;
 
         // changed to opimise edge length first, and then Q,W,R inside the loop
@@ -1761,18 +1781,19 @@ bool ModelFactory::isUnstableParameters() {
 }
 
 void ModelFactory::startStoringTransMatrix() {
-    if (!store_trans_matrix) return;
     is_storing = true;
 }
 
 void ModelFactory::stopStoringTransMatrix() {
-    if (!store_trans_matrix) return;
     is_storing = false;
-    if (!empty()) {
-        for (iterator it = begin(); it != end(); it++)
-            delete it->second;
-        clear();
-    }
+    if (verbose_mode >= VB_MED)
+        trans_cache.report(cout);
+    trans_cache.resetCounters();
+    trans_cache.clearCache();
+}
+
+bool ModelFactory::useTransMatrixCache() {
+    return is_storing && store_trans_matrix && !model->isSiteSpecificModel();
 }
 
 
@@ -1785,54 +1806,24 @@ double ModelFactory::computeTrans(double time, int state1, int state2, double &d
 }
 
 void ModelFactory::computeTransMatrix(double time, double *trans_matrix, int mixture, int selected_row) {
-    if (!store_trans_matrix || !is_storing || model->isSiteSpecificModel()) {
+    if (selected_row >= 0 || !useTransMatrixCache()) {
         model->computeTransMatrix(time, trans_matrix, mixture, selected_row);
         return;
     }
-    int mat_size = model->num_states * model->num_states;
-    iterator ass_it = find(round(time * 1e6));
-    if (ass_it == end()) {
-        // allocate memory for 3 matricies
-        double *trans_entry = new double[mat_size * 3];
-        trans_entry[mat_size] = trans_entry[mat_size+1] = 0.0;
-        model->computeTransMatrix(time, trans_entry, mixture, selected_row);
-        ass_it = insert(value_type(round(time * 1e6), trans_entry)).first;
-    } else {
-        //if (verbose_mode >= VB_MAX)
-            //cout << "ModelFactory bingo" << endl;
-    }
-
-    memcpy(trans_matrix, ass_it->second, mat_size * sizeof(double));
+    trans_cache.computeTransMatrix(model, time, trans_matrix, mixture);
 }
 
 void ModelFactory::computeTransDerv(double time, double *trans_matrix,
     double *trans_derv1, double *trans_derv2, int mixture) {
-    if (!store_trans_matrix || !is_storing || model->isSiteSpecificModel()) {
+    if (!useTransMatrixCache()) {
         model->computeTransDerv(time, trans_matrix, trans_derv1, trans_derv2, mixture);
         return;
     }
-    int mat_size = model->num_states * model->num_states;
-    iterator ass_it = find(round(time * 1e6));
-    if (ass_it == end()) {
-        // allocate memory for 3 matricies
-        double *trans_entry = new double[mat_size * 3];
-        trans_entry[mat_size] = trans_entry[mat_size+1] = 0.0;
-        model->computeTransDerv(time, trans_entry, trans_entry+mat_size, trans_entry+(mat_size*2), mixture);
-        ass_it = insert(value_type(round(time * 1e6), trans_entry)).first;
-    } else if (ass_it->second[mat_size] == 0.0 && ass_it->second[mat_size+1] == 0.0) {
-        double *trans_entry = ass_it->second;
-        model->computeTransDerv(time, trans_entry, trans_entry+mat_size, trans_entry+(mat_size*2), mixture);
-    }
-    memcpy(trans_matrix, ass_it->second, mat_size * sizeof(double));
-    memcpy(trans_derv1, ass_it->second + mat_size, mat_size * sizeof(double));
-    memcpy(trans_derv2, ass_it->second + (mat_size*2), mat_size * sizeof(double));
+    trans_cache.computeTransDerv(model, time, trans_matrix, trans_derv1, trans_derv2, mixture);
 }
 
 ModelFactory::~ModelFactory()
 {
-    for (iterator it = begin(); it != end(); it++)
-        delete it->second;
-    clear();
 }
 
 /************* FOLLOWING SERVE FOR JOINT OPTIMIZATION OF MODEL AND RATE PARAMETERS *******/
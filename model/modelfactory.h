@@ -27,6 +27,7 @@
 #include "utils/checkpoint.h"
 #include "alignment/alignment.h"
 #include "main/phylotesting.h"
+#include "transmatrixcache.h"
 
 const double MIN_BRLEN_SCALE = 0.01;
 const double MAX_BRLEN_SCALE = 100.0;
@@ -55,14 +56,16 @@ string::size_type posRateFree(string &model_name);
 string::size_type posPOMO(string &model_name);
 
 /**
-Store the transition matrix corresponding to evolutionary time so that one must not compute again. 
+Create substitution model and rate heterogeneity, and store the transition matrix corresponding
+to evolutionary time so that one must not compute again (see TransMatrixCache).
 For efficiency purpose esp. for protein (20x20) or codon (61x61).
-The values of the map contain 3 matricies consecutively: transition matrix, 1st, and 2nd derivative
 
 	@author BUI Quang Minh <minh.bui@univie.ac.at>
 */
-class ModelFactory : public unordered_map<int, double*>, public Optimization, public CheckpointFactory
+class ModelFactory : public Optimization, public CheckpointFactory
 {
+	friend class JointOptimizer;
+
 public:
 
 	/**
@@ -139,6 +142,11 @@ public:
 	*/
 	void stopStoringTransMatrix();
 
+	/**
+		@return TRUE if transition matrices are currently taken from trans_cache
+	*/
+	bool useTransMatrixCache();
+
 	/**
 		Wrapper for computing the transition probability matrix from the model. It use ModelFactory
 		that stores matrix computed before for effiency purpose.
@@ -241,6 +249,11 @@ public:
 		TRUE for storing process
 	*/
 	bool is_storing;
+
+	/**
+		cache of transition matrices, used with -mstore
+	*/
+	TransMatrixCache trans_cache;
     
     /**
         TRUE for continuous Gamma
@@ -606,6 +606,7 @@ double ModelGTR::optimizeParameters(double gradient_epsilon) {
 
 void ModelGTR::decomposeRateMatrix(){
 	int i, j, k = 0;
+    decompose_version++;
 
 	if (num_params == -1) {
 		// manual compute eigenvalues/vectors for F81-style model
@@ -22,6 +22,7 @@
 #include <string.h>
 #include "modelliemarkov.h"
 #include "modelunrest.h"
+#include "utils/profiler.h"
 
 #include <Eigen/Eigenvalues>
 #include <unsupported/Eigen/MatrixFunctions>
@@ -506,6 +507,7 @@ void ModelMarkov::computeTransMatrixNonrev(double time, double *trans_matrix, in
 
 void ModelMarkov::computeTransMatrix(double time, double *trans_matrix, int mixture, int selected_row) {
 
+    Profiler::count(PC_TRANS_MATRIX);
     if (!is_reversible) {
         computeTransMatrixNonrev(time, trans_matrix, mixture);
         return;
@@ -1388,6 +1390,7 @@ void ModelMarkov::decomposeRateMatrixNonrev() {
 
 void ModelMarkov::decomposeRateMatrix(){
 	int i, j, k = 0;
+    decompose_version++;
 
     if (!is_reversible) {
         decomposeRateMatrixNonrev();
@@ -1983,50 +1983,31 @@ double ModelMixture::targetFunk(double x[]) {
 double ModelMixture::optimizeWeights() {
     // first compute _pattern_lh_cat
     phylo_tree->computePatternLhCat(WSL_MIXTURE);
-    size_t ptn, c;
-    size_t nptn = phylo_tree->aln->getNPattern();
+    size_t c;
     size_t nmix = getNMixtures();
 
     double *new_prop = aligned_alloc<double>(nmix);
+    // ratio of the current weights to those in _pattern_lh_cat
     double *ratio_prop = aligned_alloc<double>(nmix);
+    for (c = 0; c < nmix; c++)
+        ratio_prop[c] = 1.0;
 
     // EM algorithm loop described in Wang, Li, Susko, and Roger (2008)
 
     for (int step = 0; step < optimize_steps; step++) {
         // E-step
 
-        if (step > 0) {
-            // convert _pattern_lh_cat taking into account new weights
-            for (ptn = 0; ptn < nptn; ptn++) {
-                double *this_lk_cat = phylo_tree->_pattern_lh_cat + ptn*nmix;
-                for (c = 0; c < nmix; c++) {
-                    this_lk_cat[c] *= ratio_prop[c];
-                }
-            }
-        }
-        memset(new_prop, 0, nmix*sizeof(double));
-        for (ptn = 0; ptn < nptn; ptn++) {
-            double *this_lk_cat = phylo_tree->_pattern_lh_cat + ptn*nmix;
-            double lk_ptn = phylo_tree->ptn_invar[ptn];
-//            double lk_ptn = 0.0;
-            for (c = 0; c < nmix; c++) {
-                lk_ptn += this_lk_cat[c];
-            }
-            ASSERT(lk_ptn != 0.0);
-            lk_ptn = phylo_tree->ptn_freq[ptn] / lk_ptn;
-            for (c = 0; c < nmix; c++) {
-                new_prop[c] += this_lk_cat[c] * lk_ptn;
-            }
-        }
+        // _pattern_lh_cat is kept: the new weights enter as ratios to the weights it was computed with
+        phylo_tree->computePatternPosterior(nmix, true, new_prop, false, nullptr, ratio_prop);
         bool converged = true;
 //        double new_pinvar = 0.0;
         for (c = 0; c < nmix; c++) {
-            new_prop[c] /= phylo_tree->getAlnNSite();
+            new_prop[c] /= phylo_tree->getTotalNSite();
             // Make sure that probabilities do not get zero
             if (new_prop[c] < 1e-10) new_prop[c] = 1e-10;
             // check for convergence
             converged = converged && (fabs(prop[c]-new_prop[c]) < 1e-4);
-            ratio_prop[c] = new_prop[c] / prop[c];
+            ratio_prop[c] *= new_prop[c] / prop[c];
             if (std::isnan(ratio_prop[c])) {
                 cerr << "BUG: " << new_prop[c] << " " << prop[c] << " " << ratio_prop[c] << endl;
             }
@@ -2056,7 +2037,7 @@ double ModelMixture::optimizeWeights() {
 
 double ModelMixture::optimizeWithEM(double gradient_epsilon) {
 
-    size_t ptn, c, k;
+    size_t ptn, c;
     size_t nptn = phylo_tree->aln->getNPattern();
     size_t nmix = size();
 
@@ -2100,27 +2081,10 @@ double ModelMixture::optimizeWithEM(double gradient_epsilon) {
             break;
         prev_score = score;
 
-        memset(new_prop, 0, nmix*sizeof(double));
-
         // E-step
         // decoupled weights (prop) from _pattern_lh_cat to obtain L_ci and compute pattern likelihood L_i
-        for (ptn = 0; ptn < nptn; ptn++) {
-            double *this_lk_cat = phylo_tree->_pattern_lh_cat + ptn*nmix;
-            double lk_ptn = 0.0;
-            if (Params::getInstance().optimize_linked_gtr)
-                lk_ptn = phylo_tree->ptn_invar[ptn];
-            for (c = 0; c < nmix; c++) {
-                lk_ptn += this_lk_cat[c];
-            }
-            ASSERT(lk_ptn != 0.0);
-            lk_ptn = phylo_tree->ptn_freq[ptn] / lk_ptn;
-
-            // transform _pattern_lh_cat into posterior probabilities of each category
-            for (c = 0; c < nmix; c++) {
-                this_lk_cat[c] *= lk_ptn;
-                new_prop[c] += this_lk_cat[c];
-            }
-        }
+        // transform _pattern_lh_cat into posterior probabilities of each category
+        phylo_tree->computePatternPosterior(nmix, Params::getInstance().optimize_linked_gtr, new_prop);
 
         // M-step, update weights according to (*)
 
@@ -2131,7 +2095,7 @@ double ModelMixture::optimizeWithEM(double gradient_epsilon) {
             converged = true;
             double new_pinvar = 0.0;
             for (c = 0; c < nmix; c++) {
-                new_prop[c] = new_prop[c] / phylo_tree->getAlnNSite();
+                new_prop[c] = new_prop[c] / phylo_tree->getTotalNSite();
                 if (new_prop[c] < 1e-10) new_prop[c] = 1e-10;
                 // check for convergence
                 converged = converged && (fabs(phylo_tree->getRate()->getProp(c) - new_prop[c]) < 1e-4);
@@ -2149,7 +2113,7 @@ double ModelMixture::optimizeWithEM(double gradient_epsilon) {
         } else if (!fix_prop) {
 //            double new_pinvar = 0.0;
             for (c = 0; c < nmix; c++) {
-                new_prop[c] = new_prop[c] / phylo_tree->getAlnNSite();
+                new_prop[c] = new_prop[c] / phylo_tree->getTotalNSite();
                 if (new_prop[c] < 1e-10) new_prop[c] = 1e-10;
                 // check for convergence
                 converged = converged && (fabs(prop[c]-new_prop[c]) < 1e-4);
@@ -2173,20 +2137,7 @@ double ModelMixture::optimizeWithEM(double gradient_epsilon) {
                 // compute _pattern_lh_cat
                 phylo_tree->computePatternLhCat(WSL_MIXTURE);
                 // update the posterior probabilities of each category
-                for (ptn = 0; ptn < nptn; ptn++) {
-                    double *this_lk_cat = phylo_tree->_pattern_lh_cat + ptn*nmix;
-                    // double lk_ptn = phylo_tree->ptn_invar[ptn];
-                    double lk_ptn = 0.0;
-                    for (k = 0; k < nmix; k++) {
-                        lk_ptn += this_lk_cat[k];
-                    }
-                    ASSERT(lk_ptn != 0.0);
-                    lk_ptn = phylo_tree->ptn_freq[ptn] / lk_ptn;
-                    // transform _pattern_lh_cat into posterior probabilities of each category
-                    for (k = 0; k < nmix; k++) {
-                        this_lk_cat[k] *= lk_ptn;
-                    }
-                }
+                phylo_tree->computePatternPosterior(nmix, false, nullptr);
             }
 
             tree->copyPhyloTreeMixlen(phylo_tree, c, true);
@@ -2468,6 +2419,13 @@ void ModelMixture::decomposeRateMatrix() {
 		(*it)->decomposeRateMatrix();
 }
 
+int64_t ModelMixture::getDecomposeVersion() {
+    int64_t version = decompose_version;
+    for (iterator it = begin(); it != end(); it++)
+        version += (*it)->getDecomposeVersion();
+    return version;
+}
+
 // added case for gtr optimization -JD
 void ModelMixture::setVariables(double *variables) {
     if (getNDim() == 0)
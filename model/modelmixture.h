@@ -253,6 +253,11 @@ public:
 	*/
 	virtual void decomposeRateMatrix();
 
+    /**
+        @return sum of the decompose versions of all classes, as classes may be decomposed individually
+    */
+    virtual int64_t getDecomposeVersion();
+
 	/**
 	 * setup the bounds for joint optimization with BFGS
 	 */
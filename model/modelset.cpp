@@ -24,6 +24,7 @@ ModelSet::ModelSet(const char *model_name, PhyloTree *tree) : ModelMarkov(tree)
 	name = full_name = model_name;
 	name += "+SSF";
 	full_name += "+site-specific state-frequency model (unpublished)";
+    eigen_block_vsize = 0;
 }
 
 void ModelSet::computeTransMatrix(double time, double* trans_matrix, int mixture, int selected_row)
@@ -57,20 +58,16 @@ int ModelSet::getPtnModelID(int ptn)
 
 
 double ModelSet::computeTrans(double time, int model_id, int state1, int state2) {
-    if (phylo_tree->vector_size == 1) {
-        return at(model_id)->computeTrans(time, state1, state2);
-    }
-	// temporary fix problem with vectorized eigenvectors
-	int i;
-    int vsize = phylo_tree->vector_size;
-    int states_vsize = num_states*vsize;
-    int model_vec_id = model_id % vsize;
-    int start_ptn = model_id - model_vec_id;
+    // eigensystem of the model is stored interleaved in one lane of a block
+    ASSERT(eigen_block_vsize > 0);
+    size_t vsize = eigen_block_vsize;
+    size_t model_vec_id = model_lane[model_id] % vsize;
+    size_t start_ptn = model_lane[model_id] - model_vec_id;
     double *evec = &eigenvectors[start_ptn*num_states*num_states + model_vec_id + state1*num_states*vsize];
     double *inv_evec = &inv_eigenvectors[start_ptn*num_states*num_states + model_vec_id + state2*vsize];
     double *eval = &eigenvalues[start_ptn*num_states + model_vec_id];
 	double trans_prob = 0.0;
-	for (i = 0; i < states_vsize; i+=vsize) {
+	for (size_t i = 0; i < num_states*vsize; i+=vsize) {
         double val = eval[i];
 		double trans = evec[i] * inv_evec[i*num_states] * exp(time * val);
 		trans_prob += trans;
@@ -79,21 +76,16 @@ double ModelSet::computeTrans(double time, int model_id, int state1, int state2)
 }
 
 double ModelSet::computeTrans(double time, int model_id, int state1, int state2, double &derv1, double &derv2) {
-    if (phylo_tree->vector_size == 1) {
-        return at(model_id)->computeTrans(time, state1, state2, derv1, derv2);
-    }
-	// temporary fix problem with vectorized eigenvectors
-	int i;
-    int vsize = phylo_tree->vector_size;
-    int states_vsize = num_states*vsize;
-    int model_vec_id = model_id % vsize;
-    int start_ptn = model_id - model_vec_id;
+    ASSERT(eigen_block_vsize > 0);
+    size_t vsize = eigen_block_vsize;
+    size_t model_vec_id = model_lane[model_id] % vsize;
+    size_t start_ptn = model_lane[model_id] - model_vec_id;
     double *evec = &eigenvectors[start_ptn*num_states*num_states + model_vec_id + state1*num_states*vsize];
     double *inv_evec = &inv_eigenvectors[start_ptn*num_states*num_states + model_vec_id + state2*vsize];
     double *eval = &eigenvalues[start_ptn*num_states + model_vec_id];
 	double trans_prob = 0.0;
 	derv1 = derv2 = 0.0;
-	for (i = 0; i < states_vsize; i+=vsize) {
+	for (size_t i = 0; i < num_states*vsize; i+=vsize) {
         double val = eval[i];
 		double trans = evec[i] * inv_evec[i*num_states] * exp(time * val);
 		double trans2 = trans * val;
@@ -131,53 +123,101 @@ void ModelSet::decomposeRateMatrix()
     if (empty()) {
         return;
     }
-    for (iterator it = begin(); it != end(); it++) {
-        (*it)->decomposeRateMatrix();
-    }
-	if (phylo_tree->vector_size == 1)
-		return;
-	// rearrange eigen to obey vector_size
-	size_t vsize = phylo_tree->vector_size;
-	size_t states2 = num_states*num_states;
-
-    size_t max_size = get_safe_upper_limit(size());
-
-    // copy dummy values
-    for (size_t m = size(); m < max_size; m++) {
-        memcpy(&eigenvalues[m*num_states], &eigenvalues[(m-1)*num_states], sizeof(double)*num_states);
-        memcpy(&eigenvectors[m*states2], &eigenvectors[(m-1)*states2], sizeof(double)*states2);
-        memcpy(&inv_eigenvectors[m*states2], &inv_eigenvectors[(m-1)*states2], sizeof(double)*states2);
-        memcpy(&inv_eigenvectors_transposed[m*states2], &inv_eigenvectors_transposed[(m-1)*states2], sizeof(double)*states2);
-    }
+    size_t vsize = max(phylo_tree->vector_size, (size_t)1);
+    if (vsize != eigen_block_vsize)
+        initEigenBlocks(vsize);
 
-    double new_eval[num_states*vsize];
-    double new_evec[states2*vsize];
-    double new_inv_evec[states2*vsize];
+    size_t states2 = num_states*num_states;
+    IntVector lanes_begin(size()+1, 0);
+    IntVector lanes(eigen_block_models.size());
+    // group lanes by model
+    for (int m : eigen_block_models)
+        lanes_begin[m+1]++;
+    for (size_t m = 0; m < size(); m++)
+        lanes_begin[m+1] += lanes_begin[m];
+    IntVector next_lane(lanes_begin.begin(), lanes_begin.end()-1);
+    for (size_t lane = 0; lane < eigen_block_models.size(); lane++)
+        lanes[next_lane[eigen_block_models[lane]]++] = lane;
 
-    for (size_t ptn = 0; ptn < size(); ptn += vsize) {
-        double *eval_ptr = &eigenvalues[ptn*num_states];
-        double *evec_ptr = &eigenvectors[ptn*states2];
-        double *inv_evec_ptr = &inv_eigenvectors[ptn*states2];
-        for (size_t i = 0; i < vsize; i++) {
+    for (size_t m = 0; m < size(); m++) {
+        // decompose into the shared memory, then copy into the lanes using this model
+        ModelMarkov *model = at(m);
+        model->decomposeRateMatrix();
+        for (int k = lanes_begin[m]; k < lanes_begin[m+1]; k++) {
+            size_t i = lanes[k] % vsize;
+            size_t start_ptn = lanes[k] - i;
+            double *eval_ptr = &eigenvalues[start_ptn*num_states];
+            double *evec_ptr = &eigenvectors[start_ptn*states2];
+            double *inv_evec_ptr = &inv_eigenvectors[start_ptn*states2];
+            double *inv_evec_t_ptr = &inv_eigenvectors_transposed[start_ptn*states2];
             for (size_t x = 0; x < num_states; x++)
-                new_eval[x*vsize+i] = eval_ptr[x];
+                eval_ptr[x*vsize+i] = model->eigenvalues[x];
             for (size_t x = 0; x < states2; x++) {
-                new_evec[x*vsize+i] = evec_ptr[x];
-                new_inv_evec[x*vsize+i] = inv_evec_ptr[x];
+                evec_ptr[x*vsize+i] = model->eigenvectors[x];
+                inv_evec_ptr[x*vsize+i] = model->inv_eigenvectors[x];
+                inv_evec_t_ptr[x*vsize+i] = model->inv_eigenvectors_transposed[x];
             }
-            eval_ptr += num_states;
-            evec_ptr += states2;
-            inv_evec_ptr += states2;
         }
-        // copy new values
-        memcpy(&eigenvalues[ptn*num_states], new_eval, sizeof(double)*num_states*vsize);
-        memcpy(&eigenvectors[ptn*states2], new_evec, sizeof(double)*states2*vsize);
-        memcpy(&inv_eigenvectors[ptn*states2], new_inv_evec, sizeof(double)*states2*vsize);
-        calculateSquareMatrixTranspose(new_inv_evec, num_states
-                                       , &inv_eigenvectors_transposed[ptn*states2]);
     }
 }
 
+void ModelSet::initEigenBlocks(size_t vsize) {
+    // patterns beyond the alignment (vector padding) reuse the model of the last pattern
+    size_t nptn = pattern_model_map.size();
+    ASSERT(nptn > 0);
+    size_t num_blocks = (get_safe_upper_limit(nptn) + vsize - 1) / vsize;
+    map<IntVector, int> block_index;
+    IntVector block(vsize);
+    eigen_block_map.resize(num_blocks);
+    eigen_block_models.clear();
+    model_lane.assign(size(), -1);
+    for (size_t b = 0; b < num_blocks; b++) {
+        for (size_t i = 0; i < vsize; i++)
+            block[i] = pattern_model_map[min(b*vsize+i, nptn-1)];
+        auto it = block_index.find(block);
+        if (it != block_index.end()) {
+            eigen_block_map[b] = it->second;
+            continue;
+        }
+        eigen_block_map[b] = block_index.size();
+        block_index[block] = eigen_block_map[b];
+        for (size_t i = 0; i < vsize; i++) {
+            if (model_lane[block[i]] < 0)
+                model_lane[block[i]] = eigen_block_models.size();
+            eigen_block_models.push_back(block[i]);
+        }
+    }
+    eigen_block_vsize = vsize;
+
+    aligned_free(eigenvalues);
+    aligned_free(eigenvectors);
+    aligned_free(inv_eigenvectors);
+    aligned_free(inv_eigenvectors_transposed);
+    size_t nlanes = eigen_block_models.size();
+    size_t states2 = num_states*num_states;
+    eigenvalues = aligned_alloc<double>(num_states*nlanes);
+    eigenvectors = aligned_alloc<double>(states2*nlanes);
+    inv_eigenvectors = aligned_alloc<double>(states2*nlanes);
+    inv_eigenvectors_transposed = aligned_alloc<double>(states2*nlanes);
+
+    if (verbose_mode >= VB_MED) {
+        cout << "Site-specific model: " << size() << " frequency vectors for " << nptn << " patterns, "
+             << block_index.size() << " of " << num_blocks << " eigensystem blocks stored ("
+             << (nlanes*(num_states+3*states2)*sizeof(double) >> 20) << " MB instead of "
+             << (num_blocks*vsize*(num_states+3*states2)*sizeof(double) >> 20) << " MB)" << endl;
+    }
+}
+
+uint64_t ModelSet::getMemoryRequired() {
+    uint64_t mem = ModelMarkov::getMemoryRequired();
+    for (iterator it = begin(); it != end(); it++)
+        mem += (*it)->getMemoryRequired();
+    // interleaved eigensystems, at most one per pattern
+    size_t nlanes = eigen_block_vsize ? eigen_block_models.size() : get_safe_upper_limit(pattern_model_map.size());
+    mem += nlanes * (num_states + 3*num_states*num_states) * sizeof(double);
+    return mem;
+}
+
 bool ModelSet::getVariables(double* variables)
 {
 	ASSERT(size());
@@ -195,55 +235,29 @@ void ModelSet::setVariables(double* variables)
 
 ModelSet::~ModelSet()
 {
+    // the shared eigen memory belongs to the first model
     for (reverse_iterator rit = rbegin(); rit != rend(); rit++) {
-        (*rit)->eigenvalues = nullptr;
-        (*rit)->eigenvectors = nullptr;
-        (*rit)->inv_eigenvectors = nullptr;
-        (*rit)->inv_eigenvectors_transposed = nullptr;
+        if (*rit != front()) {
+            (*rit)->eigenvalues = nullptr;
+            (*rit)->eigenvectors = nullptr;
+            (*rit)->inv_eigenvectors = nullptr;
+            (*rit)->inv_eigenvectors_transposed = nullptr;
+        }
         delete (*rit);
     }
 }
 
-void ModelSet::joinEigenMemory() {
-    size_t nmixtures = get_safe_upper_limit(size());
-    aligned_free(eigenvalues);
-    aligned_free(eigenvectors);
-    aligned_free(inv_eigenvectors);
-    aligned_free(inv_eigenvectors_transposed);
-    
-    size_t states2 = num_states*num_states;
-    
-    eigenvalues = aligned_alloc<double>(num_states*nmixtures);
-    eigenvectors = aligned_alloc<double>(states2*nmixtures);
-    inv_eigenvectors = aligned_alloc<double>(states2*nmixtures);
-    inv_eigenvectors_transposed = aligned_alloc<double>(states2*nmixtures);
-    
-    // assigning memory for individual models
-    size_t m = 0;
-    for (iterator it = begin(); it != end(); it++, m++) {
-        // first copy memory for eigen stuffs
-        memcpy(&eigenvalues[m*num_states], (*it)->eigenvalues, num_states*sizeof(double));
-        memcpy(&eigenvectors[m*states2], (*it)->eigenvectors, states2*sizeof(double));
-        memcpy(&inv_eigenvectors[m*states2], (*it)->inv_eigenvectors, states2*sizeof(double));
-        memcpy(&inv_eigenvectors_transposed[m*states2], (*it)->inv_eigenvectors_transposed, states2*sizeof(double));
-        // then delete
+void ModelSet::shareEigenMemory() {
+    ASSERT(!empty());
+    ModelMarkov *first = front();
+    for (iterator it = begin()+1; it != end(); it++) {
         aligned_free((*it)->eigenvalues);
         aligned_free((*it)->eigenvectors);
         aligned_free((*it)->inv_eigenvectors);
         aligned_free((*it)->inv_eigenvectors_transposed);
-        
-        // and assign new memory
-        (*it)->eigenvalues = &eigenvalues[m*num_states];
-        (*it)->eigenvectors = &eigenvectors[m*states2];
-        (*it)->inv_eigenvectors = &inv_eigenvectors[m*states2];
-        (*it)->inv_eigenvectors_transposed = &inv_eigenvectors_transposed[m*states2];
-    }
-    
-    // copy dummy values
-    for (m = size(); m < nmixtures; m++) {
-        memcpy(&eigenvalues[m*num_states], &eigenvalues[(m-1)*num_states], sizeof(double)*num_states);
-        memcpy(&eigenvectors[m*states2], &eigenvectors[(m-1)*states2], sizeof(double)*states2);
-        memcpy(&inv_eigenvectors[m*states2], &inv_eigenvectors[(m-1)*states2], sizeof(double)*states2);
-        memcpy(&inv_eigenvectors_transposed[m*states2], &inv_eigenvectors_transposed[(m-1)*states2], sizeof(double)*states2);
+        (*it)->eigenvalues = first->eigenvalues;
+        (*it)->eigenvectors = first->eigenvectors;
+        (*it)->inv_eigenvectors = first->inv_eigenvectors;
+        (*it)->inv_eigenvectors_transposed = first->inv_eigenvectors_transposed;
     }
 }
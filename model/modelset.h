@@ -141,22 +141,43 @@ public:
      * compute the memory size for the model, can be large for site-specific models
      * @return memory size required in bytes
      */
-    virtual uint64_t getMemoryRequired() {
-    	uint64_t mem = ModelMarkov::getMemoryRequired();
-    	for (iterator it = begin(); it != end(); it++)
-    		mem += (*it)->getMemoryRequired();
-    	return mem;
-    }
+    virtual uint64_t getMemoryRequired();
+
+    /**
+     * @return map from pattern block (of vector_size patterns) to block of eigensystems
+     */
+    virtual int *getEigenBlockMap() { return eigen_block_map.empty() ? nullptr : &eigen_block_map[0]; }
 
 	/** map from pattern ID to model ID */
 	IntVector pattern_model_map;
 
     /**
-        join memory for eigen into one chunk
+        let all models decompose their rate matrices into one shared memory,
+        from where the eigensystems are copied into the interleaved blocks for the kernel
     */
-    void joinEigenMemory();
+    void shareEigenMemory();
 
 protected:
+
+    /**
+        build the map from pattern blocks to distinct blocks of eigensystems and
+        allocate the interleaved eigen memory
+        @param vsize number of patterns per block (vector size of the likelihood kernel)
+    */
+    void initEigenBlocks(size_t vsize);
+
+    /** for each block of vector_size patterns, index of its block of eigensystems */
+    IntVector eigen_block_map;
+
+    /** model ID of each lane of all distinct blocks of eigensystems */
+    IntVector eigen_block_models;
+
+    /** for each model, a lane (block*vsize + position) holding its eigensystem */
+    IntVector model_lane;
+
+    /** number of patterns per block for which eigen_block_map was built, 0 if not yet */
+    size_t eigen_block_vsize;
+
 	
 	
 
@@ -11,6 +11,7 @@
 //
 #include "modelsubst.h"
 #include "utils/tools.h"
+#include "utils/profiler.h"
 
 ModelSubst::ModelSubst(int nstates) : Optimization(), CheckpointFactory()
 {
@@ -22,6 +23,7 @@ ModelSubst::ModelSubst(int nstates) : Optimization(), CheckpointFactory()
 		state_freq[i] = 1.0 / num_states;
 	freq_type = FREQ_EQUAL;
     fixed_parameters = false;
+    decompose_version = 0;
 //    linked_model = nullptr;
 }
 
@@ -60,6 +62,7 @@ void ModelSubst::restoreCheckpoint() {
 
 // here the simplest Juke-Cantor model is implemented, valid for all kind of data (DNA, AA,...)
 void ModelSubst::computeTransMatrix(double time, double *trans_matrix, int mixture, int selected_row) {
+    Profiler::count(PC_TRANS_MATRIX);
 	double non_diagonal = (1.0 - exp(-time*num_states/(num_states - 1))) / num_states;
 	double diagonal = 1.0 - non_diagonal * (num_states - 1);
 	int nstates_sqr = num_states * num_states;
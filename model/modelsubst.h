@@ -246,6 +246,12 @@ public:
 	 * @param ptn pattern ID of the alignment
 	 */
 	virtual int getPtnModelID(int ptn) { return 0; }
+
+	/**
+	 * @return for site-specific models, map from pattern block (of vector_size patterns)
+	 *         to block of eigensystems; nullptr otherwise
+	 */
+	virtual int *getEigenBlockMap() { return nullptr; }
 	
 
 	/**
@@ -328,6 +334,12 @@ public:
 	*/
 	virtual void decomposeRateMatrix() {}
 
+    /**
+        @return counter increased whenever the rate matrix is decomposed,
+        used to invalidate cached transition matrices
+    */
+    virtual int64_t getDecomposeVersion() { return decompose_version; }
+
 
     /** 
         set number of optimization steps
@@ -444,6 +456,9 @@ public:
     /** true to fix parameters, otherwise false */
     bool fixed_parameters;
 
+    /** number of times the rate matrix was decomposed, see getDecomposeVersion() */
+    int64_t decompose_version;
+
 	/**
 	 state frequencies
 	 */
@@ -225,23 +225,14 @@ double RateGammaInvar::optimizeWithEM(double gradient_epsilon) {
     curlh = gamma_lh;
 
     size_t ncat = getNRate();
-    size_t nptn = phylo_tree->aln->getNPattern();
-    size_t nSites = phylo_tree->aln->getNSite();
+    size_t nSites = phylo_tree->getTotalNSite();
 
     // Compute the pattern likelihood for each category (invariable and variable category)
     phylo_tree->computePatternLhCat(WSL_RATECAT);
     phylo_tree->computePtnInvar();
 
     double ppInvar = 0;
-    for (size_t ptn = 0; ptn < nptn; ptn++) {
-        double *this_lk_cat = phylo_tree->_pattern_lh_cat + ptn * ncat;
-        double lk_ptn = phylo_tree->ptn_invar[ptn];
-        for (size_t cat = 0; cat < ncat; cat++) {
-            lk_ptn += this_lk_cat[cat];
-        }
-        ASSERT(lk_ptn != 0.0);
-        ppInvar += (phylo_tree->ptn_invar[ptn]) * phylo_tree->ptn_freq[ptn] / lk_ptn;
-    }
+    phylo_tree->computePatternPosterior(ncat, true, nullptr, false, &ppInvar);
 
     double newPInvar = ppInvar / nSites;
     ASSERT(newPInvar < 1.0);
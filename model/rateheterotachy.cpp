@@ -159,48 +159,30 @@ double RateHeterotachy::optimizeWithEM() {
 
     // first compute _pattern_lh_cat
     phylo_tree->computePatternLhCat(WSL_RATECAT);
-    size_t nptn = phylo_tree->aln->getNPattern();
     size_t nmix = ncategory;
     
     double *new_prop = aligned_alloc<double>(nmix);
+    // ratio of the current weights to those in _pattern_lh_cat
     double *ratio_prop = aligned_alloc<double>(nmix);
+    for (size_t c = 0; c < nmix; c++)
+        ratio_prop[c] = 1.0;
 
     // EM algorithm loop described in Wang, Li, Susko, and Roger (2008)
 
     for (int step = 0; step < optimize_steps; step++) {
         // E-step
 
-        if (step > 0) {
-            // convert _pattern_lh_cat taking into account new weights
-            for (size_t ptn = 0; ptn < nptn; ptn++) {
-                double *this_lk_cat = phylo_tree->_pattern_lh_cat + ptn*nmix;
-                for (size_t c = 0; c < nmix; c++) {
-                    this_lk_cat[c] *= ratio_prop[c];
-                }
-            } 
-        }
-        memset(new_prop, 0, nmix*sizeof(double));
-        for (size_t ptn = 0; ptn < nptn; ptn++) {
-            double *this_lk_cat = phylo_tree->_pattern_lh_cat + ptn*nmix;
-            double lk_ptn = phylo_tree->ptn_invar[ptn];
-            for (size_t c = 0; c < nmix; c++) {
-                lk_ptn += this_lk_cat[c];
-            }
-            ASSERT(lk_ptn != 0.0);
-            lk_ptn = phylo_tree->ptn_freq[ptn] / lk_ptn;
-            for (size_t c = 0; c < nmix; c++) {
-                new_prop[c] += this_lk_cat[c] * lk_ptn;
-            }
-        } 
+        // _pattern_lh_cat is kept: the new weights enter as ratios to the weights it was computed with
+        phylo_tree->computePatternPosterior(nmix, true, new_prop, false, nullptr, ratio_prop);
         bool converged = true;
         double new_pinvar = 0.0;    
         for (size_t c = 0; c < nmix; c++) {
-            new_prop[c] /= phylo_tree->getAlnNSite();
+            new_prop[c] /= phylo_tree->getTotalNSite();
             // Make sure that probabilities do not get zero
             if (new_prop[c] < 1e-10) new_prop[c] = 1e-10;
             // check for convergence
             converged = converged && (fabs(prop[c]-new_prop[c]) < 1e-4);
-            ratio_prop[c] = new_prop[c] / prop[c];
+            ratio_prop[c] *= new_prop[c] / prop[c];
             if (std::isnan(ratio_prop[c])) {
                 cerr << "BUG: " << new_prop[c] << " " << prop[c] << " " << ratio_prop[c] << endl;
             }
@@ -0,0 +1,160 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by BUI Quang Minh   *
+ *   minh.bui@univie.ac.at   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "transmatrixcache.h"
+
+/** memory limit in bytes of one transition matrix cache */
+const size_t TRANS_CACHE_MAX_MEMORY = 64*1024*1024;
+
+TransMatrixCache::TransMatrixCache() {
+    cached_model = nullptr;
+    version = -1;
+    mat_size = 0;
+    max_entries = 0;
+    num_hits = 0;
+    num_misses = 0;
+#ifdef _OPENMP
+    omp_init_lock(&cache_lock);
+#endif
+}
+
+TransMatrixCache::~TransMatrixCache() {
+    clearCache();
+#ifdef _OPENMP
+    omp_destroy_lock(&cache_lock);
+#endif
+}
+
+void TransMatrixCache::clearCache() {
+    for (iterator it = begin(); it != end(); it++)
+        delete [] it->second;
+    clear();
+}
+
+double *TransMatrixCache::lookup(ModelSubst *model, const TransMatrixKey &key) {
+    int64_t model_version = model->getDecomposeVersion();
+    size_t model_mat_size = model->num_states * model->num_states;
+    if (model != cached_model || model_version != version || model_mat_size != mat_size) {
+        // model parameters changed: all matrices are outdated
+        clearCache();
+        cached_model = model;
+        version = model_version;
+        mat_size = model_mat_size;
+        max_entries = max(TRANS_CACHE_MAX_MEMORY / ((3*mat_size+1) * sizeof(double)), (size_t)16);
+        return nullptr;
+    }
+    iterator it = find(key);
+    if (it == end())
+        return nullptr;
+    return it->second;
+}
+
+void TransMatrixCache::insert(ModelSubst *model, const TransMatrixKey &key, double *trans_matrix,
+                              double *trans_derv1, double *trans_derv2)
+{
+    double *entry = lookup(model, key);
+    if (!entry) {
+        if (size() >= max_entries)
+            clearCache();
+        entry = new double[3*mat_size+1];
+        entry[3*mat_size] = 0.0;
+        (*this)[key] = entry;
+    }
+    memcpy(entry, trans_matrix, mat_size * sizeof(double));
+    if (trans_derv1) {
+        memcpy(entry + mat_size, trans_derv1, mat_size * sizeof(double));
+        memcpy(entry + 2*mat_size, trans_derv2, mat_size * sizeof(double));
+        entry[3*mat_size] = 1.0;
+    }
+}
+
+void TransMatrixCache::computeTransMatrix(ModelSubst *model, double time, double *trans_matrix, int mixture) {
+    TransMatrixKey key = {time, mixture};
+    bool found = false;
+#ifdef _OPENMP
+    omp_set_lock(&cache_lock);
+#endif
+    {
+        double *entry = lookup(model, key);
+        if (entry) {
+            memcpy(trans_matrix, entry, mat_size * sizeof(double));
+            num_hits++;
+            found = true;
+        } else {
+            num_misses++;
+        }
+    }
+#ifdef _OPENMP
+    omp_unset_lock(&cache_lock);
+#endif
+    if (found)
+        return;
+    // compute without holding the lock so that threads do not wait for each other
+    model->computeTransMatrix(time, trans_matrix, mixture);
+#ifdef _OPENMP
+    omp_set_lock(&cache_lock);
+#endif
+    insert(model, key, trans_matrix, nullptr, nullptr);
+#ifdef _OPENMP
+    omp_unset_lock(&cache_lock);
+#endif
+}
+
+void TransMatrixCache::computeTransDerv(ModelSubst *model, double time, double *trans_matrix,
+                                        double *trans_derv1, double *trans_derv2, int mixture)
+{
+    TransMatrixKey key = {time, mixture};
+    bool found = false;
+#ifdef _OPENMP
+    omp_set_lock(&cache_lock);
+#endif
+    {
+        double *entry = lookup(model, key);
+        if (entry && entry[3*mat_size] != 0.0) {
+            memcpy(trans_matrix, entry, mat_size * sizeof(double));
+            memcpy(trans_derv1, entry + mat_size, mat_size * sizeof(double));
+            memcpy(trans_derv2, entry + 2*mat_size, mat_size * sizeof(double));
+            num_hits++;
+            found = true;
+        } else {
+            num_misses++;
+        }
+    }
+#ifdef _OPENMP
+    omp_unset_lock(&cache_lock);
+#endif
+    if (found)
+        return;
+    model->computeTransDerv(time, trans_matrix, trans_derv1, trans_derv2, mixture);
+#ifdef _OPENMP
+    omp_set_lock(&cache_lock);
+#endif
+    insert(model, key, trans_matrix, trans_derv1, trans_derv2);
+#ifdef _OPENMP
+    omp_unset_lock(&cache_lock);
+#endif
+}
+
+void TransMatrixCache::report(ostream &out) {
+    int64_t total = num_hits + num_misses;
+    if (total == 0)
+        return;
+    out << "Transition matrix cache: " << num_hits << " hits, " << num_misses << " misses ("
+        << (100.0 * num_hits / total) << "% hit rate)" << endl;
+}
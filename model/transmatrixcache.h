@@ -0,0 +1,147 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by BUI Quang Minh   *
+ *   minh.bui@univie.ac.at   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef TRANSMATRIXCACHE_H
+#define TRANSMATRIXCACHE_H
+
+#include "utils/tools.h"
+#include "modelsubst.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/** key of a cached transition matrix: evolutionary time and mixture class */
+struct TransMatrixKey {
+    double time;
+    int mixture;
+
+    bool operator==(const TransMatrixKey &other) const {
+        return time == other.time && mixture == other.mixture;
+    }
+};
+
+struct TransMatrixKeyHash {
+    size_t operator()(const TransMatrixKey &key) const {
+        return hash<double>()(key.time) ^ ((size_t)key.mixture * 0x9e3779b97f4a7c15ULL);
+    }
+};
+
+/**
+    Thread-safe cache of transition matrices and their derivatives, keyed by the
+    exact evolutionary time (branch length times category rate) and the mixture class.
+    Each entry contains 3 matrices consecutively: transition matrix, 1st and 2nd derivative.
+    The cache is emptied whenever the model or its decompose version changes,
+    and when it exceeds its memory limit. Each cache has its own lock, so that
+    the caches of different partitions do not block each other.
+*/
+class TransMatrixCache : protected unordered_map<TransMatrixKey, double*, TransMatrixKeyHash>
+{
+public:
+
+    TransMatrixCache();
+
+    ~TransMatrixCache();
+
+    /**
+        compute the transition matrix, taking it from the cache if available
+        @param model substitution model
+        @param time time between two events
+        @param[out] trans_matrix transition matrix
+        @param mixture class for mixture model
+    */
+    void computeTransMatrix(ModelSubst *model, double time, double *trans_matrix, int mixture);
+
+    /**
+        compute the transition matrix and its derivatives, taking them from the cache if available
+        @param model substitution model
+        @param time time between two events
+        @param[out] trans_matrix transition matrix
+        @param[out] trans_derv1 1st derivative matrix
+        @param[out] trans_derv2 2nd derivative matrix
+        @param mixture class for mixture model
+    */
+    void computeTransDerv(ModelSubst *model, double time, double *trans_matrix,
+                          double *trans_derv1, double *trans_derv2, int mixture);
+
+    /** delete all cached matrices */
+    void clearCache();
+
+    /** @return number of lookups answered from the cache */
+    int64_t getNumHits() { return num_hits; }
+
+    /** @return number of lookups that needed a new computation */
+    int64_t getNumMisses() { return num_misses; }
+
+    /** reset hit and miss counters */
+    void resetCounters() { num_hits = num_misses = 0; }
+
+    /**
+        print hit rate statistics
+        @param out output stream
+    */
+    void report(ostream &out);
+
+protected:
+
+    /**
+        look up an entry, emptying the cache first if the model has changed.
+        Must be called with cache_lock set.
+        @param model substitution model
+        @param key time and mixture class
+        @return entry of 3 matrices followed by a flag for the derivatives, nullptr if not found
+    */
+    double *lookup(ModelSubst *model, const TransMatrixKey &key);
+
+    /**
+        store matrices for a key. Must be called with cache_lock set.
+        @param model substitution model
+        @param key time and mixture class
+        @param trans_matrix transition matrix
+        @param trans_derv1 1st derivative matrix, nullptr if not computed
+        @param trans_derv2 2nd derivative matrix, nullptr if not computed
+    */
+    void insert(ModelSubst *model, const TransMatrixKey &key, double *trans_matrix,
+                double *trans_derv1, double *trans_derv2);
+
+    /** model of the cached matrices */
+    ModelSubst *cached_model;
+
+    /** decompose version of the model for the cached matrices */
+    int64_t version;
+
+    /** number of entries of one matrix */
+    size_t mat_size;
+
+    /** maximal number of entries before the cache is emptied */
+    size_t max_entries;
+
+    /** number of lookups answered from the cache */
+    int64_t num_hits;
+
+    /** number of lookups that needed a new computation */
+    int64_t num_misses;
+
+#ifdef _OPENMP
+    /** lock protecting the entries and counters of this cache */
+    omp_lock_t cache_lock;
+#endif
+
+};
+
+#endif
@@ -59,7 +59,7 @@ Terrace::Terrace(const char *infile_tree, bool is_rooted,const char *infile_matr
   
 };
 
-Terrace::Terrace(TerraceTree tree, PresenceAbsenceMatrix *m){
+Terrace::Terrace(TerraceTree &tree, PresenceAbsenceMatrix *m){
     
     init();
 
@@ -83,7 +83,7 @@ Terrace::Terrace(TerraceTree tree, PresenceAbsenceMatrix *m){
     fillLeafNodes();
 }
 
-Terrace::Terrace(TerraceTree tree, PresenceAbsenceMatrix *m, vector<TerraceTree*> input_induced_trees){
+Terrace::Terrace(TerraceTree &tree, PresenceAbsenceMatrix *m, vector<TerraceTree*> input_induced_trees){
  
     init();
     
@@ -795,7 +795,7 @@ void Terrace::printBackMapInfo(){
     }
 }
 
-void Terrace::create_Top_Low_Part_Tree_Pairs(vector<Terrace*> &part_tree_pairs, Terrace *terrace){
+void Terrace::create_Top_Low_Part_Tree_Pairs(vector<Terrace*> &part_tree_pairs, Terrace *terrace, bool check_compatibility){
     
     int i=0;
     NodeVector aux_taxon_nodes;
@@ -803,7 +803,7 @@ void Terrace::create_Top_Low_Part_Tree_Pairs(vector<Terrace*> &part_tree_pairs,
     IntVector parts;
     bool back_branch_map = false, back_taxon_map = true;
 
-    if(!terrace->root){
+    if(!terrace->root && check_compatibility){
         cout<<"Since no represenative tree was provided, performing a basic compatibility check..\n";
         /* ---------------------------------------------------------------------------------------------
             If no input representative tree, perform basic compatibility check:
@@ -1090,6 +1090,11 @@ void Terrace::extendNewTaxon(string node_name, TerraceNode *node_1_branch, Terra
     //printTree(cout, WT_BR_SCALE | WT_NEWLINE);
     
     intermediated_trees_num +=1;
+    if(generation){
+        // progress and stopping rules are handled on the shared counters
+        syncGeneration();
+        return;
+    }
     if(verbose_mode>=VB_MED){
         if((intermediated_trees_num+terrace_trees_num) % 100000 == 0 and terrace_trees_num < 10000000){
             cout<<"... trees generated - "<<intermediated_trees_num + terrace_trees_num<<"; intermediated - "<<intermediated_trees_num<<"; stand - "<<terrace_trees_num<<"; dead paths - "<<dead_ends_num<<"\n";
@@ -1144,7 +1149,16 @@ void Terrace::generateTerraceTrees(Terrace *terrace, vector<Terrace*> &part_tree
     
     int j, id;
     
-    if(!node1_vec_branch.empty()){
+    if(!node1_vec_branch.empty() && count_only && taxon_to_insert == list_taxa_to_insert.size()-1){
+        // each allowed branch for the last taxon gives one tree from the stand
+        terrace_trees_num+=node1_vec_branch.size();
+        if(generation){
+            syncGeneration();
+        }else if(terrace_trees_num >= terrace_max_trees){
+            terrace_trees_num = terrace_max_trees;
+            write_warning_stop(2);
+        }
+    } else if(!node1_vec_branch.empty()){
         //cout<<"NUM_OF_ALLOWED_BRANCHES_"<<taxon_name<<"_"<<node1_vec_branch.size()<<"\n";
         //cout<<"ALL ALLOWED BRANCHES:"<<"\n";
         //for(j=0; j<node1_vec_branch.size(); j++){
@@ -1152,6 +1166,16 @@ void Terrace::generateTerraceTrees(Terrace *terrace, vector<Terrace*> &part_tree
         //}
         
         for(j=0; j<node1_vec_branch.size(); j++){
+            if(generation){
+                int stop_type;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+                stop_type = generation->stop_type;
+                if(stop_type){
+                    return;
+                }
+            }
             //cout<<"-----------------------------------"<<"\n"<<"INSERTing taxon "<<taxon_name<<" on branch "<<j+1<<" out of "<<node1_vec_branch.size()<<": "<<node1_vec_branch[j]->id<<"-"<<node2_vec_branch[j]->id<<"\n"<<"-----------------------------------"<<"\n";
             
             //id = terrace->matrix->findTaxonID(taxon_name);
@@ -1161,21 +1185,31 @@ void Terrace::generateTerraceTrees(Terrace *terrace, vector<Terrace*> &part_tree
             
             if(taxon_to_insert != list_taxa_to_insert.size()-1){
                 
-                generateTerraceTrees(terrace, part_tree_pairs, list_taxa_to_insert, taxon_to_insert+1,ordered_taxa_to_insert);
+                int queued_tasks = 0;
+                if(generation){
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+                    queued_tasks = generation->queued_tasks;
+                }
+                if(generation && queued_tasks < generation->num_threads && (int)list_taxa_to_insert.size()-taxon_to_insert-1 >= generation->min_spawn_taxa){
+                    // not enough work for idle threads: hand over the subtree below this branch
+                    vector<string> taxa_to_insert;
+                    if(ordered_taxa_to_insert){
+                        taxa_to_insert = *ordered_taxa_to_insert;
+                    }else{
+                        taxa_to_insert.insert(taxa_to_insert.end(), list_taxa_to_insert.begin()+taxon_to_insert+1, list_taxa_to_insert.end());
+                    }
+                    spawnSubproblem(taxa_to_insert);
+                } else {
+                    generateTerraceTrees(terrace, part_tree_pairs, list_taxa_to_insert, taxon_to_insert+1,ordered_taxa_to_insert);
+                }
                 
                 // INFO: IF NEXT TAXON DOES NOT HAVE ALLOWED BRANCHES CURRENT TAXON IS DELETED AND NEXT BRANCH IS EXPLORED.
                 remove_one_taxon(taxon_name,part_tree_pairs);
             } else {
                 if(terrace_out){
-                    if(trees_out_lim==0 or terrace_trees_num<trees_out_lim){
-                    //terrace_trees.push_back(getTreeTopologyString(this));
-                        
-                    //ofstream out;
-                    //out.exceptions(ios::failbit | ios::badbit);
-                    //out.open(out_file,std::ios_base::app);
-                    printTree(out, WT_BR_SCALE | WT_NEWLINE);
-                    //out.close();
-                    }
+                    writeStandTree();
                 }
                 terrace_trees_num+=1;
                 intermediated_trees_num-=1;
@@ -1183,7 +1217,9 @@ void Terrace::generateTerraceTrees(Terrace *terrace, vector<Terrace*> &part_tree
                 //    cout<<"... generated tree "<<terrace_trees_num<<"\n";
                 //}
                 //printTree(cout, WT_BR_SCALE | WT_NEWLINE);
-                if(terrace_trees_num == terrace_max_trees){
+                if(generation){
+                    syncGeneration();
+                }else if(terrace_trees_num == terrace_max_trees){
                     write_warning_stop(2);
                 }
                 remove_one_taxon(taxon_name,part_tree_pairs);
@@ -1203,6 +1239,182 @@ void Terrace::generateTerraceTrees(Terrace *terrace, vector<Terrace*> &part_tree
 
 }
 
+void Terrace::generateTerraceTreesParallel(Terrace *terrace, vector<Terrace*> &part_tree_pairs, vector<string> &list_taxa_to_insert, vector<string> *ordered_taxa_to_insert, int num_threads){
+    
+#ifdef _OPENMP
+    StandGeneration gen;
+    gen.terrace = terrace;
+    gen.init_terrace = this;
+    gen.dynamic_order = (ordered_taxa_to_insert != nullptr);
+    gen.num_threads = num_threads;
+    generation = &gen;
+    
+    // this terrace is the first worker, further subproblems are created as tasks, which are stolen by idle threads
+#pragma omp parallel num_threads(num_threads)
+#pragma omp single
+    {
+        generateTerraceTrees(terrace, part_tree_pairs, list_taxa_to_insert, 0, ordered_taxa_to_insert);
+        syncGeneration(true);
+    }
+    
+    generation = nullptr;
+    terrace_trees_num = gen.terrace_trees_num;
+    intermediated_trees_num = gen.intermediated_trees_num;
+    dead_ends_num = gen.dead_ends_num;
+    
+    if(gen.stop_type){
+        // counters are shared with a delay, report the values at which the rule was triggered
+        if(gen.stop_type == 1){
+            intermediated_trees_num = intermediate_max_trees;
+            for(const auto &p: part_tree_pairs){
+                p->unset_part_trees();
+            }
+        }else if(gen.stop_type == 2){
+            terrace_trees_num = terrace_max_trees;
+        }
+        write_warning_stop(gen.stop_type);
+    }
+#else
+    generateTerraceTrees(terrace, part_tree_pairs, list_taxa_to_insert, 0, ordered_taxa_to_insert);
+#endif
+}
+
+void Terrace::spawnSubproblem(vector<string> &taxa_to_insert){
+    
+    StandGeneration *gen = generation;
+    string tree_str = getTreeTopologyString(this);
+    vector<string> taxa = taxa_to_insert;
+    
+#ifdef _OPENMP
+#pragma omp atomic
+    gen->queued_tasks++;
+#pragma omp task firstprivate(gen, tree_str, taxa)
+#endif
+    {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        gen->queued_tasks--;
+        solveSubproblem(gen, tree_str, taxa);
+    }
+}
+
+void Terrace::solveSubproblem(StandGeneration *gen, string &tree_str, vector<string> &taxa_to_insert){
+    
+    int stop_type;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    stop_type = gen->stop_type;
+    if(stop_type){
+        return;
+    }
+    
+    // Build the initial terrace of the subproblem the same way as for the whole stand (see run_generate_trees)
+    Terrace *init_terrace = gen->init_terrace;
+    Terrace *sub_terrace;
+    vector<Terrace*> part_tree_pairs;
+    
+    // the considered terrace and its matrix are only read here, so the setup runs concurrently
+    TerraceTree tree;
+    stringstream ss(tree_str);
+    bool is_rooted = false;
+    tree.readTree(ss, is_rooted);
+    
+    vector<string> taxa_names;
+    tree.getTaxaName(taxa_names);
+    PresenceAbsenceMatrix *submatrix = new PresenceAbsenceMatrix();
+    gen->terrace->matrix->getSubPrAbMatrix(taxa_names, submatrix);
+    
+    sub_terrace = new Terrace(tree, submatrix);
+    sub_terrace->linkTrees(true, false);
+    sub_terrace->create_Top_Low_Part_Tree_Pairs(part_tree_pairs, gen->terrace, false);
+    sub_terrace->fillbrNodes();
+    
+    sub_terrace->rm_leaves = init_terrace->rm_leaves;
+    sub_terrace->master_terrace = init_terrace->master_terrace;
+    sub_terrace->terrace_out = init_terrace->terrace_out;
+    sub_terrace->trees_out_lim = init_terrace->trees_out_lim;
+    sub_terrace->count_only = init_terrace->count_only;
+    sub_terrace->terrace_max_trees = init_terrace->terrace_max_trees;
+    sub_terrace->intermediate_max_trees = init_terrace->intermediate_max_trees;
+    sub_terrace->seconds_max = init_terrace->seconds_max;
+    sub_terrace->matrix->uniq_taxa_num = init_terrace->matrix->uniq_taxa_num;
+    sub_terrace->matrix->uniq_taxa_to_insert_num = init_terrace->matrix->uniq_taxa_to_insert_num;
+    sub_terrace->generation = gen;
+    
+    vector<string> list_taxa_to_insert = taxa_to_insert;
+    sub_terrace->generateTerraceTrees(gen->terrace, part_tree_pairs, list_taxa_to_insert, 0, gen->dynamic_order ? &taxa_to_insert : nullptr);
+    sub_terrace->syncGeneration(true);
+    
+    // the low induced trees are owned by sub_terrace
+    for(const auto &p: part_tree_pairs){
+        p->induced_trees.clear();
+        delete p;
+    }
+    delete sub_terrace;
+}
+
+bool Terrace::syncGeneration(bool force){
+    
+    if(!force && ++unsynced_steps < 1000){
+        return false;
+    }
+    unsynced_steps = 0;
+    
+    StandGeneration *gen = generation;
+    bool stop;
+#ifdef _OPENMP
+#pragma omp critical(stand_generation)
+#endif
+    {
+        gen->terrace_trees_num += terrace_trees_num;
+        gen->intermediated_trees_num += intermediated_trees_num;
+        gen->dead_ends_num += dead_ends_num;
+        terrace_trees_num = 0;
+        intermediated_trees_num = 0;
+        dead_ends_num = 0;
+        
+        if(verbose_mode>=VB_MED && gen->intermediated_trees_num + gen->terrace_trees_num >= gen->next_report){
+            cout<<"... trees generated - "<<gen->intermediated_trees_num + gen->terrace_trees_num<<"; intermediated - "<<gen->intermediated_trees_num<<"; stand - "<<gen->terrace_trees_num<<"; dead paths - "<<gen->dead_ends_num<<"\n";
+            gen->next_report = (gen->intermediated_trees_num + gen->terrace_trees_num) / 100000 * 100000 + 100000;
+        }
+        
+        if(gen->stop_type == 0){
+            if(gen->intermediated_trees_num >= intermediate_max_trees){
+                gen->stop_type = 1;
+            }else if(gen->terrace_trees_num >= terrace_max_trees){
+                gen->stop_type = 2;
+            }else if(seconds_max!=-1 and getCPUTime()-Params::getInstance().startCPUTime > seconds_max){
+                gen->stop_type = 3;
+            }
+        }
+        stop = (gen->stop_type != 0);
+    }
+    return stop;
+}
+
+void Terrace::writeStandTree(){
+    
+    if(!generation){
+        if(trees_out_lim==0 or terrace_trees_num<trees_out_lim){
+            printTree(out, WT_BR_SCALE | WT_NEWLINE);
+        }
+        return;
+    }
+    
+#ifdef _OPENMP
+#pragma omp critical(stand_output)
+#endif
+    {
+        // the stand size limit is only checked at synchronisation, so also cap the output here
+        if((trees_out_lim==0 or generation->printed_trees_num<trees_out_lim) and generation->printed_trees_num<terrace_max_trees){
+            printTree(generation->init_terrace->out, WT_BR_SCALE | WT_NEWLINE);
+            generation->printed_trees_num++;
+        }
+    }
+}
+
 void Terrace::remove_one_taxon(string taxon_name, vector<Terrace*> part_tree_pairs){
     
     //cout<<"-----------------------------------"<<"\n"<<"REMOVING TAXON: "<<taxon_name<<"\n"<<"-----------------------------------"<<"\n";
@@ -1629,6 +1841,10 @@ void Terrace::write_summary_generation(){
     cout<<"Number of trees on stand: "<<terrace_trees_num<<"\n";
     cout<<"Number of intermediated trees visited: "<<intermediated_trees_num<<"\n";
     cout<<"Number of dead ends encountered: "<<dead_ends_num<<"\n";
+    double generation_time = getRealTime()-generation_start_time;
+    if(generation_start_time > 0 && generation_time > 0){
+        cout<<"Number of trees generated per second (wall-clock): "<<(int64_t)((double(terrace_trees_num)+intermediated_trees_num)/generation_time)<<"\n";
+    }
     cout<<"---------------------------------------------------------"<<"\n";
     
     // If there is an input tree (root != nullptr), try BACKWARD approach
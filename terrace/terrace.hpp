@@ -13,6 +13,67 @@
 #include "terracenode.hpp"
 #include "presenceabsencematrix.hpp"
 
+class Terrace;
+
+/*
+ *  Shared state of a parallel generation of trees from a stand
+ */
+struct StandGeneration
+{
+    /*
+     *  Considered terrace
+     */
+    Terrace *terrace{nullptr};
+    
+    /*
+     *  Initial terrace, its output stream is shared by all workers
+     */
+    Terrace *init_terrace{nullptr};
+    
+    /*
+     *  TRUE if the taxon order is adapted dynamically
+     */
+    bool dynamic_order{true};
+    
+    /*
+     *  Number of threads
+     */
+    int num_threads{1};
+    
+    /*
+     *  Number of subproblems waiting for a thread
+     */
+    int queued_tasks{0};
+    
+    /*
+     *  Minimal number of remaining taxa for a subtree to be handed over to another thread,
+     *  smaller subtrees are cheaper to finish than to set up as a sub-terrace
+     */
+    int min_spawn_taxa{4};
+    
+    /*
+     *  Type of the activated stopping rule (see write_warning_stop), 0 if none
+     */
+    int stop_type{0};
+    
+    /*
+     *  Total numbers of trees on terrace, intermediate trees and dead ends, summed over workers
+     */
+    unsigned int terrace_trees_num{0};
+    unsigned int intermediated_trees_num{0};
+    unsigned int dead_ends_num{0};
+    
+    /*
+     *  Number of trees written to the output file
+     */
+    int printed_trees_num{0};
+    
+    /*
+     *  Number of generated trees when the progress is reported next
+     */
+    unsigned int next_report{100000};
+};
+
 class Terrace: public TerraceTree
 {
 public:
@@ -24,12 +85,12 @@ public:
     /*
      * constructor
      */
-    Terrace(TerraceTree tree, PresenceAbsenceMatrix *m);
+    Terrace(TerraceTree &tree, PresenceAbsenceMatrix *m);
     
     /*
      * constructor
      */
-    Terrace(TerraceTree tree, PresenceAbsenceMatrix *m, vector<TerraceTree*> input_induced_trees);
+    Terrace(TerraceTree &tree, PresenceAbsenceMatrix *m, vector<TerraceTree*> input_induced_trees);
     
     /*
      *  constructor
@@ -99,6 +160,26 @@ public:
     unsigned int intermediate_max_trees;
     int seconds_max;
     
+    /*
+     *  TRUE to only count the trees from the stand at the last insertion step instead of generating them
+     */
+    bool count_only{false};
+    
+    /*
+     *  Shared state of a parallel generation, nullptr for sequential generation
+     */
+    StandGeneration *generation{nullptr};
+    
+    /*
+     *  Number of generation steps since the counters were added to the shared state
+     */
+    int unsynced_steps{0};
+    
+    /*
+     *  Wall-clock time when the generation started
+     */
+    double generation_start_time{0.0};
+    
     /*
      *  Print terrace info: a representative tree, induced trees and presence-absence matrix
      */
@@ -175,7 +256,7 @@ public:
      *  Prepare top-low induced partition tree pairs: induced tree from the terrace and a common subtree with the initial tree (to be modified by inserting new taxa). Top level provided by the passed terrace, low level by the current terrace (which is initial terrace).
      */
     
-    void create_Top_Low_Part_Tree_Pairs(vector<Terrace*> &part_tree_pairs, Terrace *terrace);
+    void create_Top_Low_Part_Tree_Pairs(vector<Terrace*> &part_tree_pairs, Terrace *terrace, bool check_compatibility = true);
     
     /*
      *  The main function to generate trees by recursive taxon insertion
@@ -183,6 +264,33 @@ public:
     
     void generateTerraceTrees(Terrace *terrace, vector<Terrace*> &part_tree_pairs, vector<string> &list_taxa_to_insert, int taxon_to_insert = -1,vector<string> *ordered_taxa_to_insert = nullptr);
     
+    /*
+     *  Generate trees in parallel. Threads explore independent subproblems, i.e. partial trees with the taxa still to be inserted,
+     *  each on its own copy of the terrace. A thread hands over a subproblem whenever too few subproblems are waiting for idle threads.
+     */
+    void generateTerraceTreesParallel(Terrace *terrace, vector<Terrace*> &part_tree_pairs, vector<string> &list_taxa_to_insert, vector<string> *ordered_taxa_to_insert, int num_threads);
+    
+    /*
+     *  Hand over the subproblem given by the current tree and the taxa still to be inserted to another thread
+     */
+    void spawnSubproblem(vector<string> &taxa_to_insert);
+    
+    /*
+     *  Generate all trees of a subproblem on a new copy of the terrace
+     */
+    static void solveSubproblem(StandGeneration *gen, string &tree_str, vector<string> &taxa_to_insert);
+    
+    /*
+     *  Add the counters to the shared state of a parallel generation every 1000 steps (or now, if force) and check the stopping rules
+     *  @return TRUE if the generation should stop
+     */
+    bool syncGeneration(bool force = false);
+    
+    /*
+     *  Write the current tree from the stand to the output file, unless the output limit is reached
+     */
+    void writeStandTree();
+    
     /*
      *  Get next taxon to be inserted - a taxon with the least number of allowed branches
      */
@@ -16,17 +16,8 @@ TerraceTree::TerraceTree(): MTree(){
 };
 TerraceTree::~TerraceTree(){
    
-    if(brNodes.size()>0){
-        for(int id=0; id<branchNum; id++){
-            brNodes[id]={nullptr,nullptr};
-            brNodes.erase(id);
-        }
-    }
-    if(leafNodes.size()>0){
-        for(auto t=leafNodes.begin(); t!=leafNodes.end();t++){
-            leafNodes.erase(t);
-        }
-    }
+    brNodes.clear();
+    leafNodes.clear();
 
     if (root != nullptr)
         freeNode();
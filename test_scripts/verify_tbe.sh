@@ -0,0 +1,36 @@
+#!/bin/bash
+# Known-answer check of the transfer bootstrap expectation (--tbe).
+# The supports and transfer indices in tbe_expect.tree and tbe_expect.stat were
+# computed by hand for tbe_ref.tree and the two trees in tbe_boot.trees.
+#
+# Args: $1 = IQ-TREE binary (default: build/iqtree3)
+#       $2 = output directory (default: test_scripts/test_data)
+
+IQTREE_BIN="${1:-build/iqtree3}"
+WD=test_scripts/test_data
+OUT_DIR="${2:-${WD}}"
+
+mkdir -p "${OUT_DIR}"
+
+if ! ${IQTREE_BIN} -sup ${WD}/tbe_ref.tree -t ${WD}/tbe_boot.trees --tbe-stat --prefix ${OUT_DIR}/tbe -redo > /dev/null; then
+    echo "❌ TBE run failed."
+    exit 1
+fi
+
+fail_count=0
+for ext in tree stat; do
+    if diff ${WD}/tbe_expect.${ext} ${OUT_DIR}/tbe.tbe.${ext}; then
+        echo "PASS: tbe.tbe.${ext}"
+    else
+        echo "FAIL: tbe.tbe.${ext} differs from tbe_expect.${ext}"
+        ((fail_count++))
+    fi
+done
+
+echo
+if [ "$fail_count" -eq 0 ]; then
+    echo "✅ All TBE checks passed."
+else
+    echo "❌ $fail_count TBE checks failed."
+    exit 1
+fi
@@ -0,0 +1,143 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "bootweights.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/** number of patterns processed per block in computeRELL */
+const size_t RELL_PTN_BLOCK = 512;
+
+/** number of replicates processed per block in computeRELL */
+const size_t RELL_SAMPLE_BLOCK = 8;
+
+BootWeightMatrix::BootWeightMatrix() {
+    nsamples = 0;
+    nptn = 0;
+    weights = nullptr;
+}
+
+BootWeightMatrix::~BootWeightMatrix() {
+    clear();
+}
+
+void BootWeightMatrix::init(size_t num_samples, size_t num_ptn) {
+    clear();
+    nsamples = num_samples;
+    nptn = num_ptn;
+    weights = new uint8_t[nsamples * nptn];
+    memset(weights, 0, nsamples * nptn * sizeof(uint8_t));
+    overflow.resize(nsamples);
+}
+
+void BootWeightMatrix::clear() {
+    if (weights)
+        delete [] weights;
+    weights = nullptr;
+    overflow.clear();
+    nsamples = 0;
+    nptn = 0;
+}
+
+void BootWeightMatrix::setSample(size_t sample, const IntVector &freq) {
+    ASSERT(sample < nsamples && freq.size() >= nptn);
+    uint8_t *row = weights + sample * nptn;
+    overflow[sample].clear();
+    for (size_t ptn = 0; ptn < nptn; ptn++) {
+        if (freq[ptn] > 255) {
+            row[ptn] = 255;
+            overflow[sample].push_back(make_pair((int)ptn, freq[ptn] - 255));
+        } else {
+            row[ptn] = freq[ptn];
+        }
+    }
+}
+
+void BootWeightMatrix::getSample(size_t sample, IntVector &freq) const {
+    ASSERT(sample < nsamples);
+    const uint8_t *row = weights + sample * nptn;
+    freq.resize(nptn);
+    for (size_t ptn = 0; ptn < nptn; ptn++)
+        freq[ptn] = row[ptn];
+    for (auto it = overflow[sample].begin(); it != overflow[sample].end(); it++)
+        freq[it->first] += it->second;
+}
+
+size_t BootWeightMatrix::getMemoryRequired() const {
+    size_t mem = nsamples * nptn * sizeof(uint8_t);
+    for (auto it = overflow.begin(); it != overflow.end(); it++)
+        mem += it->size() * sizeof(pair<int,int>);
+    return mem;
+}
+
+void BootWeightMatrix::computeRELL(const double *ptn_lh, size_t ntrees, size_t lh_stride,
+                                   size_t sample_start, size_t sample_end, double *rell) const
+{
+    ASSERT(sample_end <= nsamples);
+    if (sample_start >= sample_end || ntrees == 0)
+        return;
+    memset(rell, 0, (sample_end - sample_start) * ntrees * sizeof(double));
+    size_t num_blocks = (sample_end - sample_start + RELL_SAMPLE_BLOCK - 1) / RELL_SAMPLE_BLOCK;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (size_t block = 0; block < num_blocks; block++) {
+        size_t block_start = sample_start + block * RELL_SAMPLE_BLOCK;
+        size_t block_end = min(block_start + RELL_SAMPLE_BLOCK, sample_end);
+        double wbuf[RELL_PTN_BLOCK];
+
+        // the pattern log-likelihoods of one pattern block are reused by all replicates of this block
+        for (size_t ptn_start = 0; ptn_start < nptn; ptn_start += RELL_PTN_BLOCK) {
+            size_t len = min(RELL_PTN_BLOCK, nptn - ptn_start);
+            for (size_t sample = block_start; sample < block_end; sample++) {
+                const uint8_t *row = weights + sample * nptn + ptn_start;
+                for (size_t i = 0; i < len; i++)
+                    wbuf[i] = row[i];
+                double *res = rell + (sample - sample_start) * ntrees;
+                for (size_t tree = 0; tree < ntrees; tree++) {
+                    const double *lh = ptn_lh + tree * lh_stride + ptn_start;
+                    // four independent sums so that the compiler can vectorize
+                    double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+                    size_t i;
+                    for (i = 0; i + 4 <= len; i += 4) {
+                        sum0 += lh[i] * wbuf[i];
+                        sum1 += lh[i+1] * wbuf[i+1];
+                        sum2 += lh[i+2] * wbuf[i+2];
+                        sum3 += lh[i+3] * wbuf[i+3];
+                    }
+                    for (; i < len; i++)
+                        sum0 += lh[i] * wbuf[i];
+                    res[tree] += (sum0 + sum1) + (sum2 + sum3);
+                }
+            }
+        }
+
+        // add counts above 255
+        for (size_t sample = block_start; sample < block_end; sample++) {
+            double *res = rell + (sample - sample_start) * ntrees;
+            for (auto it = overflow[sample].begin(); it != overflow[sample].end(); it++)
+                for (size_t tree = 0; tree < ntrees; tree++)
+                    res[tree] += it->second * ptn_lh[tree * lh_stride + it->first];
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef BOOTWEIGHTS_H
+#define BOOTWEIGHTS_H
+
+#include <stdint.h>
+#include "utils/tools.h"
+
+/**
+    Compact matrix of bootstrap resampling counts for the RELL method,
+    one row per replicate and one column per alignment pattern.
+    Counts are stored as 8-bit integers; the rare counts above 255
+    (patterns of very high frequency) are kept as sparse per-replicate
+    corrections.
+*/
+class BootWeightMatrix {
+public:
+
+    BootWeightMatrix();
+
+    ~BootWeightMatrix();
+
+    /**
+        allocate memory for all replicates, all counts are set to 0
+        @param num_samples number of bootstrap replicates
+        @param num_ptn number of alignment patterns
+    */
+    void init(size_t num_samples, size_t num_ptn);
+
+    /** free all memory */
+    void clear();
+
+    /** @return number of replicates */
+    size_t size() const { return nsamples; }
+
+    /** @return true if no replicate was allocated */
+    bool empty() const { return nsamples == 0; }
+
+    /** @return number of patterns */
+    size_t getNPattern() const { return nptn; }
+
+    /**
+        store the resampling counts of one replicate
+        @param sample replicate ID
+        @param freq pattern counts, at least getNPattern() entries
+    */
+    void setSample(size_t sample, const IntVector &freq);
+
+    /**
+        retrieve the resampling counts of one replicate
+        @param sample replicate ID
+        @param[out] freq pattern counts
+    */
+    void getSample(size_t sample, IntVector &freq) const;
+
+    /** @return number of bytes used by this matrix */
+    size_t getMemoryRequired() const;
+
+    /**
+        compute the RELL log-likelihoods of a batch of trees for a range of replicates.
+        This is a cache-blocked product of the (ntrees x nptn) pattern log-likelihood
+        matrix and the transposed weight matrix, parallelized over replicates.
+        @param ptn_lh pattern log-likelihoods, ntrees rows of lh_stride entries
+        @param ntrees number of trees in the batch
+        @param lh_stride distance between rows of ptn_lh
+        @param sample_start first replicate
+        @param sample_end last replicate (exclusive)
+        @param[out] rell log-likelihoods, (sample-sample_start)*ntrees + tree
+    */
+    void computeRELL(const double *ptn_lh, size_t ntrees, size_t lh_stride,
+                     size_t sample_start, size_t sample_end, double *rell) const;
+
+protected:
+
+    /** number of replicates */
+    size_t nsamples;
+
+    /** number of patterns */
+    size_t nptn;
+
+    /** row-major counts, capped at 255 */
+    uint8_t *weights;
+
+    /** (pattern, count-255) for counts exceeding 255, per replicate */
+    vector<vector<pair<int,int> > > overflow;
+
+};
+
+#endif
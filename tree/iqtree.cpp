@@ -26,7 +26,9 @@
 #include "model/partitionmodelplen.h"
 #include "model/modelfactorymixlen.h"
 #include "mexttree.h"
+#include "threadtuner.h"
 #include "utils/timeutil.h"
+#include "utils/profiler.h"
 #include "model/modelmarkov.h"
 #include "model/rategamma.h"
 //#include "phylotreemixlen.h"
@@ -64,6 +66,8 @@ void IQTree::init() {
     len_scale = 10000;
 //    save_all_br_lens = false;
     duplication_counter = 0;
+    gossip_round = 0;
+    rell_batch_level = 0;
     //boot_splits = new SplitGraph;
     pll2iqtree_pattern_index = nullptr;
 
@@ -134,6 +138,8 @@ void IQTree::saveUFBoot(Checkpoint *checkpoint) {
 }
 
 void IQTree::saveCheckpoint() {
+    // RELL scores of trees collected so far must be in boot_trees/boot_logl
+    flushRELLBatch();
     stop_rule.saveCheckpoint();
     candidateTrees.saveCheckpoint();
     
@@ -297,6 +303,11 @@ void IQTree::initSettings(Params &params) {
         k_delete_stay = ceil(leafNum / k_delete);
     }
 
+    if (params.ml_spr_radius > 0 && (isSuperTree() || isMixlen() || isTreeMix() || params.pll)) {
+        outWarning("--spr-radius is not supported for partition, heterotachy and tree mixture models, using NNI only");
+        params.ml_spr_radius = 0;
+    }
+
     //tree.setIQPIterations(params.stop_condition, params.stop_confidence, params.min_iterations, params.max_iterations);
 
     stop_rule.initialize(params);
@@ -354,7 +365,8 @@ void IQTree::initSettings(Params &params) {
 //        cout << "Generating " << params.gbo_replicates << " samples for ultrafast "
 //             << RESAMPLE_NAME << " (seed: " << params.ran_seed << ")..." << endl;
         // allocate memory for boot_samples
-        boot_samples.resize(params.gbo_replicates);
+        size_t orig_nptn = getAlnNPattern();
+        boot_samples.init(params.gbo_replicates, orig_nptn);
         sample_start = 0;
         sample_end = boot_samples.size();
 
@@ -371,18 +383,6 @@ void IQTree::initSettings(Params &params) {
             }
         }
 
-        size_t orig_nptn = getAlnNPattern();
-#ifdef BOOT_VAL_FLOAT
-        size_t nptn = get_safe_upper_limit_float(orig_nptn);
-#else
-        size_t nptn = get_safe_upper_limit(orig_nptn);
-#endif
-        BootValType *mem = aligned_alloc<BootValType>(nptn * (size_t)(params.gbo_replicates));
-        memset(mem, 0, nptn * (size_t)(params.gbo_replicates) * sizeof(BootValType));
-        for (i = 0; i < params.gbo_replicates; i++) {
-            boot_samples[i] = mem + i*nptn;
-        }
-
         if (boot_trees.empty()) {
             boot_logl.resize(params.gbo_replicates, -DBL_MAX);
             boot_orig_logl.resize(params.gbo_replicates, -DBL_MAX);
@@ -403,17 +403,13 @@ void IQTree::initSettings(Params &params) {
                 }
                 IntVector this_sample;
                 bootstrap_alignment->createBootstrapAlignment(aln, &this_sample, params.bootstrap_spec);
-                for (size_t j = 0; j < orig_nptn; j++) {
-                    boot_samples[i][j] = this_sample[j];
-                }
+                boot_samples.setSample(i, this_sample);
                 bootstrap_alignment->printAlignment(params.aln_output_format, bootaln_name.c_str(), true);
                 delete bootstrap_alignment;
             } else {
                 IntVector this_sample;
                 aln->createBootstrapAlignment(this_sample, params.bootstrap_spec);
-                for (size_t j = 0; j < orig_nptn; j++) {
-                    boot_samples[i][j] = this_sample[j];
-                }
+                boot_samples.setSample(i, this_sample);
             }
         }
         verbose_mode = saved_mode;
@@ -433,10 +429,7 @@ void IQTree::initSettings(Params &params) {
         if(params.ufboot2corr){
             boot_samples_int.resize(params.gbo_replicates);
             for (size_t i = 0; i < params.gbo_replicates; i++) {
-                boot_samples_int[i].resize(nptn, 0);
-                for (size_t j = 0; j < orig_nptn; j++) {
-                    boot_samples_int[i][j] = boot_samples[i][j];
-                }
+                boot_samples.getSample(i, boot_samples_int[i]);
             }
         }
 
@@ -464,10 +457,7 @@ IQTree::~IQTree() {
     boot_splits.clear();
     //if (boot_splits) delete boot_splits;
 
-    if (!boot_samples.empty()) {
-        aligned_free(boot_samples[0]); // free memory
-        boot_samples.clear();
-    }
+    boot_samples.clear();
 }
 
 extern const char *aa_model_names_rax[];
@@ -573,6 +563,7 @@ void IQTree::createPLLPartition(Params &params, ostream &pllPartitionFileHandle)
 }
 
 void IQTree::computeInitialTree(LikelihoodKernel kernel, istream* in) {
+    PROFILE_SCOPE("initial tree");
     double start = getRealTime();
     string initTree;
     string out_file = params->out_prefix;
@@ -688,7 +679,9 @@ void IQTree::computeInitialTree(LikelihoodKernel kernel, istream* in) {
             case STT_PLL_PARSIMONY:
                 cout << endl;
                 cout << "Create initial parsimony tree by phylogenetic likelihood library (PLL)... ";
-                pllInst->randomNumberSeed = params->ran_seed + MPIHelper::getInstance().getProcessID();
+                pllInst->randomNumberSeed = params->ran_seed;
+                if (!params->mpi_patterns)
+                    pllInst->randomNumberSeed += MPIHelper::getInstance().getProcessID();
                 pllComputeRandomizedStepwiseAdditionParsimonyTree(pllInst, pllPartitions, params->sprDist);
                 resetBranches(pllInst);
                 pllTreeToNewick(pllInst->tree_string, pllInst, pllPartitions, pllInst->start->back,
@@ -2446,7 +2439,8 @@ string IQTree::optimizeBranches(int maxTraversal) {
 }
 
 double IQTree::doTreeSearch() {
-    
+    PROFILE_SCOPE("tree search");
+
     if (params->numInitTrees > 1) {
         cout << "--------------------------------------------------------------------" << endl;
         cout << "|             INITIALIZING CANDIDATE TREE SET                      |" << endl;
@@ -2525,6 +2519,8 @@ double IQTree::doTreeSearch() {
 
     // tracking of worker candidate set is changed from master candidate set
     candidateset_changed.resize(MPIHelper::getInstance().getNumProcesses(), false);
+    gossip_sent.resize(MPIHelper::getInstance().getNumProcesses());
+    gossip_iterations.resize(MPIHelper::getInstance().getNumProcesses(), 0);
     bestcandidate_changed = false;
 
     /*==============================================================================================================
@@ -2574,7 +2570,7 @@ double IQTree::doTreeSearch() {
             candidateTrees.computeSplitOccurences(Params::getInstance().stableSplitThreshold);
         }
 
-        if (MPIHelper::getInstance().isWorker() || MPIHelper::getInstance().gotMessage()) {
+        if (MPIHelper::getInstance().isWorker() || MPIHelper::getInstance().gotMessage() || useMPIGossip()) {
             syncCurrentTree();
         }
 
@@ -2650,6 +2646,12 @@ double IQTree::doTreeSearch() {
 
         // print UFBoot trees every 10 iterations
 
+        // re-tune -T AUTO if the multi-threading efficiency has changed
+        if (thread_tuner && params->thread_retune > 0 && !params->pll &&
+            stop_rule.getCurIt() % params->thread_retune == 0) {
+            thread_tuner->checkEfficiency();
+        }
+
         saveCheckpoint();
         checkpoint->dump();
 
@@ -2705,6 +2707,9 @@ double IQTree::doTreeSearch() {
     MPIHelper::getInstance().resetNumbers();
 #endif
 
+    if (verbose_mode >= VB_MED)
+        reportSiteRepeats();
+
     cout << "TREE SEARCH COMPLETED AFTER " << stop_rule.getCurIt() << " ITERATIONS"
     << " / Time: " << convert_time(getRealTime() - params->start_real_time) << endl << endl;
 
@@ -3215,6 +3220,7 @@ double IQTree::doTreePerturbation() {
  Fast Nearest Neighbor Interchange by maximum likelihood
  ****************************************************************************/
 pair<int, int> IQTree::doNNISearch(bool write_info) {
+    PROFILE_SCOPE("NNI search");
 
     computeLogL();
     double curBestScore = getBestScore();
@@ -3240,6 +3246,18 @@ pair<int, int> IQTree::doNNISearch(bool write_info) {
     } else {
         prepareToComputeDistances();
         nniInfos = optimizeNNI(Params::getInstance().speednni);
+        if (params->ml_spr_radius > 0 && !rooted && !getModel()->isSiteSpecificModel()) {
+            // SPR rounds on the NNI-optimal tree, each improvement followed by NNIs again
+            while (true) {
+                double nni_score = curScore;
+                optimizeSPRRound(params->ml_spr_radius);
+                if (curScore < nni_score + params->loglh_epsilon)
+                    break;
+                pair<int, int> spr_nni_infos = optimizeNNI(Params::getInstance().speednni);
+                nniInfos.first += spr_nni_infos.first;
+                nniInfos.second += spr_nni_infos.second;
+            }
+        }
         doneComputingDistances();
         if (isSuperTree()) {
             ((PhyloSuperTree*) this)->computeBranchLengths();
@@ -3556,7 +3574,9 @@ void IQTree::pllInitUFBootData(){
             if(!pllUFBootDataPtr->boot_samples) {
                 outError("Not enough dynamic memory!");
             }
+            IntVector this_sample;
             for(int i = 0; i < params->gbo_replicates; i++){
+                boot_samples.getSample(i, this_sample);
                 pllUFBootDataPtr->boot_samples[i] =
                     (int *) malloc(pllAlignment->sequenceLength * sizeof(int));
                 if(!pllUFBootDataPtr->boot_samples[i]) {
@@ -3564,7 +3584,7 @@ void IQTree::pllInitUFBootData(){
                 }
                 for(int j = 0; j < pllAlignment->sequenceLength; j++){
                     pllUFBootDataPtr->boot_samples[i][j] =
-                        boot_samples[i][pll2iqtree_pattern_index[j]];
+                        this_sample[pll2iqtree_pattern_index[j]];
                 }
             }
 
@@ -3723,6 +3743,8 @@ int IQTree::getDelete() const {
 }*/
 
 void IQTree::evaluateNNIs(Branches &nniBranches, vector<NNIMove>  &positiveNNIs) {
+    PROFILE_SCOPE("NNI evaluation");
+    beginRELLBatch();
     for (Branches::iterator it = nniBranches.begin(); it != nniBranches.end(); it++) {
         NNIMove nni = getBestNNIForBran((PhyloNode*) it->second.first, (PhyloNode*) it->second.second, nullptr);
         if (nni.newloglh > curScore) {
@@ -3731,10 +3753,11 @@ void IQTree::evaluateNNIs(Branches &nniBranches, vector<NNIMove>  &positiveNNIs)
 
         // synchronize tree during optimization step
         if (MPIHelper::getInstance().isMaster() && candidateset_changed.size() > 0
-            && MPIHelper::getInstance().gotMessage()) {
+            && !useMPIGossip() && MPIHelper::getInstance().gotMessage()) {
             syncCurrentTree();
         }
     }
+    endRELLBatch();
 }
 
 //Branches IQTree::getReducedListOfNNIBranches(Branches &previousNNIBranches) {
@@ -3860,41 +3883,69 @@ void IQTree::saveCurrentTree(double cur_logl) {
     if (Params::getInstance().write_intermediate_trees)
         printTree(out_treels, WT_NEWLINE | WT_BR_LEN);
 
-    int nptn = getAlnNPattern();
+    size_t nptn = getAlnNPattern();
 
-#ifdef BOOT_VAL_FLOAT
-    int maxnptn = get_safe_upper_limit_float(nptn);
-    BootValType *pattern_lh = aligned_alloc<BootValType>(maxnptn);
-    memset(pattern_lh, 0, maxnptn*sizeof(BootValType));
-    double *pattern_lh_orig = aligned_alloc<double>(nptn);
-    computePatternLikelihood(pattern_lh_orig, &cur_logl);
-    for (int i = 0; i < nptn; i++) {
-        pattern_lh[i] = (float)pattern_lh_orig[i];
-    }
-#else
-    int maxnptn = get_safe_upper_limit(nptn);
-    BootValType *pattern_lh = aligned_alloc<BootValType>(maxnptn);
-    memset(pattern_lh, 0, maxnptn*sizeof(BootValType));
+    // pattern log-likelihoods are appended to the batch and consumed in flushRELLBatch()
+    size_t batch_id = rell_batch_logl.size();
+    rell_batch_ptnlh.resize((batch_id+1) * nptn);
+    double *pattern_lh = &rell_batch_ptnlh[batch_id * nptn];
     computePatternLikelihood(pattern_lh, &cur_logl);
-#endif
-
+    rell_batch_logl.push_back(cur_logl);
 
     if (boot_samples.empty()) {
         // for runGuidedBootstrap
+        rell_batch_trees.push_back("");
     } else {
         // online bootstrap
-//        int ptn;
-//        int updated = 0;
-//        int nsamples = boot_samples.size();
         ostringstream ostr;
-        string tree_str;
         setRootNode(params->root);
         if (params->print_ufboot_trees == 2) {
             printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA + WT_BR_LEN + WT_BR_LEN_SHORT);
         } else {
             printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA);
         }
-        tree_str = ostr.str();
+        rell_batch_trees.push_back(ostr.str());
+    }
+    if (Params::getInstance().print_tree_lh) {
+        out_treelh << cur_logl;
+        double prob;
+        aln->multinomialProb(pattern_lh, prob);
+        out_treelh << "\t" << prob << endl;
+
+        IntVector pattern_index;
+        aln->getSitePatternIndex(pattern_index);
+        out_sitelh << "Site_Lh   ";
+        for (size_t i = 0; i < getAlnNSite(); ++i)
+            out_sitelh << " " << pattern_lh[pattern_index[i]];
+        out_sitelh << endl;
+    }
+
+    if (rell_batch_level == 0 || rell_batch_logl.size() >= MAX_RELL_BATCH_TREES)
+        flushRELLBatch();
+}
+
+void IQTree::beginRELLBatch() {
+    rell_batch_level++;
+}
+
+void IQTree::endRELLBatch() {
+    ASSERT(rell_batch_level > 0);
+    rell_batch_level--;
+    if (rell_batch_level == 0)
+        flushRELLBatch();
+}
+
+void IQTree::flushRELLBatch() {
+    size_t ntrees = rell_batch_logl.size();
+    if (ntrees == 0)
+        return;
+    PROFILE_SCOPE("UFBoot RELL");
+    if (!boot_samples.empty() && sample_end > sample_start) {
+        size_t nptn = getAlnNPattern();
+        ASSERT(boot_samples.getNPattern() == nptn);
+        // one blocked product for all collected trees
+        DoubleVector rell_mat((size_t)(sample_end - sample_start) * ntrees);
+        boot_samples.computeRELL(rell_batch_ptnlh.data(), ntrees, nptn, sample_start, sample_end, rell_mat.data());
 
     #ifdef _OPENMP
         int rand_seed = random_int(1000);
@@ -3907,30 +3958,24 @@ void IQTree::saveCurrentTree(double cur_logl) {
         int *rstream = randstream;
     #endif
         for (int sample = sample_start; sample < sample_end; sample++) {
-            double rell = 0.0;
-
-            {
-                // SSE optimized version of the above loop
-                BootValType *boot_sample = boot_samples[sample];
-
-                BootValType res = (this->*dotProduct)(pattern_lh, boot_sample, nptn);
-
-                rell = res;
-            }
-
-            bool better = rell > boot_logl[sample] + params->ufboot_epsilon;
-            if (!better && rell > boot_logl[sample] - params->ufboot_epsilon) {
-                better = (random_double(rstream) <= 1.0 / (boot_counts[sample] + 1));
-            }
-            if (better) {
-                if (rell <= boot_logl[sample] + params->ufboot_epsilon) {
-                    boot_counts[sample]++;
-                } else {
-                    boot_counts[sample] = 1;
+            double *sample_rell = &rell_mat[(size_t)(sample - sample_start) * ntrees];
+            // trees are visited in the order they were saved
+            for (size_t tree = 0; tree < ntrees; tree++) {
+                double rell = sample_rell[tree];
+                bool better = rell > boot_logl[sample] + params->ufboot_epsilon;
+                if (!better && rell > boot_logl[sample] - params->ufboot_epsilon) {
+                    better = (random_double(rstream) <= 1.0 / (boot_counts[sample] + 1));
+                }
+                if (better) {
+                    if (rell <= boot_logl[sample] + params->ufboot_epsilon) {
+                        boot_counts[sample]++;
+                    } else {
+                        boot_counts[sample] = 1;
+                    }
+                    boot_logl[sample] = max(boot_logl[sample], rell);
+                    boot_orig_logl[sample] = rell_batch_logl[tree];
+                    boot_trees[sample] = rell_batch_trees[tree];
                 }
-                boot_logl[sample] = max(boot_logl[sample], rell);
-                boot_orig_logl[sample] = cur_logl;
-                boot_trees[sample] = tree_str;
             }
         }
     #ifdef _OPENMP
@@ -3938,41 +3983,16 @@ void IQTree::saveCurrentTree(double cur_logl) {
         }
     #endif
     }
-    if (Params::getInstance().print_tree_lh) {
-        out_treelh << cur_logl;
-        double prob;
-#ifdef BOOT_VAL_FLOAT
-        aln->multinomialProb(pattern_lh_orig, prob);
-#else
-        aln->multinomialProb(pattern_lh, prob);
-#endif
-        out_treelh << "\t" << prob << endl;
-
-        IntVector pattern_index;
-        aln->getSitePatternIndex(pattern_index);
-        out_sitelh << "Site_Lh   ";
-        for (size_t i = 0; i < getAlnNSite(); ++i)
-            out_sitelh << " " << pattern_lh[pattern_index[i]];
-        out_sitelh << endl;
-    }
-
-    if (!boot_samples.empty()) {
-#ifdef BOOT_VAL_FLOAT
-        aligned_free(pattern_lh_orig);
-#endif
-        aligned_free(pattern_lh);
-    } else {
-#ifdef BOOT_VAL_FLOAT
-        aligned_free(pattern_lh);
-#endif
-    }
-
+    rell_batch_ptnlh.clear();
+    rell_batch_logl.clear();
+    rell_batch_trees.clear();
 }
 
 void IQTree::saveNNITrees(PhyloNode *node, PhyloNode *dad) {
     if (!node) {
         node = (PhyloNode*) root;
     }
+    beginRELLBatch();
     if (dad && !node->isLeaf() && !dad->isLeaf()) {
         double *pat_lh1 = new double[aln->getNPattern()];
         double *pat_lh2 = new double[aln->getNPattern()];
@@ -3982,6 +4002,7 @@ void IQTree::saveNNITrees(PhyloNode *node, PhyloNode *dad) {
         delete[] pat_lh1;
     }
     FOR_NEIGHBOR_IT(node, dad, it)saveNNITrees((PhyloNode*) (*it)->node, node);
+    endRELLBatch();
 }
 
 void IQTree::summarizeBootstrap(Params &params, MTreeSet &trees) {
@@ -4679,6 +4700,30 @@ void IQTree::syncCandidateTrees(int nTrees, bool updateStopRule) {
     }
 
 #ifdef _IQTREE_MPI
+    if (useMPIGossip()) {
+        // all processes exchange their best trees directly
+        MPIHelper &mpi = MPIHelper::getInstance();
+        CandidateSet cset = candidateTrees.getBestCandidateTrees(nTrees);
+        bool stop = mpi.isMaster() && updateStopRule && stop_rule.meetStopCondition(stop_rule.getCurIt(), 0.0);
+        string buf;
+        packCandidateTrees(cset, nullptr, stop, buf);
+        vector<string> all;
+        mpi.allgatherBuffer(buf, all);
+        int trees = 0;
+        for (int proc = 0; proc < mpi.getNumProcesses(); proc++) {
+            if (proc == mpi.getProcessID())
+                continue;
+            int iterations;
+            trees += unpackCandidateTrees(all[proc], proc, updateStopRule && mpi.isMaster(), stop, iterations);
+            if (proc == PROC_MASTER && stop) {
+                cout << "Worker " << mpi.getProcessID() << " gets STOP message!" << endl;
+                stop_rule.shouldStop();
+            }
+        }
+        cout << "Process " << mpi.getProcessID() << ": " << trees << " new candidate trees from other processes" << endl;
+        return;
+    }
+
     // gather trees to Master
 
     Checkpoint *ckp = new Checkpoint;
@@ -4747,7 +4792,13 @@ void IQTree::syncCurrentTree() {
     if (MPIHelper::getInstance().getNumProcesses() == 1) {
         return;
     }
+    // the bootstrap trees sent to the other processes must be up to date
+    flushRELLBatch();
 #ifdef _IQTREE_MPI
+    if (useMPIGossip()) {
+        gossipCurrentTree();
+        return;
+    }
     //------ BLOCKING COMMUNICATION ------//
     Checkpoint *checkpoint = new Checkpoint;
     string tree;
@@ -4826,6 +4877,17 @@ void IQTree::sendStopMessage() {
         return;
     }
 #ifdef _IQTREE_MPI
+    if (useMPIGossip()) {
+        if (MPIHelper::getInstance().isMaster()) {
+            cout << "Sending STOP message to workers" << endl;
+            string stop_msg(1, 1);
+            for (int w = 1; w < MPIHelper::getInstance().getNumProcesses(); w++)
+                MPIHelper::getInstance().isendBuffer(stop_msg, w, STOP_TAG);
+        }
+        finishGossip();
+        MPIHelper::getInstance().reportWaitTime("gossip");
+        return;
+    }
 
     Checkpoint *checkpoint = new Checkpoint;
     checkpoint->putBool("stop", true);
@@ -4856,6 +4918,155 @@ void IQTree::sendStopMessage() {
     delete checkpoint;
 
     MPI_Barrier(MPI_COMM_WORLD);
+    MPIHelper::getInstance().reportWaitTime("master-worker");
+#endif
+}
+
+bool IQTree::useMPIGossip() {
+    // ultrafast bootstrap needs the master to collect the bootstrap trees
+    return params->mpi_gossip && boot_samples.empty() && MPIHelper::getInstance().getNumProcesses() > 1;
+}
+
+int IQTree::packCandidateTrees(CandidateSet &cset, unordered_set<uint64_t> *sent, bool stop, string &buf) {
+    // header: stop flag and number of search iterations of this process,
+    // then per tree: score, topology hash, length and tree string
+    buf.assign(1, stop ? 1 : 0);
+    int32_t iterations = stop_rule.getCurIt();
+    buf.append((char*)&iterations, sizeof(iterations));
+    int trees = 0;
+    for (CandidateSet::reverse_iterator it = cset.rbegin(); it != cset.rend(); it++) {
+        uint64_t topo_hash = hash<string>()(it->second.topology);
+        if (sent && !sent->insert(topo_hash).second)
+            continue;
+        gossip_known.insert(topo_hash);
+        double score = it->second.score;
+        int32_t len = it->second.tree.length();
+        buf.append((char*)&score, sizeof(score));
+        buf.append((char*)&topo_hash, sizeof(topo_hash));
+        buf.append((char*)&len, sizeof(len));
+        buf.append(it->second.tree);
+        trees++;
+    }
+    return trees;
+}
+
+int IQTree::unpackCandidateTrees(const string &buf, int source, bool updateStopRule, bool &stop, int &iterations) {
+    ASSERT(buf.size() >= 1 + sizeof(int32_t));
+    const char *ptr = buf.data(), *end = buf.data() + buf.size();
+    stop = (*ptr++ != 0);
+    int32_t iter;
+    memcpy(&iter, ptr, sizeof(iter));
+    ptr += sizeof(iter);
+    iterations = iter;
+    int trees = 0;
+    while (ptr < end) {
+        double score;
+        uint64_t topo_hash;
+        int32_t len;
+        memcpy(&score, ptr, sizeof(score));
+        ptr += sizeof(score);
+        memcpy(&topo_hash, ptr, sizeof(topo_hash));
+        ptr += sizeof(topo_hash);
+        memcpy(&len, ptr, sizeof(len));
+        ptr += sizeof(len);
+        ASSERT(ptr + len <= end);
+        string tree(ptr, len);
+        ptr += len;
+        // the sender has this tree, no need to send it back
+        if ((size_t)source < gossip_sent.size())
+            gossip_sent[source].insert(topo_hash);
+        if (!gossip_known.insert(topo_hash).second)
+            continue;
+        addTreeToCandidateSet(tree, score, updateStopRule, source);
+        trees++;
+    }
+    return trees;
+}
+
+void IQTree::gossipCurrentTree() {
+#ifdef _IQTREE_MPI
+    MPIHelper &mpi = MPIHelper::getInstance();
+    int nproc = mpi.getNumProcesses();
+    string buf;
+    int source;
+    bool stop;
+    int iterations;
+    gossip_round++;
+
+    // take all trees that have arrived
+    while ((source = mpi.probeBuffer(buf, MPI_ANY_SOURCE, GOSSIP_TAG)) >= 0) {
+        double best_score = candidateTrees.getBestScore();
+        int trees = unpackCandidateTrees(buf, source, false, stop, iterations);
+        mpi.increaseTreeReceived(trees);
+        gossip_iterations[source] = max(iterations, gossip_iterations[source]);
+        if (mpi.isMaster()) {
+            // as with master-worker exchange, the stopping rule of the master only counts its own iterations
+            if (candidateTrees.getBestScore() > best_score) {
+                stop_rule.addImprovedIteration(stop_rule.getCurIt());
+                cout << "BETTER TREE FOUND at iteration " << stop_rule.getCurIt() << ": "
+                     << candidateTrees.getBestScore() << " (process " << source << ")" << endl;
+                bestcandidate_changed = true;
+            }
+        }
+    }
+    if (mpi.isWorker() && mpi.probeBuffer(buf, PROC_MASTER, STOP_TAG) >= 0) {
+        cout << "Worker " << mpi.getProcessID() << " gets STOP message!" << endl;
+        stop_rule.shouldStop();
+    }
+
+    // send the best trees not yet known by the partner, rotating over all other processes
+    int partner = (mpi.getProcessID() + 1 + gossip_round % (nproc-1)) % nproc;
+    CandidateSet cset = candidateTrees.getBestCandidateTrees(params->popSize);
+    int trees = packCandidateTrees(cset, &gossip_sent[partner], false, buf);
+    if (trees > 0) {
+        mpi.isendBuffer(buf, partner, GOSSIP_TAG);
+        mpi.increaseTreeSent(trees);
+    }
+    mpi.testSends();
+#endif
+}
+
+void IQTree::finishGossip() {
+#ifdef _IQTREE_MPI
+    MPIHelper &mpi = MPIHelper::getInstance();
+    string buf;
+    int source;
+    bool stop;
+    int iterations;
+    bool barrier_started = false;
+    double start = getRealTime();
+    gossip_iterations.resize(mpi.getNumProcesses(), 0);
+    if (mpi.isWorker()) {
+        // final iteration count for the report of the master
+        CandidateSet no_trees;
+        packCandidateTrees(no_trees, nullptr, false, buf);
+        mpi.isendBuffer(buf, PROC_MASTER, GOSSIP_TAG);
+    }
+    // sends are synchronous, thus a process enters the barrier only after all its
+    // messages were received, and no message is in flight once the barrier is completed
+    while (true) {
+        while ((source = mpi.probeBuffer(buf, MPI_ANY_SOURCE, GOSSIP_TAG)) >= 0) {
+            mpi.increaseTreeReceived(unpackCandidateTrees(buf, source, false, stop, iterations));
+            gossip_iterations[source] = max(iterations, gossip_iterations[source]);
+        }
+        while (mpi.probeBuffer(buf, MPI_ANY_SOURCE, STOP_TAG) >= 0);
+        if (!barrier_started) {
+            if (mpi.testSends()) {
+                mpi.startBarrier();
+                barrier_started = true;
+            }
+        } else if (mpi.testBarrier()) {
+            break;
+        }
+    }
+    mpi.addWaitTime(getRealTime() - start);
+    if (mpi.isMaster()) {
+        gossip_iterations[PROC_MASTER] = stop_rule.getCurIt();
+        cout << "Search iterations per process:";
+        for (int proc = 0; proc < mpi.getNumProcesses(); proc++)
+            cout << " " << proc << ":" << gossip_iterations[proc];
+        cout << endl;
+    }
 #endif
 }
 
@@ -4897,98 +5108,8 @@ int PhyloTree::testNumThreads() {
 #ifndef _OPENMP
     return 1;
 #else
-	int max_procs = min(countPhysicalCPUCores()/MPIHelper::getInstance().countSameHost(), params->num_threads_max);
-    cout << "Measuring multi-threading efficiency up to " << max_procs << " CPU cores" << endl;
-    DoubleVector runTimes;
-    int bestProc = 0;
-    double saved_curScore = curScore;
-    int num_iter = 1;
-
-    // generate different trees
-    int tree;
-    double min_time = max_procs; // minimum time in seconds
-    StrVector trees;
-    trees.push_back(getTreeString());
-    setLikelihoodKernel(sse);
-
-    initProgress(max_procs, "Determining AUTO threadcount", "tried", "threadcount");
-    for (int proc = 1; proc <= max_procs; ++proc) {
-        trackProgress(1.0);
-        omp_set_num_threads(proc);
-        setNumThreads(proc);
-        initializeAllPartialLh();
-
-        double beginTime = getRealTime();
-        double runTime, logl;
-
-        for (tree = 0; tree < trees.size(); tree++) {
-            readTreeString(trees[tree]);
-            logl = optimizeAllBranches(num_iter);
-            runTime = getRealTime() - beginTime;
-
-            // too fast, increase number of iterations
-            if (runTime*10 < min_time && proc == 1 && tree == 0) {
-                int new_num_iter = 10;
-                hideProgress();
-                cout << "Increase to " << new_num_iter << " rounds for branch lengths" << endl;
-                showProgress();
-                logl = optimizeAllBranches(new_num_iter - num_iter);
-                num_iter = new_num_iter;
-                runTime = getRealTime() - beginTime;
-            }
-
-            // considering at least 2 trees
-            if ((runTime < min_time && proc == 1) || trees.size() == 1) {
-                // time not reached, add more tree
-//                readTreeString(trees[0]);
-//                doRandomNNIs();
-                if (params->tree_gen!=NONE)
-                    generateRandomTree(params->tree_gen);
-                else
-                    generateRandomTree(YULE_HARDING);
-                wrapperFixNegativeBranch(true);
-                trees.push_back(getTreeString());
-            }
-            curScore = saved_curScore;
-        }
-
-        if (proc == 1) {
-            hideProgress();
-            cout << trees.size() << " trees examined" << endl;
-            showProgress();
-        }
-
-        deleteAllPartialLh();
-
-        runTimes.push_back(runTime);
-        double speedup = runTimes[0] / runTime;
-
-        hideProgress();
-        cout << "Threads: " << proc << " / Time: " << runTime << " sec / Speedup: " << speedup
-            << " / Efficiency: " << (int)round(speedup*100/proc) << "% / LogL: " << (int)logl << endl;
-        showProgress();
-
-        // break if too bad efficiency ( < 50%) or worse than than 10% of the best run time
-        if (speedup*2 <= proc || (runTime > runTimes[bestProc]*1.1 && proc>1)) {
-            break;
-        }
-
-        // update best threads if sufficient
-        if (runTime <= runTimes[bestProc]*0.95) {
-            bestProc = proc-1;
-        }
-    }
-    doneProgress();
-    readTreeString(trees[0]);
-
-    cout << "BEST NUMBER OF THREADS: " << bestProc+1 << endl << endl;
-    setNumThreads(bestProc+1);
-    
-    // clear the relative treelength arrays if it is GHOST model
-    if (isMixlen()) {
-        ((PhyloTreeMixlen*)this)->clear_relative_treelen();
-    }
-
-    return bestProc+1;
+    delete thread_tuner;
+    thread_tuner = new ThreadTuner(this);
+    return thread_tuner->tune();
 #endif
 }
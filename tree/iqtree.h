@@ -26,18 +26,23 @@
 #include <map>
 #include <stack>
 #include <vector>
+#include <unordered_set>
 #include "phylotree.h"
 #include "phylonode.h"
 #include "utils/stoprule.h"
 #include "mtreeset.h"
 #include "node.h"
 #include "candidateset.h"
+#include "bootweights.h"
 #include "utils/pllnni.h"
 
 typedef std::map< string, double > mapString2Double;
 typedef std::multiset< double, std::less< double > > multiSetDB;
 typedef std::multiset< int, std::less< int > > MultiSetInt;
 
+/** maximum number of trees whose UFBoot RELL scores are computed together */
+const size_t MAX_RELL_BATCH_TREES = 16;
+
 class RepLeaf {
 public:
     Node *leaf;
@@ -704,6 +709,45 @@ public:
     */
     void sendStopMessage();
 
+    /**
+        MPI: TRUE if candidate trees are exchanged by non-blocking gossip (--mpi-gossip),
+        not available with ultrafast bootstrap
+    */
+    bool useMPIGossip();
+
+    /**
+        MPI: encode candidate trees into a compact binary buffer
+        @param cset candidate trees
+        @param sent topology hashes already sent to the destination, trees in it are skipped
+               and the new ones added; nullptr to encode all trees
+        @param stop stop signal for the receivers
+        @param[out] buf binary buffer
+        @return number of encoded trees
+    */
+    int packCandidateTrees(CandidateSet &cset, unordered_set<uint64_t> *sent, bool stop, string &buf);
+
+    /**
+        MPI: add candidate trees from a buffer encoded by packCandidateTrees,
+        skipping trees with topologies already known
+        @param buf binary buffer
+        @param source process that sent the buffer
+        @param updateStopRule true to update stopping rule for each tree
+        @param[out] stop stop signal of the sender
+        @param[out] iterations number of search iterations done by the sender
+        @return number of new trees
+    */
+    int unpackCandidateTrees(const string &buf, int source, bool updateStopRule, bool &stop, int &iterations);
+
+    /**
+        MPI gossip: receive arrived trees and send the best trees to the next partner without waiting
+    */
+    void gossipCurrentTree();
+
+    /**
+        MPI gossip: receive pending trees until all processes finished their sends
+    */
+    void finishGossip();
+
     /**
      *  Generate the initial parsimony/random trees, called by initCandidateTreeSet
      *  @param nParTrees number of parsimony/random trees to generate
@@ -771,8 +815,8 @@ public:
     /** log-likelihood threshold (l_min) */
     double logl_cutoff;
 
-    /** vector of bootstrap alignments generated */
-    vector<BootValType* > boot_samples;
+    /** resampling counts of bootstrap alignments generated */
+    BootWeightMatrix boot_samples;
 
     /** starting sample for UFBoot, used for MPI */
     int sample_start;
@@ -867,6 +911,30 @@ protected:
 
     virtual void saveCurrentTree(double logl) override; // save current tree
 
+    /**
+        start collecting trees passed to saveCurrentTree, whose RELL scores are
+        then computed together in endRELLBatch(). Calls can be nested.
+    */
+    void beginRELLBatch();
+
+    /** compute RELL scores for all collected trees and update boot_trees */
+    void endRELLBatch();
+
+    /** update UFBoot replicates with the trees collected so far */
+    void flushRELLBatch();
+
+    /** nesting level of beginRELLBatch() */
+    int rell_batch_level;
+
+    /** pattern log-likelihoods of collected trees, one row of getAlnNPattern() per tree */
+    DoubleVector rell_batch_ptnlh;
+
+    /** log-likelihoods of collected trees */
+    DoubleVector rell_batch_logl;
+
+    /** NEWICK strings of collected trees */
+    StrVector rell_batch_trees;
+
 
     void saveNNITrees(PhyloNode *node = nullptr, PhyloNode *dad = nullptr);
 
@@ -878,6 +946,18 @@ protected:
     // true if best candidate tree is changed
     bool bestcandidate_changed;
 
+    // MPI gossip: topology hashes of trees already sent to or received from each process
+    vector<unordered_set<uint64_t> > gossip_sent;
+
+    // MPI gossip: topology hashes of all trees exchanged by this process
+    unordered_set<uint64_t> gossip_known;
+
+    // MPI gossip: number of gossip rounds, used to rotate the partner
+    int gossip_round;
+
+    // MPI gossip: last reported number of search iterations of each process
+    IntVector gossip_iterations;
+
     /**
             number of IQPNNI iterations
      */
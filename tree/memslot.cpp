@@ -21,6 +21,7 @@
 
 #include "tree/phylotree.h"
 #include "memslot.h"
+#include "utils/profiler.h"
 
 const int MEM_LOCKED = 1;
 const int MEM_SPECIAL = 2;
@@ -162,6 +163,7 @@ int MemSlotVector::allocate(PhyloNeighbor *nei) {
 
     // clear mem assigned to it->nei
     best->nei->clearPartialLh();
+    Profiler::count(PC_MEM_EVICT);
 
     // assign mem to nei
     addNei(nei, best);
@@ -192,7 +194,7 @@ void MemSlotVector::cleanup() {
     unordered_map<PhyloNeighbor*, iterator> new_map;
     for (auto it = nei_id_map.begin(); it != nei_id_map.end(); it++)
         if (it->first != it->second->nei) {
-            it->first->partial_lh_computed &= ~1; // clear bit
+            it->first->partial_lh_computed &= ~(1 | LH_DIRTY); // clear bit
             it->first->partial_lh = nullptr;
             it->first->scale_num = nullptr;
         } else {
@@ -209,7 +211,7 @@ void MemSlotVector::takeover(PhyloNeighbor *nei, PhyloNeighbor *taken_nei) {
     nei->scale_num = taken_nei->scale_num;
     taken_nei->partial_lh = nullptr;
     taken_nei->scale_num = nullptr;
-    taken_nei->partial_lh_computed &= ~1; // clear bit
+    taken_nei->partial_lh_computed &= ~(1 | LH_DIRTY); // clear bit
     if (Params::getInstance().lh_mem_save != LM_MEM_SAVE)
         return;
     iterator id = findNei(taken_nei);
@@ -222,6 +224,33 @@ void MemSlotVector::takeover(PhyloNeighbor *nei, PhyloNeighbor *taken_nei) {
     }
 }
 
+void MemSlotVector::swapNei(PhyloNeighbor *nei1, PhyloNeighbor *nei2) {
+    std::swap(nei1->partial_lh, nei2->partial_lh);
+    std::swap(nei1->scale_num, nei2->scale_num);
+    nei1->partial_lh_computed &= ~(1 | LH_DIRTY); // clear bit
+    nei2->partial_lh_computed &= ~(1 | LH_DIRTY); // clear bit
+    if (Params::getInstance().lh_mem_save != LM_MEM_SAVE)
+        return;
+    auto it1 = nei_id_map.find(nei1);
+    auto it2 = nei_id_map.find(nei2);
+    int id1 = (it1 != nei_id_map.end()) ? it1->second : -1;
+    int id2 = (it2 != nei_id_map.end()) ? it2->second : -1;
+    if (id1 >= 0)
+        nei_id_map.erase(it1);
+    if (id2 >= 0)
+        nei_id_map.erase(it2);
+    if (id1 >= 0) {
+        nei_id_map[nei2] = id1;
+        if (at(id1).nei == nei1)
+            at(id1).nei = nei2;
+    }
+    if (id2 >= 0) {
+        nei_id_map[nei1] = id2;
+        if (at(id2).nei == nei2)
+            at(id2).nei = nei1;
+    }
+}
+
 void MemSlotVector::replace(PhyloNeighbor *new_nei, PhyloNeighbor *old_nei) {
     if (Params::getInstance().lh_mem_save != LM_MEM_SAVE)
         return;
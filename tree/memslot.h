@@ -81,6 +81,9 @@ public:
     /** take over neighbor from another one */
     void takeover(PhyloNeighbor *nei, PhyloNeighbor *taken_nei);
 
+    /** exchange the vectors and memory slots of two neighbors, used for SPR */
+    void swapNei(PhyloNeighbor *nei1, PhyloNeighbor *nei2);
+
     /** add special neihbor e.g. for NNI */
     void addSpecialNei(PhyloNeighbor *nei);
 
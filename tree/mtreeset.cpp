@@ -443,64 +443,71 @@ void MTreeSet::convertSplits(vector<string> &taxname, SplitGraph &sg, SplitIntMa
 	}*/
 
 
-	SplitGraph *isg;
-	int tree_id = 0;
-//	cout << "Number of trees: " << size() << endl;
-//	cout << "Number of weight: " << tree_weights.size() << endl;
-	for (iterator it = begin(); it != end(); it++, tree_id++) {
-		if (tree_weights[tree_id] == 0) continue;
-		MTree *tree = *it;
-
-		if (tree->leafNum != taxname.size())
-			outError("Tree has different number of taxa!");
-		if (sort_taxa) {
-			NodeVector taxa;
-			tree->getTaxa(taxa);
-			sort(taxa.begin(), taxa.end(), nodenamecmp);
-			int i = 0;
-			for (NodeVector::iterator it2 = taxa.begin(); it2 != taxa.end(); it2++) {
-				if ((*it2)->name != taxname[i]) {
-					cout << "Name 1: " <<  (*it2)->name << endl;
-					cout << "Name 2: " <<  taxname[i] << endl;
-					outError("Tree has different taxa names!");
+	// splits are identified by fingerprints; a Split is only created for the first occurrence
+	SplitFingerprinter fingerprinter(taxname.size());
+	unordered_map<SplitFingerprint, pair<Split*, int>, SplitFingerprintHash> fp_split;
+	const int batch_size = 64;
+	vector<SplitFingerprintVector> fps_vec(batch_size);
+	vector<DoubleVector> lengths_vec(batch_size);
+	vector<BranchVector> branches_vec(batch_size);
+	for (int batch_start = 0; batch_start < size(); batch_start += batch_size) {
+		int batch_end = min(batch_start + batch_size, (int)size());
+		for (int tree_id = batch_start; tree_id < batch_end; tree_id++) {
+			if (tree_weights[tree_id] == 0) continue;
+			MTree *tree = at(tree_id);
+			if (tree->leafNum != taxname.size())
+				outError("Tree has different number of taxa!");
+			if (sort_taxa) {
+				NodeVector taxa;
+				tree->getTaxa(taxa);
+				sort(taxa.begin(), taxa.end(), nodenamecmp);
+				int i = 0;
+				for (NodeVector::iterator it2 = taxa.begin(); it2 != taxa.end(); it2++) {
+					if ((*it2)->name != taxname[i]) {
+						cout << "Name 1: " <<  (*it2)->name << endl;
+						cout << "Name 2: " <<  taxname[i] << endl;
+						outError("Tree has different taxa names!");
+					}
+					(*it2)->id = i++;
 				}
-				(*it2)->id = i++;
 			}
 		}
-		isg = new SplitGraph();
-		tree->convertSplits(taxname, *isg);
-		//isg->getTaxa()->Report(cout);
-		//isg->report(cout);
-		for (itg = isg->begin(); itg != isg->end(); itg++) {
-			//SplitIntMap::iterator ass_it = hash_ss.find(*itg);
-			int value;
-			//if ((*itg)->getWeight()==0.0) cout << "zero weight!" << endl;
-			Split *sp = hash_ss.findSplit(*itg, value);
-			if (sp != nullptr) {
-				//Split *sp = ass_it->first;
-				if (weighting_type != SW_COUNT)
-					sp->setWeight(sp->getWeight() + (*itg)->getWeight() * tree_weights[tree_id]);
-				else
-					sp->setWeight(sp->getWeight() + tree_weights[tree_id]);
-				hash_ss.setValue(sp, value + tree_weights[tree_id]);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int tree_id = batch_start; tree_id < batch_end; tree_id++)
+			if (tree_weights[tree_id] != 0)
+				fingerprinter.computeFingerprints(at(tree_id), fps_vec[tree_id - batch_start],
+					&lengths_vec[tree_id - batch_start], &branches_vec[tree_id - batch_start]);
+
+		for (int tree_id = batch_start; tree_id < batch_end; tree_id++) {
+			if (tree_weights[tree_id] == 0) continue;
+			SplitFingerprintVector &fps = fps_vec[tree_id - batch_start];
+			DoubleVector &lengths = lengths_vec[tree_id - batch_start];
+			BranchVector &branches = branches_vec[tree_id - batch_start];
+			for (size_t i = 0; i < fps.size(); i++) {
+				double weight = (weighting_type != SW_COUNT) ? lengths[i] * tree_weights[tree_id] : tree_weights[tree_id];
+				auto fp_it = fp_split.find(fps[i]);
+				Split *sp;
+				if (fp_it != fp_split.end()) {
+					sp = fp_it->second.first;
+					sp->setWeight(sp->getWeight() + weight);
+					fp_it->second.second += tree_weights[tree_id];
+				} else {
+					sp = new Split(taxname.size(), weight);
+					at(tree_id)->getTaxa(*sp, branches[i].second, branches[i].first);
+					if (sp->shouldInvert())
+						sp->invert();
+					sg.push_back(sp);
+					fp_split[fps[i]] = make_pair(sp, tree_weights[tree_id]);
+				}
+				if (tag_str)
+					sp->name += "@" + convertIntToString(tree_id+1);
 			}
-			else {
-				sp = new Split(*(*itg));
-				if (weighting_type != SW_COUNT)
-					sp->setWeight((*itg)->getWeight() * tree_weights[tree_id]);
-				else				
-					sp->setWeight(tree_weights[tree_id]);
-				sg.push_back(sp);
-				//SplitIntMap::value_type spair(sp, 1);
-				//hash_ss.insert(spair);
-				
-				hash_ss.insertSplit(sp, tree_weights[tree_id]);
- 			}
-            if (tag_str)
-                sp->name += "@" + convertIntToString(tree_id+1);
 		}
-		delete isg;
 	}
+	for (auto fp_it = fp_split.begin(); fp_it != fp_split.end(); fp_it++)
+		hash_ss.insertSplit(fp_it->second.first, fp_it->second.second);
 
 	if (weighting_type == SW_AVG_PRESENT) {
 		for (itg = sg.begin(); itg != sg.end(); itg++) {
@@ -544,65 +551,49 @@ void MTreeSet::computeRFDist(double *rfdist, int mode, double weight_threshold)
 	// exit if less than 2 trees
 	if (size() < 2)
 		return;
-    if (verbose_mode >= VB_MED) {
-#ifdef USE_HASH_MAP
-	cout << "Using hash_map" << endl;
-#else
-	cout << "Using map" << endl;
-#endif
-    }
 	cout << "Computing Robinson-Foulds distance..." << endl;
 
-	vector<string> taxname(front()->leafNum);
-	vector<SplitIntMap*> hs_vec;
-	vector<SplitGraph*> sg_vec;
-
-	front()->getTaxaName(taxname);
-
-
-	// converting trees into split system then stored in SplitIntMap for efficiency
-	for (iterator it = begin(); it != end(); it++) {
-		SplitGraph *sg = new SplitGraph();
-		SplitIntMap *hs = new SplitIntMap();
-
-		(*it)->convertSplits(taxname, *sg);
-		// make sure that taxon 0 is included
-		for (SplitGraph::iterator sit = sg->begin(); sit != sg->end(); sit++) {
-			if (!(*sit)->containTaxon(0)) (*sit)->invert();
-			hs->insertSplit((*sit), 1);
-		}
-		hs_vec.push_back(hs);
-		sg_vec.push_back(sg);
-	}
+	// sorted split fingerprints of each tree
+	vector<SplitFingerprintVector> fps_vec;
+	computeFingerprints(fps_vec, weight_threshold);
 
 	// now start the RF computation
-	int id = 0;
-	for (vector<SplitIntMap*>::iterator hsit = hs_vec.begin(); hsit+1 != hs_vec.end(); hsit++, id++) {
-		vector<SplitIntMap*>::iterator end_it = hs_vec.end();
-		if (mode == RF_ADJACENT_PAIR) end_it = hsit+2;
-		int id2 = id+1;
-		for (vector<SplitIntMap*>::iterator hsit2 = hsit+1; hsit2 != end_it; hsit2++, id2++) {
-			int diff_splits = 0;
-			SplitIntMap::iterator spit;
-			for (spit = (*hsit2)->begin(); spit != (*hsit2)->end(); spit++) {
-				if (spit->first->getWeight() >= weight_threshold && !(*hsit)->findSplit(spit->first)) diff_splits++;
-			}
-			for (spit = (*hsit)->begin(); spit != (*hsit)->end(); spit++) {
-				if (spit->first->getWeight() >= weight_threshold && !(*hsit2)->findSplit(spit->first)) diff_splits++;
-			}
-			//int rf_val = (*hsit)->size() + (*hsit2)->size() - 2*common_splits;
-			int rf_val = diff_splits;
-			if (mode == RF_ADJACENT_PAIR) 
+	int ntrees = size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int id = 0; id < ntrees-1; id++) {
+		int end_id = (mode == RF_ADJACENT_PAIR) ? id+2 : ntrees;
+		for (int id2 = id+1; id2 < end_id; id2++) {
+			int rf_val = SplitFingerprinter::countDifferentSplits(fps_vec[id], fps_vec[id2]);
+			if (mode == RF_ADJACENT_PAIR)
 				rfdist[id] = rf_val;
 			else {
 				rfdist[id*size() + id2] = rfdist[id2*size() + id] = rf_val;
 			}
 		}
 	}
-	// delete memory 
-	for (id = size()-1; id >= 0; id--) {
-		delete hs_vec[id];
-		delete sg_vec[id];
+}
+
+void MTreeSet::computeFingerprints(vector<SplitFingerprintVector> &fps_vec, double weight_threshold, int start) {
+	int ntrees = size() - start;
+	fps_vec.resize(ntrees);
+	if (ntrees == 0)
+		return;
+	for (int id = 0; id < ntrees; id++)
+		if (at(start + id)->leafNum != front()->leafNum)
+			outError("Tree has different number of taxa!");
+	SplitFingerprinter fingerprinter(front()->leafNum);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int id = 0; id < ntrees; id++) {
+		MTree *tree = at(start + id);
+		DoubleVector lengths;
+		fingerprinter.computeFingerprints(tree, fps_vec[id], &lengths);
+		for (size_t i = 0; i < lengths.size(); i++)
+			fps_vec[id][i].setCounted(lengths[i] >= weight_threshold);
+		SplitFingerprinter::sortFingerprints(fps_vec[id]);
 	}
 }
 
@@ -618,6 +609,34 @@ void MTreeSet::computeRFDist(double *rfdist, MTreeSet *treeset2, bool k_by_k,
 	cout << "Using map" << endl;
 #endif
     }
+	if (!info_file && !tree_file && !incomp_splits) {
+		// only distances needed: compare sorted split fingerprints
+		vector<SplitFingerprintVector> fps_vec, fps_vec2;
+		computeFingerprints(fps_vec);
+		if (treeset2->front()->leafNum != front()->leafNum)
+			outError("Tree has different number of taxa!");
+		treeset2->computeFingerprints(fps_vec2);
+		int ntrees = size(), ntrees2 = treeset2->size();
+		int ntaxa = front()->leafNum;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int id = 0; id < ntrees; id++) {
+			int start_id = k_by_k ? id : 0;
+			int end_id = k_by_k ? id+1 : ntrees2;
+			for (int id2 = start_id; id2 < end_id; id2++) {
+				double rf_val = SplitFingerprinter::countDifferentSplits(fps_vec[id], fps_vec2[id2]);
+				if (Params::getInstance().normalize_tree_dist)
+					rf_val /= (fps_vec[id].size() - ntaxa) + (fps_vec2[id2].size() - ntaxa);
+				if (k_by_k)
+					rfdist[id] = rf_val;
+				else
+					rfdist[(id*ntrees2) + id2] = rf_val;
+			}
+		}
+		return;
+	}
+
 	ofstream oinfo;
 	ofstream otree;
 	if (info_file) oinfo.open(info_file);
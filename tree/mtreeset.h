@@ -21,6 +21,7 @@
 #define MTREESET_H
 
 #include "mtree.h"
+#include "splitfingerprint.h"
 #include "pda/splitgraph.h"
 #include "alignment/alignment.h"
 
@@ -174,6 +175,14 @@ public:
 	void computeRFDist(double *rfdist, MTreeSet *treeset2, bool k_by_k,
 		const char* info_file = nullptr, const char *tree_file = nullptr, double *incomp_splits = nullptr);
 
+	/**
+		compute the sorted split fingerprints of the trees in parallel
+		@param[out] fps_vec fingerprints of each tree
+		@param weight_threshold splits with smaller weight are not counted for distances
+		@param start ID of the first tree
+	*/
+	void computeFingerprints(vector<SplitFingerprintVector> &fps_vec, double weight_threshold = -1000, int start = 0);
+
 	int categorizeDistinctTrees(IntVector &category);
 
 	int sumTreeWeights();
@@ -142,7 +142,7 @@ void PhyloTree::computePartialLikelihoodEigenSIMD(PhyloNeighbor *dad_branch, Phy
                 dad_branch->scale_num = backnei->scale_num;
                 backnei->partial_lh = nullptr;
                 backnei->scale_num = nullptr;
-                backnei->partial_lh_computed &= ~1; // clear bit
+                backnei->partial_lh_computed &= ~(1 | LH_DIRTY); // clear bit
                 done = true;
                 break;
             }
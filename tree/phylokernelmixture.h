@@ -83,7 +83,7 @@ void PhyloTree::computeMixturePartialLikelihoodEigenSIMD(PhyloNeighbor *dad_bran
                 dad_branch->scale_num = backnei->scale_num;
                 backnei->partial_lh = NULL;
                 backnei->scale_num = NULL;
-                backnei->partial_lh_computed &= ~1; // clear bit
+                backnei->partial_lh_computed &= ~(1 | LH_DIRTY); // clear bit
                 done = true;
                 break;
             }
@@ -18,6 +18,7 @@
 #endif
 
 #include "phylotree.h"
+#include "utils/profiler.h"
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -313,6 +314,120 @@ inline void dotProductDualVec(Numeric *A, VectorClass *B, Numeric *C, VectorClas
     }
 }
 
+#ifndef KERNEL_FIX_STATES
+/** minimal number of states to use the register-blocked vector-matrix product */
+const size_t BLOCKED_PRODUCT_MIN_STATES = 32;
+
+/**
+    register-blocked product of a vector A and a matrix M for large state spaces (codon, PoMo):
+    X[i] = A[0]*M[i,0] + ... + A[N-1]*M[i,N-1], for all i = 0,...,N-1
+    two rows of M are computed together so that each element of A is loaded once per row pair
+    template COMPUTE_MAX = true to also update Xmax
+    @param N number of elements
+    @param A input vector of size N
+    @param M input matrix of size N*N
+    @param[out] X output vector of size N
+    @param[in/out] Xmax max of Xmax and |X[i]|, only if COMPUTE_MAX
+*/
+template <class VectorClass, class Numeric, const bool COMPUTE_MAX>
+inline void productVecMatBlocked(VectorClass *A, Numeric *M, VectorClass *X, VectorClass &Xmax, size_t N)
+{
+    const size_t N4 = N & ~(size_t)3;
+    size_t i, j, x;
+    for (i = 0; i+1 < N; i += 2) {
+        Numeric *M2 = M + N;
+        VectorClass V[4], W[4];
+        for (j = 0; j < 4; j++) {
+            V[j] = A[j] * M[j];
+            W[j] = A[j] * M2[j];
+        }
+        for (x = 4; x < N4; x += 4) {
+            for (j = 0; j < 4; j++) {
+                V[j] = mul_add(A[x+j], M[x+j], V[j]);
+                W[j] = mul_add(A[x+j], M2[x+j], W[j]);
+            }
+        }
+        VectorClass v = (V[0]+V[1])+(V[2]+V[3]);
+        VectorClass w = (W[0]+W[1])+(W[2]+W[3]);
+        for (x = N4; x < N; x++) {
+            v = mul_add(A[x], M[x], v);
+            w = mul_add(A[x], M2[x], w);
+        }
+        X[i] = v;
+        X[i+1] = w;
+        if (COMPUTE_MAX)
+            Xmax = max(Xmax, max(abs(v), abs(w)));
+        M += 2*N;
+    }
+    if (i < N) {
+        // last row for odd number of states
+        VectorClass V[4];
+        for (j = 0; j < 4; j++)
+            V[j] = A[j] * M[j];
+        for (x = 4; x < N4; x += 4)
+            for (j = 0; j < 4; j++)
+                V[j] = mul_add(A[x+j], M[x+j], V[j]);
+        VectorClass v = (V[0]+V[1])+(V[2]+V[3]);
+        for (x = N4; x < N; x++)
+            v = mul_add(A[x], M[x], v);
+        X[i] = v;
+        if (COMPUTE_MAX)
+            Xmax = max(Xmax, abs(v));
+    }
+}
+
+/**
+    register-blocked dual product for large state spaces (codon, PoMo):
+    X[i] = (MA[i,0]*A[0] + ... + MA[i,N-1]*A[N-1]) * (MC[i,0]*C[0] + ... + MC[i,N-1]*C[N-1])
+    for all i = 0,...,N-1, two rows at a time so that A and C are loaded once per row pair
+    @param N number of elements
+    @param MA first matrix of size N*N
+    @param A first vector of size N
+    @param MC second matrix of size N*N
+    @param C second vector of size N
+    @param[out] X output vector of size N
+*/
+template <class VectorClass, class Numeric>
+inline void productDualMatVecBlocked(Numeric *MA, VectorClass *A, Numeric *MC, VectorClass *C, VectorClass *X, size_t N)
+{
+    const size_t N4 = N & ~(size_t)3;
+    size_t i, j, x;
+    for (i = 0; i < N; i += 2) {
+        // the second row of the pair repeats the first one for odd N
+        size_t i2 = (i+1 < N) ? i+1 : i;
+        Numeric *MA1 = MA + i*N, *MA2 = MA + i2*N;
+        Numeric *MC1 = MC + i*N, *MC2 = MC + i2*N;
+        VectorClass AB1[4], AB2[4], CD1[4], CD2[4];
+        for (j = 0; j < 4; j++) {
+            AB1[j] = MA1[j] * A[j];
+            AB2[j] = MA2[j] * A[j];
+            CD1[j] = MC1[j] * C[j];
+            CD2[j] = MC2[j] * C[j];
+        }
+        for (x = 4; x < N4; x += 4) {
+            for (j = 0; j < 4; j++) {
+                AB1[j] = mul_add(MA1[x+j], A[x+j], AB1[j]);
+                AB2[j] = mul_add(MA2[x+j], A[x+j], AB2[j]);
+                CD1[j] = mul_add(MC1[x+j], C[x+j], CD1[j]);
+                CD2[j] = mul_add(MC2[x+j], C[x+j], CD2[j]);
+            }
+        }
+        VectorClass ab1 = (AB1[0]+AB1[1])+(AB1[2]+AB1[3]);
+        VectorClass ab2 = (AB2[0]+AB2[1])+(AB2[2]+AB2[3]);
+        VectorClass cd1 = (CD1[0]+CD1[1])+(CD1[2]+CD1[3]);
+        VectorClass cd2 = (CD2[0]+CD2[1])+(CD2[2]+CD2[3]);
+        for (x = N4; x < N; x++) {
+            ab1 = mul_add(MA1[x], A[x], ab1);
+            ab2 = mul_add(MA2[x], A[x], ab2);
+            cd1 = mul_add(MC1[x], C[x], cd1);
+            cd2 = mul_add(MC2[x], C[x], cd2);
+        }
+        X[i] = ab1 * cd1;
+        X[i2] = ab2 * cd2;
+    }
+}
+#endif
+
 /**
     compute product of a vector A and a matrix M, resulting in a vector X:
     X[i] = A[0]*M[i,0] + ... + A[N-1]*M[i,N-1], for all i = 0,...,N-1
@@ -330,6 +445,11 @@ template <class VectorClass, class Numeric, const bool FMA>
 inline void productVecMat(VectorClass *A, Numeric *M, VectorClass *X, size_t N)
 #endif
 {
+    if (N >= BLOCKED_PRODUCT_MIN_STATES) {
+        VectorClass Xmax;
+        productVecMatBlocked<VectorClass, Numeric, false>(A, M, X, Xmax, N);
+        return;
+    }
     if (N==4) {
         // manual unrolling
         X[0] = mul_add(A[1],M[1],  A[0]*M[0])  + mul_add(A[3],M[3],  A[2]*M[2]);
@@ -455,6 +575,10 @@ template <class VectorClass, class Numeric, const bool FMA>
 inline void productVecMat(VectorClass *A, Numeric *M, VectorClass *X, VectorClass &Xmax, size_t N)
 #endif
 {
+    if (N >= BLOCKED_PRODUCT_MIN_STATES) {
+        productVecMatBlocked<VectorClass, Numeric, true>(A, M, X, Xmax, N);
+        return;
+    }
     if (N==4) {
         // manual unrolling
         X[0] = mul_add(A[1],M[1],A[0]*M[0])   + mul_add(A[3],M[3],A[2]*M[2]);
@@ -1010,6 +1134,8 @@ void PhyloTree::computePartialInfo(TraversalInfo &info, VectorClass* buffer, dou
     } // END non-reversible model
 
     //----------- Reversible model --------------
+    // transition matrices of the children in eigen space
+    Profiler::count(PC_TRANS_MATRIX, ncat_mix * (node->degree() - 1));
     if (nstates % VectorClass::size() == 0) {
         // vectorized version
         VectorClass *expchild = (VectorClass*)buffer;
@@ -1242,7 +1368,17 @@ void PhyloTree::computeTraversalInfo(PhyloNode *node, PhyloNode *dad, bool compu
             cout << endl;
         }
 
-        
+        // children come before their dad in traversal_info
+        if (params->site_repeats && model->useRevKernel() && !traversal_info.empty()) {
+            updateSiteRepeatStamp();
+            for (auto it = traversal_info.begin(); it != traversal_info.end(); it++) {
+                computeSiteRepeats(it->dad_branch, it->dad);
+                IntVector &block_src = it->dad_branch->repeat_block_src;
+                site_repeat_blocks += block_src.size();
+                site_repeat_skipped_blocks += block_src.size() - count(block_src.begin(), block_src.end(), -1);
+            }
+        }
+
         if (!Params::getInstance().buffer_mem_save) {
 #ifdef _OPENMP
 #pragma omp parallel if (num_info >= 3) num_threads(num_threads)
@@ -1284,6 +1420,43 @@ void PhyloTree::computeTraversalInfo(PhyloNode *node, PhyloNode *dad, bool compu
     return;
 }
 
+#ifndef KERNEL_FIX_STATES
+/**
+    for site-specific models: first pattern of the block storing the eigensystems of a pattern block
+    @param eigen_block map from pattern blocks to stored eigensystem blocks, nullptr if not shared
+    @param ptn first pattern of the block
+    @param vsize number of patterns per block
+*/
+inline size_t eigenBlockPattern(const int *eigen_block, size_t ptn, size_t vsize) {
+    return eigen_block ? (size_t)eigen_block[ptn/vsize]*vsize : ptn;
+}
+
+/**
+    gather partial likelihoods and scaling numbers of a pattern block whose patterns
+    all repeat patterns of earlier blocks (--site-repeats)
+    @param partial_lh partial likelihoods being computed
+    @param scale_num scaling numbers being computed
+    @param ptn first pattern of the block
+    @param repeat_src for each pattern, the pattern computed before with the same partial likelihoods
+    @param vsize number of patterns per block
+    @param block number of partial likelihoods per pattern
+    @param scale_block number of scaling numbers per pattern
+*/
+inline void copyRepeatedPatterns(double *partial_lh, UBYTE *scale_num, size_t ptn, const int *repeat_src,
+                                 size_t vsize, size_t block, size_t scale_block)
+{
+    double *dest = partial_lh + ptn*block;
+    for (size_t i = 0; i < vsize; i++) {
+        size_t src_ptn = repeat_src[ptn+i];
+        // patterns are interleaved within a block of vsize patterns
+        const double *src = partial_lh + (src_ptn - src_ptn%vsize)*block + src_ptn%vsize;
+        for (size_t x = 0; x < block; x++)
+            dest[x*vsize+i] = src[x*vsize];
+        memcpy(scale_num + (ptn+i)*scale_block, scale_num + src_ptn*scale_block, scale_block*sizeof(UBYTE));
+    }
+}
+#endif
+
 /*******************************************************
  *
  * NEW! highly-vectorized partial likelihood function
@@ -1340,6 +1513,7 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
 	double *inv_evec = model->getInverseEigenvectors();
 	ASSERT(inv_evec && evec);
 	double *eval = model->getEigenvalues();
+	const int *eigen_block = SITE_MODEL ? model->getEigenBlockMap() : nullptr;
     size_t num_leaves = 0;
 
 	// internal node
@@ -1408,6 +1582,20 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
         len_right = etmp;
 	}
 
+    // pattern blocks repeating patterns of earlier blocks of this packet are gathered, see computeSiteRepeats()
+    const int *repeat_src = nullptr, *repeat_block_src = nullptr;
+    size_t repeat_upper = 0;
+    if (!SITE_MODEL && params->site_repeats && VectorClass::size() == vector_size &&
+        !dad_branch->repeat_block_src.empty() && dad_branch->repeat_stamp == site_repeat_stamp &&
+        dad_branch->repeat_block_src.size() == orig_nptn/VectorClass::size() &&
+        ((dad_branch->repeat_children[0] == left && dad_branch->repeat_children[1] == right) ||
+         (dad_branch->repeat_children[0] == right && dad_branch->repeat_children[1] == left))) {
+        repeat_src = &dad_branch->repeat_src[0];
+        repeat_block_src = &dad_branch->repeat_block_src[0];
+        repeat_upper = dad_branch->repeat_block_src.size()*VectorClass::size();
+    }
+    int min_repeat_src = ptn_lower;
+
     if (node->degree() > 3) {
         /*--------------------- multifurcating node ------------------*/
 
@@ -1428,8 +1616,9 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
 
             // SITE_MODEL variables
             VectorClass *expchild = partial_lh_all + block;
-            const VectorClass *eval_ptr = (VectorClass*) &eval[ptn*nstates];
-            VectorClass *evec_ptr = (VectorClass*) &evec[ptn*states_square];
+            size_t eptn = eigenBlockPattern(eigen_block, ptn, VectorClass::size());
+            const VectorClass *eval_ptr = (VectorClass*) &eval[eptn*nstates];
+            VectorClass *evec_ptr = (VectorClass*) &evec[eptn*states_square];
             double *len_child = len_children;
             VectorClass vchild;
 
@@ -1609,7 +1798,7 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
             VectorClass *partial_lh_tmp = partial_lh_all;
             VectorClass *partial_lh = (VectorClass*)(dad_branch->partial_lh + (ptn*block));
             VectorClass lh_max = 0.0;
-            double *inv_evec_ptr = SITE_MODEL ? &inv_evec[ptn*states_square] : nullptr;
+            double *inv_evec_ptr = SITE_MODEL ? &inv_evec[eptn*states_square] : nullptr;
             for (size_t c = 0; c < ncat_mix; c++) {
                 if (SITE_MODEL) {
                     // compute dot-product with inv_eigenvector
@@ -1652,6 +1841,11 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
         auto unknown = aln->STATE_UNKNOWN;
 
         for (size_t ptn = ptn_lower; ptn < ptn_upper; ptn+=VectorClass::size()) {
+            if (ptn < repeat_upper && repeat_block_src[ptn/VectorClass::size()] >= min_repeat_src) {
+                copyRepeatedPatterns(dad_branch->partial_lh, dad_branch->scale_num, ptn, repeat_src,
+                                     VectorClass::size(), block, SAFE_NUMERIC ? ncat_mix : 1);
+                continue;
+            }
             VectorClass *partial_lh = (VectorClass*)(dad_branch->partial_lh + (ptn*block));
 
             if (SITE_MODEL) {
@@ -1659,9 +1853,10 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
                 VectorClass* expright = (VectorClass*) vec_right;
                 const VectorClass *vleft = (VectorClass*) &partial_lh_left[ptn*nstates];
                 const VectorClass *vright = (VectorClass*) &partial_lh_right[ptn*nstates];
-                const VectorClass *eval_ptr = (VectorClass*) &eval[ptn*nstates];
-                VectorClass *evec_ptr = (VectorClass*) &evec[ptn*states_square];
-                VectorClass *inv_evec_ptr = (VectorClass*) &inv_evec[ptn*states_square];
+                size_t eptn = eigenBlockPattern(eigen_block, ptn, VectorClass::size());
+                const VectorClass *eval_ptr = (VectorClass*) &eval[eptn*nstates];
+                VectorClass *evec_ptr = (VectorClass*) &evec[eptn*states_square];
+                VectorClass *inv_evec_ptr = (VectorClass*) &inv_evec[eptn*states_square];
                 for (size_t c = 0; c < ncat; c++) {
                     for (size_t i = 0; i < nstates; i++) {
                         expleft[i] = exp(eval_ptr[i]*len_left[c]) * vleft[i];
@@ -1769,6 +1964,11 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
         auto unknown = aln->STATE_UNKNOWN;
         
         for (size_t ptn = ptn_lower; ptn < ptn_upper; ptn+=VectorClass::size()) {
+            if (ptn < repeat_upper && repeat_block_src[ptn/VectorClass::size()] >= min_repeat_src) {
+                copyRepeatedPatterns(dad_branch->partial_lh, dad_branch->scale_num, ptn, repeat_src,
+                                     VectorClass::size(), block, SAFE_NUMERIC ? ncat_mix : 1);
+                continue;
+            }
             VectorClass *partial_lh = (VectorClass*)(dad_branch->partial_lh + (ptn*block));
             VectorClass *partial_lh_right = (VectorClass*)(right->partial_lh + (ptn*block));
             VectorClass lh_max = 0.0;
@@ -1777,9 +1977,10 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
                 VectorClass *expleft = (VectorClass*)vec_left;
                 VectorClass *expright = expleft+nstates;
                 const VectorClass *vleft = (VectorClass*)&partial_lh_left[ptn*nstates];
-                const VectorClass *eval_ptr = (VectorClass*) &eval[ptn*nstates];
-                VectorClass *evec_ptr = (VectorClass*) &evec[ptn*states_square];
-                VectorClass *inv_evec_ptr = (VectorClass*) &inv_evec[ptn*states_square];
+                size_t eptn = eigenBlockPattern(eigen_block, ptn, VectorClass::size());
+                const VectorClass *eval_ptr = (VectorClass*) &eval[eptn*nstates];
+                VectorClass *evec_ptr = (VectorClass*) &evec[eptn*states_square];
+                VectorClass *inv_evec_ptr = (VectorClass*) &inv_evec[eptn*states_square];
                 for (size_t c = 0; c < ncat; c++) {
                     for (size_t i = 0; i < nstates; i++) {
                         expleft[i] = exp(eval_ptr[i]*len_left[c]) * vleft[i];
@@ -1915,6 +2116,11 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
         VectorClass *partial_lh_tmp
             = (VectorClass*)(buffer_partial_lh_ptr + thread_buf_size * packet_id);
 		for (size_t ptn = ptn_lower; ptn < ptn_upper; ptn+=VectorClass::size()) {
+            if (ptn < repeat_upper && repeat_block_src[ptn/VectorClass::size()] >= min_repeat_src) {
+                copyRepeatedPatterns(dad_branch->partial_lh, dad_branch->scale_num, ptn, repeat_src,
+                                     VectorClass::size(), block, SAFE_NUMERIC ? ncat_mix : 1);
+                continue;
+            }
 			VectorClass *partial_lh = (VectorClass*)(dad_branch->partial_lh + (ptn*block));
 			VectorClass *partial_lh_left = (VectorClass*)(left->partial_lh + (ptn*block));
 			VectorClass *partial_lh_right = (VectorClass*)(right->partial_lh + (ptn*block));
@@ -1941,9 +2147,10 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
             if (SITE_MODEL) {
                 expleft = partial_lh_tmp + nstates;
                 expright = expleft + nstates;
-                eval_ptr = (VectorClass*) &eval[ptn*nstates];
-                evec_ptr = (VectorClass*) &evec[ptn*states_square];
-                inv_evec_ptr = (VectorClass*) &inv_evec[ptn*states_square];
+                size_t eptn = eigenBlockPattern(eigen_block, ptn, VectorClass::size());
+                eval_ptr = (VectorClass*) &eval[eptn*nstates];
+                evec_ptr = (VectorClass*) &evec[eptn*states_square];
+                inv_evec_ptr = (VectorClass*) &inv_evec[eptn*states_square];
             }
 
 			for (size_t c = 0; c < ncat_mix; c++) {
@@ -1976,6 +2183,11 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
                     // normal model
                     double *inv_evec_ptr = inv_evec + mix_addr_malign[c];
                     // compute real partial likelihood vector
+                    if (nstates >= BLOCKED_PRODUCT_MIN_STATES) {
+                        productDualMatVecBlocked<VectorClass, double>(eleft_ptr, partial_lh_left, eright_ptr, partial_lh_right, partial_lh_tmp, nstates);
+                        eleft_ptr += states_square;
+                        eright_ptr += states_square;
+                    } else
                     for (size_t x = 0; x < nstates; x++) {
 #ifdef KERNEL_FIX_STATES
                         dotProductDualVec<VectorClass, double, nstates, FMA>(eleft_ptr, partial_lh_left, eright_ptr, partial_lh_right, partial_lh_tmp[x]);
@@ -2298,6 +2510,7 @@ void PhyloTree::computeLikelihoodDervGenericSIMD(PhyloNeighbor *dad_branch, Phyl
     }
 
     double *eval = model->getEigenvalues();
+    const int *eigen_block = SITE_MODEL ? model->getEigenBlockMap() : nullptr;
     ASSERT(eval);
 
     double *buffer_partial_lh_ptr = buffer_partial_lh;
@@ -2477,7 +2690,8 @@ void PhyloTree::computeLikelihoodDervGenericSIMD(PhyloNeighbor *dad_branch, Phyl
                 VectorClass *theta = (VectorClass*)(theta_all + (ptn*block));
                 VectorClass df_ptn, ddf_ptn;
                 if (SITE_MODEL) {
-                    const VectorClass* eval_ptr = (VectorClass*) &eval[ptn*nstates];
+                    size_t eptn = eigenBlockPattern(eigen_block, ptn, VectorClass::size());
+                    const VectorClass* eval_ptr = (VectorClass*) &eval[eptn*nstates];
                     lh_ptn = 0.0; df_ptn = 0.0; ddf_ptn = 0.0;
                     for (size_t c = 0; c < ncat; c++) {
                         VectorClass lh_cat(0.0), df_cat(0.0), ddf_cat(0.0);
@@ -2715,6 +2929,7 @@ double PhyloTree::computeLikelihoodBranchGenericSIMD(PhyloNeighbor *dad_branch,
     size_t mix_addr_nstates_malign[ncat_mix], mix_addr_malign[ncat_mix];
     size_t denom = (model_factory->fused_mix_rate) ? 1 : ncat;
     double *eval = model->getEigenvalues();
+    const int *eigen_block = SITE_MODEL ? model->getEigenBlockMap() : nullptr;
     ASSERT(eval);
 
     double *val = nullptr;
@@ -2861,7 +3076,8 @@ double PhyloTree::computeLikelihoodBranchGenericSIMD(PhyloNeighbor *dad_branch,
 
                 if (SITE_MODEL) {
                     // site-specific model
-                    VectorClass* eval_ptr = (VectorClass*) &eval[ptn*nstates];
+                    size_t eptn = eigenBlockPattern(eigen_block, ptn, VectorClass::size());
+                    VectorClass* eval_ptr = (VectorClass*) &eval[eptn*nstates];
                     for (size_t c = 0; c < ncat; c++) {
     #ifdef KERNEL_FIX_STATES
                         dotProductExp<VectorClass, double, nstates, FMA>(eval_ptr, lh_node, partial_lh_dad, cat_length[c], lh_cat[c]);
@@ -3026,7 +3242,8 @@ double PhyloTree::computeLikelihoodBranchGenericSIMD(PhyloNeighbor *dad_branch,
 
                 // compute likelihood per category
                 if (SITE_MODEL) {
-                    VectorClass* eval_ptr = (VectorClass*) &eval[ptn*nstates];
+                    size_t eptn = eigenBlockPattern(eigen_block, ptn, VectorClass::size());
+                    VectorClass* eval_ptr = (VectorClass*) &eval[eptn*nstates];
                     for (size_t c = 0; c < ncat; c++) {
     #ifdef KERNEL_FIX_STATES
                         dotProductExp<VectorClass, double, nstates, FMA>(eval_ptr, partial_lh_node, partial_lh_dad, cat_length[c], lh_cat[c]);
@@ -3314,6 +3531,7 @@ double PhyloTree::computeLikelihoodFromBufferGenericSIMD()
     }
 
     double *eval = model->getEigenvalues();
+    const int *eigen_block = SITE_MODEL ? model->getEigenBlockMap() : nullptr;
     ASSERT(eval);
 
     double *val0 = nullptr;
@@ -3374,7 +3592,8 @@ double PhyloTree::computeLikelihoodFromBufferGenericSIMD()
         VectorClass lh_ptn(0.0);
         VectorClass *theta = (VectorClass*)(theta_all + (ptn*block));
         if (SITE_MODEL) {
-            VectorClass *eval_ptr = (VectorClass*)&eval[ptn*nstates];
+            size_t eptn = eigenBlockPattern(eigen_block, ptn, VectorClass::size());
+            VectorClass *eval_ptr = (VectorClass*)&eval[eptn*nstates];
             for (size_t c = 0; c < ncat; c++) {
                 VectorClass lh_cat;
 #ifdef KERNEL_FIX_STATES
@@ -10,6 +10,35 @@
 //
 //
 #include "phylonode.h"
+#include "utils/mempool.h"
+
+/** pool of all PhyloNeighbor objects, never destroyed as trees may outlive it */
+static MemPool &getNeighborPool() {
+    static MemPool *pool = new MemPool(sizeof(PhyloNeighbor));
+    return *pool;
+}
+
+/** pool of all PhyloNode objects, never destroyed as trees may outlive it */
+static MemPool &getNodePool() {
+    static MemPool *pool = new MemPool(sizeof(PhyloNode));
+    return *pool;
+}
+
+void *PhyloNeighbor::operator new(size_t size) {
+    return getNeighborPool().allocate(size);
+}
+
+void PhyloNeighbor::operator delete(void *p, size_t size) {
+    getNeighborPool().deallocate(p, size);
+}
+
+void *PhyloNode::operator new(size_t size) {
+    return getNodePool().allocate(size);
+}
+
+void PhyloNode::operator delete(void *p, size_t size) {
+    getNodePool().deallocate(p, size);
+}
 
 
 void PhyloNeighbor::clearForwardPartialLh(Node *dad) {
@@ -19,17 +48,21 @@ void PhyloNeighbor::clearForwardPartialLh(Node *dad) {
 			((PhyloNeighbor*)*it)->clearForwardPartialLh(node);
 }
 
-void PhyloNode::clearReversePartialLh(PhyloNode *dad) {
+int PhyloNode::clearReversePartialLh(PhyloNode *dad) {
 //	PhyloNeighbor *node_nei = (PhyloNeighbor*)findNeighbor(dad);
 //	assert(node_nei);
 //	node_nei->partial_lh_computed = 0;
+    int num_cleared = 0;
 	for (NeighborVec::iterator it = neighbors.begin(); it != neighbors.end(); it ++)
 		if ((*it)->node != dad) {
             PhyloNeighbor *nei = (PhyloNeighbor*)(*it)->node->findNeighbor(this);
-			nei->partial_lh_computed = 0;
+            if (nei->partial_lh_computed == LH_DIRTY)
+                continue;
+			nei->partial_lh_computed = LH_DIRTY;
             nei->size = 0;
-			((PhyloNode*)(*it)->node)->clearReversePartialLh(this);
+			num_cleared += 1 + ((PhyloNode*)(*it)->node)->clearReversePartialLh(this);
 		}
+    return num_cleared;
 }
 
 void PhyloNode::clearAllPartialLh(bool make_null, PhyloNode* dad) {
@@ -80,6 +113,8 @@ PhyloNode::PhyloNode(int aid, const char *aname) : Node(aid, aname) {
 
 void PhyloNode::init() {
 	//partial_lh = nullptr;
+	// room for a bifurcating node, saves two reallocations while reading a tree
+	neighbors.reserve(3);
 }
 
 
@@ -21,6 +21,13 @@ typedef unsigned short UBYTE;
  */
 enum RootDirection {UNDEFINED_DIRECTION, TOWARD_ROOT, AWAYFROM_ROOT};
 
+/**
+ * value of PhyloNeighbor::partial_lh_computed set by PhyloNode::clearReversePartialLh():
+ * the partial likelihood vector and all vectors computed from it are stale.
+ * Cleared as soon as the vector is computed or its memory is taken away.
+ */
+const int LH_DIRTY = 4;
+
 /**
 A neighbor in a phylogenetic tree
 
@@ -52,6 +59,9 @@ public:
         partial_pars = nullptr;
         direction = UNDEFINED_DIRECTION;
         size = 0;
+        repeat_children[0] = repeat_children[1] = nullptr;
+        repeat_child_version[0] = repeat_child_version[1] = 0;
+        repeat_version = repeat_stamp = 0;
     }
 
     /**
@@ -68,6 +78,9 @@ public:
         partial_pars = nullptr;
         direction = UNDEFINED_DIRECTION;
         size = 0;
+        repeat_children[0] = repeat_children[1] = nullptr;
+        repeat_child_version[0] = repeat_child_version[1] = 0;
+        repeat_version = repeat_stamp = 0;
     }
 
     /**
@@ -82,6 +95,9 @@ public:
         partial_pars = nullptr;
         direction = nei->direction;
         size = nei->size;
+        repeat_children[0] = repeat_children[1] = nullptr;
+        repeat_child_version[0] = repeat_child_version[1] = 0;
+        repeat_version = repeat_stamp = 0;
     }
 
     
@@ -93,6 +109,18 @@ public:
         return (new PhyloNeighbor(this));
     }
 
+    /**
+        allocate from the pool of neighbors, reused when a tree is rebuilt
+        @param size size of the object
+     */
+    static void *operator new(size_t size);
+
+    /**
+        give a neighbor back to the pool
+        @param size size of the object
+     */
+    static void operator delete(void *p, size_t size);
+
     /**
         tell that the partial likelihood vector is not computed
      */
@@ -183,6 +211,28 @@ private:
     /** size of subtree below this neighbor in terms of number of taxa */
     int size;
 
+    /**
+        site-repeat class of each pattern in the subtree below this neighbor (--site-repeats):
+        patterns of the same class have identical partial likelihoods, empty if not computed
+    */
+    IntVector repeat_ids;
+
+    /** for each pattern, the nearest pattern of the same class in an earlier pattern block, -1 if none */
+    IntVector repeat_src;
+
+    /** for each pattern block, the smallest repeat_src of its patterns, -1 if one of them has none */
+    IntVector repeat_block_src;
+
+    /** the two children and their repeat_version from which repeat_ids were computed */
+    PhyloNeighbor *repeat_children[2];
+    int64_t repeat_child_version[2];
+
+    /** version of repeat_ids, renewed whenever they are recomputed, 0 if not computed */
+    int64_t repeat_version;
+
+    /** PhyloTree::site_repeat_stamp when repeat_ids were computed */
+    int64_t repeat_stamp;
+
 };
 
 /**
@@ -224,6 +274,18 @@ public:
      */
     void init();
 
+    /**
+        allocate from the pool of nodes, reused when a tree is rebuilt
+        @param size size of the object
+     */
+    static void *operator new(size_t size);
+
+    /**
+        give a node back to the pool
+        @param size size of the object
+     */
+    static void operator delete(void *p, size_t size);
+
     /**
         add a neighbor
         @param node the neighbor node
@@ -240,9 +302,13 @@ public:
     void clearAllPartialLh(bool make_null, PhyloNode *dad);
 
     /**
-        tell that all partial likelihood vectors (in reverse direction) below this node are not computed
+        tell that all partial likelihood vectors (in reverse direction) below this node are not computed.
+        Stops at vectors marked LH_DIRTY by an earlier call, because everything beyond them
+        is still stale, so that only the path to the last changed branch is visited.
+        @param dad dad of this node
+        @return number of vectors newly marked as not computed
      */
-    void clearReversePartialLh(PhyloNode *dad);
+    int clearReversePartialLh(PhyloNode *dad);
 
     void computeReversePartialLh(PhyloNode *dad);
 
@@ -29,11 +29,13 @@ PhyloSuperTree::PhyloSuperTree()
 {
 	totalNNIs = evalNNIs = 0;
     rescale_codon_brlen = false;
+    parallel_over_sites = Params::getInstance().parallel_over_sites;
 	// Initialize the counter for evaluated NNIs on subtrees. FOR THIS CASE IT WON'T BE initialized.
 }
 
 PhyloSuperTree::PhyloSuperTree(SuperAlignment *alignment, bool new_iqtree, bool create_tree) :  IQTree(alignment) {
     totalNNIs = evalNNIs = 0;
+    parallel_over_sites = Params::getInstance().parallel_over_sites;
 
     rescale_codon_brlen = false;
     bool has_codon = false;
@@ -74,6 +76,7 @@ PhyloSuperTree::PhyloSuperTree(SuperAlignment *alignment, bool new_iqtree, bool
 PhyloSuperTree::PhyloSuperTree(SuperAlignment *alignment, PhyloSuperTree *super_tree) :  IQTree(alignment) {
 	totalNNIs = evalNNIs = 0;
     rescale_codon_brlen = super_tree->rescale_codon_brlen;
+    parallel_over_sites = super_tree->parallel_over_sites;
 	part_info = super_tree->part_info;
 	for (vector<Alignment*>::iterator it = alignment->partitions.begin(); it != alignment->partitions.end(); it++) {
 		PhyloTree *tree = new PhyloTree((*it));
@@ -227,9 +230,11 @@ void PhyloSuperTree::changeLikelihoodKernel(LikelihoodKernel lk) {
 }
 
 void PhyloSuperTree::setNumThreads(int num_threads) {
-    PhyloTree::setNumThreads((size() >= num_threads) ? num_threads : 1);
+    // multi-threading over partitions needs at least one partition per thread
+    bool over_sites = parallel_over_sites || size() < num_threads;
+    PhyloTree::setNumThreads(over_sites ? 1 : num_threads);
     for (iterator it = begin(); it != end(); it++)
-        (*it)->setNumThreads((size() >= num_threads) ? 1 : num_threads);
+        (*it)->setNumThreads(over_sites ? num_threads : 1);
 }
 
 void PhyloSuperTree::printResultTree(string suffix) {
@@ -360,6 +360,9 @@ public:
     IntVector part_order;
     IntVector part_order_by_nptn;
 
+    /** TRUE to multi-thread over alignment sites within each partition instead of over partitions */
+    bool parallel_over_sites;
+
     /* compute part_order vector */
     void computePartitionOrder();
 
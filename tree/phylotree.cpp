@@ -20,6 +20,7 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 #include "phylotree.h"
+#include "threadtuner.h"
 #include "utils/starttree.h"
 #include "utils/progress.h"  //for progress_display
 //#include "rateheterogeneity.h"
@@ -34,6 +35,7 @@
 #include "upperbounds.h"
 #include "utils/MPIHelper.h"
 #include "utils/hammingdistance.h"
+#include "utils/profiler.h"
 #include "model/modelmixture.h"
 #include "phylonodemixlen.h"
 #include "phylotreemixlen.h"
@@ -76,10 +78,13 @@ PhyloTree::PhyloTree() : MTree(), CheckpointFactory() {
 
 void PhyloTree::init() {
     aln = nullptr;
+    full_aln = nullptr;
     model = nullptr;
     site_rate = nullptr;
     optimize_by_newton = true;
     central_partial_lh = nullptr;
+    site_repeat_blocks = site_repeat_skipped_blocks = 0;
+    site_repeat_version = site_repeat_stamp = 0;
     nni_partial_lh = nullptr;
     tip_partial_lh = nullptr;
     tip_partial_pars = nullptr;
@@ -89,6 +94,7 @@ void PhyloTree::init() {
     nni_scale_num = nullptr;
     central_partial_pars = nullptr;
     cost_matrix = nullptr;
+    thread_tuner = nullptr;
     model_factory = nullptr;
     discard_saturated_site = true;
     _pattern_lh = nullptr;
@@ -233,6 +239,8 @@ void myPartitionsDestroy(partitionList *pl) {
 
 PhyloTree::~PhyloTree() {
     doneComputingDistances();
+    delete thread_tuner;
+    thread_tuner = nullptr;
     aligned_free(nni_scale_num);
     aligned_free(nni_partial_lh);
     aligned_free(central_partial_lh);
@@ -370,6 +378,7 @@ void PhyloTree::copyPhyloTree(PhyloTree *tree, bool borrowSummary) {
     if (!tree->aln)
         return;
     setAlignment(tree->aln);
+    full_aln = tree->full_aln;
     if (borrowSummary && summary!=tree->summary && tree->summary!=nullptr) {
         if (!isSummaryBorrowed) {
             delete summary;
@@ -389,6 +398,51 @@ void PhyloTree::copyPhyloTreeMixlen(PhyloTree *tree, int mix, bool borrowSummary
     }
 }
 
+void PhyloTree::distributePatterns() {
+    MPIHelper &mpi = MPIHelper::getInstance();
+    int nproc = mpi.getNumProcesses();
+    if (nproc == 1 || full_aln)
+        return;
+#ifdef _IQTREE_MPI
+    // the tree topology, model and bootstrap options were checked in parseArg()
+    if (isSuperTree() || isTreeMix() || isMixlen())
+        outError("--mpi-patterns does not support partition, tree mixture and heterotachy models");
+    if (model->isSiteSpecificModel() || model_factory->getASC() != ASC_NONE || aln->seq_type == SEQ_POMO)
+        outError("--mpi-patterns does not support site-specific, +ASC and PoMo models");
+    size_t nptn = aln->getNPattern();
+    if (nptn < (size_t)nproc)
+        outError("--mpi-patterns needs at least as many alignment patterns as MPI processes");
+
+    // contiguous block of patterns of this process
+    int proc = mpi.getProcessID();
+    IntVector ptn_id;
+    for (size_t ptn = nptn*proc/nproc; ptn < nptn*(proc+1)/nproc; ptn++)
+        ptn_id.push_back(ptn);
+    Alignment *part_aln = new Alignment;
+    part_aln->extractPatterns(aln, ptn_id);
+    cout << "Process " << proc << ": patterns " << ptn_id.front()+1 << "-" << ptn_id.back()+1
+         << " of " << nptn << " (" << part_aln->getNSite() << " sites)" << endl;
+
+    deleteAllPartialLh();
+    if (!isSummaryBorrowed)
+        delete summary;
+    summary = nullptr;
+    Alignment *whole_aln = aln;
+    setAlignment(part_aln);
+    full_aln = whole_aln;
+#endif
+}
+
+void PhyloTree::collectPatterns() {
+    if (!full_aln)
+        return;
+    Alignment *part_aln = aln;
+    deleteAllPartialLh();
+    setAlignment(full_aln);
+    full_aln = nullptr;
+    delete part_aln;
+}
+
 #define FAST_NAME_CHECK 1
 void PhyloTree::setAlignment(Alignment *alignment) {
     aln = alignment;
@@ -687,6 +741,23 @@ void PhyloTree::clearAllPartialLH(bool make_null) {
     current_it = current_it_back = nullptr;
 }
 
+int PhyloTree::clearBranchPartialLh(PhyloNode *node1, PhyloNode *node2, bool topology_changed) {
+    int num_cleared = 0;
+    if (topology_changed) {
+        // the vectors of the branch itself see different subtrees
+        PhyloNeighbor *nei12 = (PhyloNeighbor*) node1->findNeighbor(node2);
+        PhyloNeighbor *nei21 = (PhyloNeighbor*) node2->findNeighbor(node1);
+        nei12->clearPartialLh();
+        nei21->clearPartialLh();
+        nei12->size = nei21->size = 0;
+        num_cleared += 2;
+    }
+    num_cleared += node2->clearReversePartialLh(node1);
+    num_cleared += node1->clearReversePartialLh(node2);
+    Profiler::count(PC_LH_INVALIDATED, num_cleared);
+    return num_cleared;
+}
+
 string getASCName(ASCType ASC_type) {
     switch (ASC_type) {
         case ASC_NONE:
@@ -1011,14 +1082,18 @@ uint64_t PhyloTree::getMemoryRequired(size_t ncategory, bool full_mem) {
     else
         mem_size = aln->num_states * (aln->STATE_UNKNOWN+1) * sizeof(double);
 
-    // memory for UFBoot
+    // memory for UFBoot: one byte per replicate and pattern plus a batch of pattern log-likelihoods
     if (params->gbo_replicates)
-        mem_size += params->gbo_replicates*nptn*sizeof(BootValType);
+        mem_size += params->gbo_replicates*nptn + MAX_RELL_BATCH_TREES*nptn*sizeof(double);
 
     // memory for model
     if (model)
         mem_size += model->getMemoryRequired();
 
+    // memory for site repeats: pattern classes and repeat sources of each branch in both directions
+    if (params->site_repeats)
+        mem_size += (int64_t)2*2*(2*leafNum-3)*nptn*sizeof(int);
+
     int64_t lh_scale_size = (block_size * sizeof(double)) + (scale_block_size * sizeof(UBYTE));
 
     max_lh_slots = leafNum-2;
@@ -1343,21 +1418,94 @@ void PhyloTree::transformPatternLhCat() {
 //    size_t nstates = aln->num_states;
     size_t ncat = site_rate->getNRate();
     if (!model_factory->fused_mix_rate) ncat *= model->getNMixtures();
+    size_t block = vector_size*ncat;
 
-    double *mem = aligned_alloc<double>(nptn*ncat);
-    memcpy(mem, _pattern_lh_cat, nptn*ncat*sizeof(double));
-    double *memptr = mem;
+    // each pattern block is transposed in place, so only a buffer per thread is needed
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_threads)
+#endif
+    {
+        double *mem = aligned_alloc<double>(block);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (size_t ptn = 0; ptn < nptn; ptn+=vector_size) {
+            double *lh_cat_ptr = &_pattern_lh_cat[ptn*ncat];
+            memcpy(mem, lh_cat_ptr, block*sizeof(double));
+            double *memptr = mem;
+            for (size_t cat = 0; cat < ncat; cat++) {
+                for (size_t i = 0; i < vector_size; i++) {
+                    lh_cat_ptr[(i*ncat)+cat] = memptr[i];
+                }
+                memptr += vector_size;
+            }
+        }
+        aligned_free(mem);
+    }
+}
 
-    for (size_t ptn = 0; ptn < nptn; ptn+=vector_size) {
-        double *lh_cat_ptr = &_pattern_lh_cat[ptn*ncat];
-        for (size_t cat = 0; cat < ncat; cat++) {
-            for (size_t i = 0; i < vector_size; i++) {
-                lh_cat_ptr[(i*ncat)+cat] = memptr[i];
+void PhyloTree::computePatternPosterior(size_t ncat, bool add_invar, double *sum_posterior, bool in_place,
+                                        double *sum_invar, const double *cat_weight) {
+    size_t nptn = aln->getNPattern();
+    // sufficient statistics are accumulated per thread (ncat posteriors and the invariable one)
+    // and summed in thread order afterwards, so that the result does not depend on timing
+    size_t stat_size = ncat+1;
+    DoubleVector thread_stat(num_threads*stat_size, 0.0);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_threads)
+#endif
+    {
+#ifdef _OPENMP
+        double *local_stat = &thread_stat[omp_get_thread_num()*stat_size];
+#else
+        double *local_stat = &thread_stat[0];
+#endif
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (size_t ptn = 0; ptn < nptn; ptn++) {
+            double *this_lk_cat = _pattern_lh_cat + ptn*ncat;
+            double lk_ptn = add_invar ? ptn_invar[ptn] : 0.0;
+            if (cat_weight) {
+                for (size_t c = 0; c < ncat; c++)
+                    lk_ptn += this_lk_cat[c] * cat_weight[c];
+            } else {
+                for (size_t c = 0; c < ncat; c++)
+                    lk_ptn += this_lk_cat[c];
+            }
+            ASSERT(lk_ptn != 0.0);
+            lk_ptn = ptn_freq[ptn] / lk_ptn;
+            if (add_invar)
+                local_stat[ncat] += ptn_invar[ptn] * lk_ptn;
+            for (size_t c = 0; c < ncat; c++) {
+                double posterior = this_lk_cat[c] * lk_ptn;
+                if (cat_weight)
+                    posterior *= cat_weight[c];
+                local_stat[c] += posterior;
+                if (in_place)
+                    this_lk_cat[c] = posterior;
             }
-            memptr += vector_size;
         }
     }
-    aligned_free(mem);
+    if (sum_posterior)
+        memset(sum_posterior, 0, ncat*sizeof(double));
+    if (sum_invar)
+        *sum_invar = 0.0;
+    for (int thread = 0; thread < num_threads; thread++) {
+        double *local_stat = &thread_stat[thread*stat_size];
+        if (sum_posterior)
+            for (size_t c = 0; c < ncat; c++)
+                sum_posterior[c] += local_stat[c];
+        if (sum_invar)
+            *sum_invar += local_stat[ncat];
+    }
+    if (full_aln) {
+        // sufficient statistics over the patterns of all processes
+        if (sum_posterior)
+            MPIHelper::getInstance().sumAllProcesses(sum_posterior, ncat);
+        if (sum_invar)
+            MPIHelper::getInstance().sumAllProcesses(sum_invar, 1);
+    }
 }
 
 double PhyloTree::computePatternLhCat(SiteLoglType wsl) {
@@ -2662,8 +2810,7 @@ void PhyloTree::optimizeOneBranch(PhyloNode *node1, PhyloNode *node2, bool clear
     //curScore = -negative_lh;
 
     if (clearLH && current_len != optx) {
-        node1->clearReversePartialLh(node2);
-        node2->clearReversePartialLh(node1);
+        clearBranchPartialLh(node1, node2, false);
     }
 
 //    return -negative_lh;
@@ -2722,6 +2869,7 @@ void PhyloTree::computeBestTraversal(NodeVector &nodes, NodeVector &nodes2) {
 }
 
 double PhyloTree::optimizeAllBranches(int my_iterations, double tolerance, int maxNRStep) {
+    PROFILE_SCOPE("branch optimization");
     if (verbose_mode >= VB_MAX) {
         cout << "Optimizing branch lengths (max " << my_iterations << " loops)..." << endl;
     }
@@ -4112,13 +4260,12 @@ void PhyloTree::doNNI(NNIMove &move, bool clearLH) {
     PhyloNeighbor *nei21 = (PhyloNeighbor*) node2->findNeighbor(node1); // return neighbor of node2 which points to node 1
 
     if (clearLH) {
-        // clear partial likelihood vector
-        nei12->clearPartialLh();
-        nei21->clearPartialLh();
-        nei12->size = nei21->size = 0;
-
-        node2->clearReversePartialLh(node1);
-        node1->clearReversePartialLh(node2);
+        // clear partial likelihood vectors on the paths to the swapped branch
+        int num_cleared = clearBranchPartialLh(node1, node2, true);
+        Profiler::count(PC_TOPOLOGY_MOVES);
+        Profiler::count(PC_MOVE_INVALIDATED, num_cleared);
+        if (verbose_mode >= VB_DEBUG)
+            cout << "NNI " << node1->id << " - " << node2->id << " cleared " << num_cleared << " partial likelihoods" << endl;
         //if (params->nni5Branches)
         //    clearAllPartialLH();
     }
@@ -4877,7 +5024,12 @@ double PhyloTree::assessSPRMove(double cur_score, const SPRMove &spr) {
         ((PhyloNeighbor*) (*it))->clearPartialLh();
     }
 
-    clearAllPartialLH();
+    // only the paths to the pruned and regrafted branches are stale
+    int num_cleared = clearBranchPartialLh(sibling1, sibling2, true);
+    FOR_NEIGHBOR(dad, nullptr, it)
+        num_cleared += clearBranchPartialLh(dad, (PhyloNode*) (*it)->node, true);
+    Profiler::count(PC_TOPOLOGY_MOVES);
+    Profiler::count(PC_MOVE_INVALIDATED, num_cleared);
     // optimize branches
     double score;
     optimizeAllBranches(dad);
@@ -4899,7 +5051,9 @@ double PhyloTree::assessSPRMove(double cur_score, const SPRMove &spr) {
     dad_nei1->length = sibling1_len;
     dad_nei2->node = sibling2;
     dad_nei2->length = sibling2_len;
-    clearAllPartialLH();
+    clearBranchPartialLh(dad2, node2, true);
+    FOR_NEIGHBOR(dad, nullptr, it)
+        clearBranchPartialLh(dad, (PhyloNode*) (*it)->node, true);
 
     return cur_score;
 
@@ -4936,6 +5090,292 @@ double PhyloTree::optimizeSPR() {
     //return optimizeAllBranches();
 }
 
+void PhyloTree::pruneSPRSubtree(PhyloNode *node, PhyloNode *dad, PhyloNode *&left, PhyloNode *&right,
+                                double &left_len, double &right_len) {
+    ASSERT(dad->degree() == 3);
+    PhyloNeighbor *dad_left = nullptr, *dad_right = nullptr;
+    FOR_NEIGHBOR_IT(dad, node, it) {
+        if (!dad_left)
+            dad_left = (PhyloNeighbor*) (*it);
+        else
+            dad_right = (PhyloNeighbor*) (*it);
+    }
+    left = (PhyloNode*) dad_left->node;
+    right = (PhyloNode*) dad_right->node;
+    left_len = dad_left->length;
+    right_len = dad_right->length;
+    PhyloNeighbor *left_nei = (PhyloNeighbor*) left->findNeighbor(dad);
+    PhyloNeighbor *right_nei = (PhyloNeighbor*) right->findNeighbor(dad);
+    // every internal node has at most one vector, held by one of the neighbors pointing to it:
+    // left_nei and right_nei will point to right and left
+    mem_slots.swapNei(left_nei, dad_right);
+    mem_slots.swapNei(right_nei, dad_left);
+    // keep the vector of dad in the only neighbor still pointing to dad
+    PhyloNeighbor *node_nei = (PhyloNeighbor*) node->findNeighbor(dad);
+    if (dad_left->partial_lh)
+        mem_slots.swapNei(node_nei, dad_left);
+    if (dad_right->partial_lh)
+        mem_slots.swapNei(node_nei, dad_right);
+    double len = left_len + right_len;
+    left->updateNeighbor(dad, right, len);
+    right->updateNeighbor(dad, left, len);
+    // the neighbors of dad other than node are left dangling until regraftSPRSubtree()
+    clearBranchPartialLh(left, right, true);
+}
+
+void PhyloTree::regraftSPRSubtree(PhyloNode *node, PhyloNode *dad, PhyloNode *node1, PhyloNode *node2,
+                                  double len1, double len2) {
+    PhyloNeighbor *dad_nei1 = nullptr, *dad_nei2 = nullptr;
+    FOR_NEIGHBOR_IT(dad, node, it) {
+        if (!dad_nei1)
+            dad_nei1 = (PhyloNeighbor*) (*it);
+        else
+            dad_nei2 = (PhyloNeighbor*) (*it);
+    }
+    PhyloNeighbor *node1_nei = (PhyloNeighbor*) node1->findNeighbor(node2);
+    PhyloNeighbor *node2_nei = (PhyloNeighbor*) node2->findNeighbor(node1);
+    // dad_nei1 and dad_nei2 take over pointing to node1 and node2, see pruneSPRSubtree()
+    mem_slots.swapNei(dad_nei1, node2_nei);
+    mem_slots.swapNei(dad_nei2, node1_nei);
+    dad_nei1->node = node1;
+    dad_nei1->length = len1;
+    node1->updateNeighbor(node2, dad, len1);
+    dad_nei2->node = node2;
+    dad_nei2->length = len2;
+    node2->updateNeighbor(node1, dad, len2);
+    // the vector of the subtree below node stays valid
+    clearBranchPartialLh(dad, node1, true);
+    clearBranchPartialLh(dad, node2, true);
+}
+
+/**
+    set the length of the branch between two nodes
+*/
+static void setSPRBranchLength(PhyloNode *node1, PhyloNode *node2, double len) {
+    node1->findNeighbor(node2)->length = len;
+    node2->findNeighbor(node1)->length = len;
+}
+
+void PhyloTree::scoreSPRRegraftBranches(SPRMove &best_move, PhyloNode *node2, PhyloNode *dad2, int depth, int radius) {
+    PhyloNode *node = best_move.prune_node;
+    PhyloNode *dad = best_move.prune_dad;
+    double len = node2->findNeighbor(dad2)->length;
+    double node_len = node->findNeighbor(dad)->length;
+    regraftSPRSubtree(node, dad, dad2, node2, len/2, len/2);
+    // lazy scoring: only the three branches at the regraft point are optimized
+    double score = optimizeChildBranches(dad);
+    if (score > best_move.score) {
+        best_move.regraft_node = node2;
+        best_move.regraft_dad = dad2;
+        best_move.score = score;
+    }
+    // detach the subtree again and restore the branch lengths
+    PhyloNode *left, *right;
+    double left_len, right_len;
+    pruneSPRSubtree(node, dad, left, right, left_len, right_len);
+    setSPRBranchLength(node2, dad2, len);
+    setSPRBranchLength(node, dad, node_len);
+
+    if (depth >= radius)
+        return;
+    FOR_NEIGHBOR_IT(node2, dad2, it)
+        scoreSPRRegraftBranches(best_move, (PhyloNode*) (*it)->node, node2, depth+1, radius);
+}
+
+void PhyloTree::scoreSPRRegrafts(PhyloNode *node, PhyloNode *dad, int radius, double cur_score, SPRMove &best_move) {
+    best_move.prune_node = node;
+    best_move.prune_dad = dad;
+    best_move.regraft_node = best_move.regraft_dad = nullptr;
+    best_move.score = cur_score;
+    double node_len = node->findNeighbor(dad)->length;
+    PhyloNode *left, *right;
+    double left_len, right_len;
+    pruneSPRSubtree(node, dad, left, right, left_len, right_len);
+    FOR_NEIGHBOR_IT(left, right, it)
+        scoreSPRRegraftBranches(best_move, (PhyloNode*) (*it)->node, left, 1, radius);
+    FOR_NEIGHBOR_IT(right, left, it)
+        scoreSPRRegraftBranches(best_move, (PhyloNode*) (*it)->node, right, 1, radius);
+    // put the subtree back to its original place
+    regraftSPRSubtree(node, dad, left, right, left_len, right_len);
+    setSPRBranchLength(node, dad, node_len);
+}
+
+/**
+    @return TRUE if target is in the subtree below node, seen from dad
+*/
+static bool isInSPRSubtree(Node *target, Node *node, Node *dad) {
+    if (node == target)
+        return true;
+    FOR_NEIGHBOR_IT(node, dad, it)
+        if (isInSPRSubtree(target, (*it)->node, node))
+            return true;
+    return false;
+}
+
+/**
+    copy a tree for a thread of optimizeSPRRound(), with the same node ids, neighbor
+    order and branch lengths, sharing the alignment and the model
+*/
+static PhyloTree *copySPRThreadTree(PhyloTree *tree) {
+    PhyloTree *copy = new PhyloTree;
+    NodeVector nodes;
+    tree->getAllNodesInSubtree(tree->root, nullptr, nodes);
+    NodeVector copy_nodes(tree->nodeNum, nullptr);
+    for (Node *node : nodes)
+        copy_nodes[node->id] = copy->newNode(node->id, node->name.c_str());
+    for (Node *node : nodes)
+        for (Neighbor *nei : node->neighbors)
+            copy_nodes[node->id]->addNeighbor(copy_nodes[nei->node->id], nei->length, nei->id);
+    copy->root = copy_nodes[tree->root->id];
+    copy->leafNum = tree->leafNum;
+    copy->nodeNum = tree->nodeNum;
+    copy->branchNum = tree->branchNum;
+    copy->rooted = tree->rooted;
+    copy->optimize_by_newton = tree->optimize_by_newton;
+    copy->setParams(tree->params);
+    copy->setAlignment(tree->aln);
+    copy->setLikelihoodKernel(tree->sse);
+    copy->setNumThreads(1);
+    copy->setModelFactory(tree->getModelFactory());
+    copy->initializeAllPartialLh();
+    return copy;
+}
+
+double PhyloTree::optimizeSPRRound(int radius) {
+    PROFILE_SCOPE("SPR round");
+    double cur_score = computeLikelihood();
+
+    // prune points: the subtree below node is pruned at dad
+    NodeVector nodes1, nodes2;
+    getBranches(nodes1, nodes2);
+    vector<SPRMove> best_moves;
+    for (int i = 0; i < nodes1.size(); i++) {
+        SPRMove move;
+        move.score = cur_score;
+        move.regraft_node = move.regraft_dad = nullptr;
+        if (nodes2[i]->degree() == 3) {
+            move.prune_node = (PhyloNode*) nodes1[i];
+            move.prune_dad = (PhyloNode*) nodes2[i];
+            best_moves.push_back(move);
+        }
+        if (nodes1[i]->degree() == 3) {
+            move.prune_node = (PhyloNode*) nodes2[i];
+            move.prune_dad = (PhyloNode*) nodes1[i];
+            best_moves.push_back(move);
+        }
+    }
+    NodeVector id_nodes(nodeNum, nullptr);
+    for (int i = 0; i < nodes1.size(); i++) {
+        id_nodes[nodes1[i]->id] = nodes1[i];
+        id_nodes[nodes2[i]->id] = nodes2[i];
+    }
+
+    // score all prune points, the first thread on this tree, the others on their own copy
+    int saved_num_threads = num_threads;
+    int num_spr_threads = max(num_threads, 1);
+    if (num_spr_threads > 1)
+        setNumThreads(1);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_spr_threads) if (num_spr_threads > 1)
+#endif
+    {
+        PhyloTree *tree = this;
+        NodeVector tree_nodes = id_nodes;
+#ifdef _OPENMP
+        if (omp_get_thread_num() > 0) {
+            tree = copySPRThreadTree(this);
+            NodeVector nodes;
+            tree->getAllNodesInSubtree(tree->root, nullptr, nodes);
+            for (Node *node : nodes)
+                tree_nodes[node->id] = node;
+        }
+        // the first thread changes this tree only after all copies are made
+#pragma omp barrier
+#endif
+        double tree_score = (tree == this) ? cur_score : tree->computeLikelihood();
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int i = 0; i < best_moves.size(); i++) {
+            SPRMove &move = best_moves[i];
+            SPRMove tree_move;
+            tree->scoreSPRRegrafts((PhyloNode*) tree_nodes[move.prune_node->id],
+                                   (PhyloNode*) tree_nodes[move.prune_dad->id], radius, tree_score, tree_move);
+            if (tree_move.regraft_node) {
+                move.regraft_node = (PhyloNode*) id_nodes[tree_move.regraft_node->id];
+                move.regraft_dad = (PhyloNode*) id_nodes[tree_move.regraft_dad->id];
+                move.score = tree_move.score;
+            }
+        }
+        if (tree != this) {
+            tree->setModelFactory(nullptr);
+            delete tree;
+        }
+    }
+    if (num_spr_threads > 1)
+        setNumThreads(saved_num_threads);
+    // the branch of current_it may have been rewired
+    current_it = current_it_back = nullptr;
+
+    // apply the best moves in descending order of their score, skipping moves close to an applied one
+    sort(best_moves.begin(), best_moves.end(), [](const SPRMove &a, const SPRMove &b) {
+        return a.score > b.score;
+    });
+    vector<bool> touched(nodeNum, false);
+    int num_applied = 0;
+    for (SPRMove &move : best_moves) {
+        if (move.score <= cur_score + params->loglh_epsilon)
+            break;
+        PhyloNode *node = move.prune_node, *dad = move.prune_dad;
+        PhyloNode *node2 = move.regraft_node, *dad2 = move.regraft_dad;
+        bool valid = !touched[dad->id] && !touched[node2->id] && !touched[dad2->id] &&
+            node2 != dad && dad2 != dad && dad->isNeighbor(node) && dad2->isNeighbor(node2);
+        if (valid) {
+            FOR_NEIGHBOR_IT(dad, nullptr, it)
+                valid &= !touched[(*it)->node->id];
+            valid &= !isInSPRSubtree(dad2, node, dad);
+        }
+        if (!valid)
+            continue;
+        double node_len = node->findNeighbor(dad)->length;
+        double len = node2->findNeighbor(dad2)->length;
+        PhyloNode *left, *right;
+        double left_len, right_len;
+        pruneSPRSubtree(node, dad, left, right, left_len, right_len);
+        regraftSPRSubtree(node, dad, dad2, node2, len/2, len/2);
+        double score = optimizeChildBranches(dad);
+        if (score > cur_score + params->loglh_epsilon && (constraintTree.empty() || constraintTree.isCompatible(this))) {
+            cur_score = score;
+            touched[dad->id] = touched[left->id] = touched[right->id] = true;
+            touched[node2->id] = touched[dad2->id] = true;
+            num_applied++;
+            Profiler::count(PC_TOPOLOGY_MOVES);
+            if (verbose_mode >= VB_DEBUG)
+                cout << "SPR " << node->id << "-" << dad->id << " to " << node2->id << "-" << dad2->id
+                     << ": " << score << endl;
+        } else {
+            // the tree changed since the move was scored, undo it
+            PhyloNode *node1, *node3;
+            double len1, len3;
+            pruneSPRSubtree(node, dad, node1, node3, len1, len3);
+            setSPRBranchLength(node2, dad2, len);
+            regraftSPRSubtree(node, dad, left, right, left_len, right_len);
+            setSPRBranchLength(node, dad, node_len);
+        }
+    }
+
+    current_it = current_it_back = nullptr;
+    if (num_applied > 0) {
+        cur_score = optimizeAllBranches(1);
+        if (params->fixStableSplits || params->adaptPertubation)
+            buildNodeSplit();
+    }
+    if (verbose_mode >= VB_MED)
+        cout << "SPR round with radius " << radius << ": " << num_applied << " moves applied, logL: " << cur_score << endl;
+    curScore = cur_score;
+    return cur_score;
+}
+
 /* double PhyloTree::optimizeSPRBranches() {
     cout << "Search with Subtree Pruning and Regrafting (SPR) using ML..." << endl;
     double cur_score = computeLikelihood();
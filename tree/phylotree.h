@@ -49,6 +49,7 @@
 #include "utils/progress.h"
 
 class AlignmentPairwise;
+class ThreadTuner;
 
 #define BOOT_VAL_FLOAT
 #define BootValType float
@@ -590,6 +591,33 @@ public:
         return aln->getNSite();
     }
 
+    /**
+     *		@return number of sites of the whole alignment, summed over all MPI processes
+     *		if the patterns are distributed (--mpi-patterns)
+     */
+    size_t getTotalNSite() {
+        return full_aln ? full_aln->getNSite() : getAlnNSite();
+    }
+
+    /**
+     *		@return the whole alignment, also if the patterns are distributed over MPI processes
+     */
+    Alignment *getFullAlignment() {
+        return full_aln ? full_aln : aln;
+    }
+
+    /**
+        MPI (--mpi-patterns): keep only a contiguous share of the alignment patterns in this process.
+        Tree log-likelihoods and branch derivatives are then summed over all processes,
+        so that all processes take the same decisions. Requires a fixed tree topology.
+    */
+    void distributePatterns();
+
+    /**
+        MPI (--mpi-patterns): return to the whole alignment after distributePatterns()
+    */
+    void collectPatterns();
+
     /**
      * save branch lengths into a vector
      */
@@ -787,6 +815,17 @@ public:
      */
     virtual void clearAllPartialLH(bool make_null = false);
 
+    /**
+            clear the partial likelihoods depending on a changed branch, i.e. the vectors on the
+            paths from the branch to all other branches; everything else stays computed
+            @param node1 one end of the branch
+            @param node2 the other end of the branch
+            @param topology_changed true if the subtrees at both ends changed (NNI, SPR),
+                   false if only the branch length changed
+            @return number of partial likelihood vectors cleared
+     */
+    int clearBranchPartialLh(PhyloNode *node1, PhyloNode *node2, bool topology_changed);
+
     /**
      * compute all partial likelihoods if not computed before
      */
@@ -837,6 +876,9 @@ public:
     /** number of threads used for likelihood kernel */
     int num_threads;
 
+    /** auto-tuner of the number of threads for -T AUTO, nullptr if not used */
+    ThreadTuner *thread_tuner;
+
     /** number of packets used for likelihood kernel (typically more) */
     int num_packets;
 
@@ -854,6 +896,21 @@ public:
     bool computeTraversalInfo(PhyloNeighbor *dad_branch, PhyloNode *dad, double* &buffer);
 
 
+    /**
+        compute site-repeat classes and repeated pattern blocks of a subtree (--site-repeats),
+        recursively for children whose classes are outdated. Classes only depend on the topology
+        and the invariant sites, so they are kept until one of the children changes
+        @param dad_branch branch leading to the subtree
+        @param dad its dad, used to direct the traversal
+    */
+    void computeSiteRepeats(PhyloNeighbor *dad_branch, PhyloNode *dad);
+
+    /** renew site_repeat_stamp if the invariant sites changed since the site-repeat classes were computed */
+    void updateSiteRepeatStamp();
+
+    /** print the proportion of pattern blocks reused by site repeats */
+    void reportSiteRepeats();
+
     /**
         compute traversal_info of both subtrees
     */
@@ -1061,6 +1118,22 @@ public:
      */
     virtual double computePatternLhCat(SiteLoglType wsl);
 
+    /**
+        E-step of the EM algorithm: convert _pattern_lh_cat (computed by computePatternLhCat)
+        into posterior probabilities of the categories times pattern frequencies.
+        Patterns are processed in parallel, without a copy of _pattern_lh_cat, and the sums are
+        reduced in a fixed thread order. With in_place FALSE the E-step only streams over
+        _pattern_lh_cat, so it can be repeated with new cat_weight without storing posteriors.
+        @param ncat number of categories per pattern in _pattern_lh_cat
+        @param add_invar TRUE to include ptn_invar into the pattern likelihoods
+        @param[out] sum_posterior sum of posteriors over patterns per category, nullptr if not needed
+        @param in_place TRUE to overwrite _pattern_lh_cat with the posteriors
+        @param[out] sum_invar sum of posteriors of the invariable category, nullptr if not needed
+        @param cat_weight factor for the likelihood of each category, nullptr for none
+    */
+    void computePatternPosterior(size_t ncat, bool add_invar, double *sum_posterior, bool in_place = true,
+                                 double *sum_invar = nullptr, const double *cat_weight = nullptr);
+
     /**
         compute state frequency for each pattern (for Huaichun)
         @param[out] ptn_state_freq state frequency vector per pattern, 
@@ -1568,6 +1641,18 @@ public:
 
     vector<TraversalInfo> traversal_info;
 
+    /** number of pattern blocks with site repeats computed, and how many of them are reused */
+    int64_t site_repeat_blocks, site_repeat_skipped_blocks;
+
+    /** counter for PhyloNeighbor::repeat_version */
+    int64_t site_repeat_version;
+
+    /** changed whenever the invariant sites change, which outdates all site-repeat classes */
+    int64_t site_repeat_stamp;
+
+    /** patterns with ptn_invar != 0 when site_repeat_stamp was last changed */
+    BoolVector site_repeat_invar;
+
     /**
      gradients array for first order derivatives to be used in MCMCTree
       */
@@ -1910,6 +1995,60 @@ public:
 
     double assessSPRMove(double cur_score, const SPRMove &spr);
 
+    /**
+            one round of SPR moves by maximum likelihood. Every subtree is pruned and regrafted to
+            all branches within the radius, optimizing only the three branches at the regraft point
+            and reusing the partial likelihoods of the pruned subtree. The prune points are scored
+            in parallel, each thread on its own copy of the tree. The best moves that are not close
+            to each other are then applied in the order of their score.
+            @param radius maximum number of branches between the pruned and the regraft branch
+            @return the likelihood of the tree
+     */
+    double optimizeSPRRound(int radius);
+
+    /**
+            score regrafting the subtree below node to all branches within the radius,
+            the tree is restored afterwards
+            @param node root of the subtree
+            @param dad node of degree 3 where the subtree is pruned
+            @param radius maximum number of branches between the pruned and the regraft branch
+            @param cur_score likelihood of the tree
+            @param[out] best_move best regraft branch, nullptr if none improves cur_score
+     */
+    void scoreSPRRegrafts(PhyloNode *node, PhyloNode *dad, int radius, double cur_score, SPRMove &best_move);
+
+    /**
+            score regrafting the subtree of best_move to the branch (node2, dad2) and,
+            recursively, to the branches behind node2
+            @param best_move the pruned subtree, updated if the regraft branch improves its score
+            @param node2 regraft branch end away from the prune point
+            @param dad2 regraft branch end towards the prune point
+            @param depth number of branches between the pruned and the regraft branch
+            @param radius maximum depth
+     */
+    void scoreSPRRegraftBranches(SPRMove &best_move, PhyloNode *node2, PhyloNode *dad2, int depth, int radius);
+
+    /**
+            detach the subtree below node by joining the two other neighbors of dad,
+            the neighbors of dad are kept for regraftSPRSubtree()
+            @param node root of the subtree
+            @param dad node of degree 3 where the subtree is pruned
+            @param[out] left, right the joined neighbors of dad
+            @param[out] left_len, right_len their former branch lengths to dad
+     */
+    void pruneSPRSubtree(PhyloNode *node, PhyloNode *dad, PhyloNode *&left, PhyloNode *&right,
+                         double &left_len, double &right_len);
+
+    /**
+            insert dad with the subtree pruned by pruneSPRSubtree() into the branch (node1, node2)
+            @param node root of the subtree
+            @param dad node where the subtree was pruned
+            @param node1, node2 ends of the regraft branch
+            @param len1, len2 lengths of the new branches from dad to node1 and node2
+     */
+    void regraftSPRSubtree(PhyloNode *node, PhyloNode *dad, PhyloNode *node1, PhyloNode *node2,
+                           double len1, double len2);
+
     // void pruneSubtree(PhyloNode *node, PhyloNode *dad, PruningInfo &info);
 
     /*void regraftSubtree(PruningInfo &info,
@@ -2093,6 +2232,12 @@ public:
      */
     Alignment *aln;
 
+    /**
+            whole alignment if the patterns are distributed over MPI processes
+            (--mpi-patterns), then aln holds the patterns of this process; nullptr otherwise
+     */
+    Alignment *full_aln;
+
     /**
      * Distance matrix
      */
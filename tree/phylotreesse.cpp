@@ -19,6 +19,7 @@
  ***************************************************************************/
 #include "phylotree.h"
 #include "vectorclass/instrset.h"
+#include "utils/profiler.h"
 
 #if INSTRSET < 2
 #include "phylokernelnew.h"
@@ -33,6 +34,7 @@
 //#include "phylokernelsitemodel.h"
 
 #include "model/modelmarkov.h"
+#include "utils/MPIHelper.h"
 #include "model/modelset.h"
 
 /* BQM: to ignore all-gapp subtree at an alignment site */
@@ -211,28 +213,45 @@ void PhyloTree::changeLikelihoodKernel(LikelihoodKernel lk) {
 
 void PhyloTree::computePartialLikelihood(TraversalInfo &info, size_t ptn_left, size_t ptn_right, int packet_id) {
 	(this->*computePartialLikelihoodPointer)(info, ptn_left, ptn_right, packet_id);
+    if (ptn_left == 0)
+        Profiler::count(PC_PARTIAL_LH);
+    Profiler::count(PC_PATTERNS, ptn_right - ptn_left);
 }
 
 double PhyloTree::computeLikelihoodBranch(PhyloNeighbor *dad_branch, PhyloNode *dad, bool save_log_value) {
-	return (this->*computeLikelihoodBranchPointer)(dad_branch, dad, save_log_value);
-
+	double tree_lh = (this->*computeLikelihoodBranchPointer)(dad_branch, dad, save_log_value);
+    Profiler::count(PC_LH_BRANCH);
+    if (full_aln)
+        MPIHelper::getInstance().sumAllProcesses(&tree_lh, 1);
+    return tree_lh;
 }
 
 void PhyloTree::computeLikelihoodDerv(PhyloNeighbor *dad_branch, PhyloNode *dad, double *df, double *ddf) {
 	(this->*computeLikelihoodDervPointer)(dad_branch, dad, df, ddf);
+    Profiler::count(PC_LH_DERV);
+    if (full_aln) {
+        double derv[2] = {*df, *ddf};
+        MPIHelper::getInstance().sumAllProcesses(derv, 2);
+        *df = derv[0];
+        *ddf = derv[1];
+    }
 }
 
 
 double PhyloTree::computeLikelihoodFromBuffer() {
 	ASSERT(current_it && current_it_back);
+    Profiler::count(PC_LH_BUFFER);
 
+    double tree_lh;
     // TODO: buffer stuff for mixlen model
 	if (computeLikelihoodFromBufferPointer && optimize_by_newton)
-		return (this->*computeLikelihoodFromBufferPointer)();
+		tree_lh = (this->*computeLikelihoodFromBufferPointer)();
 	else {
-		return (this->*computeLikelihoodBranchPointer)(current_it, (PhyloNode*)current_it_back->node, true);
+		tree_lh = (this->*computeLikelihoodBranchPointer)(current_it, (PhyloNode*)current_it_back->node, true);
     }
-
+    if (full_aln)
+        MPIHelper::getInstance().sumAllProcesses(&tree_lh, 1);
+    return tree_lh;
 }
 
 double PhyloTree::dotProductDoubleCall(double *x, double *y, int size) {
@@ -261,6 +280,7 @@ void PhyloTree::computeTipPartialLikelihood() {
         int nstates = aln->num_states;
         size_t nseq = aln->getNSeq();
         ASSERT(vector_size > 0);
+        const int *eigen_block = model->getEigenBlockMap();
         
         
 #ifdef _OPENMP
@@ -270,7 +290,9 @@ void PhyloTree::computeTipPartialLikelihood() {
             auto stateRow = getConvertedSequenceByNumber(nodeid);
             double *partial_lh = tip_partial_lh + (tip_block_size*nodeid);
             for (size_t ptn = 0; ptn < nptn; ptn+=vector_size, partial_lh += nstates*vector_size) {
-                const double *inv_evec = &model->getInverseEigenvectors()[ptn*nstates*nstates];
+                // pattern blocks with the same models share their eigensystems
+                size_t eptn = eigen_block ? (size_t)eigen_block[ptn/vector_size]*vector_size : ptn;
+                const double *inv_evec = &model->getInverseEigenvectors()[eptn*nstates*nstates];
                 for (int v = 0; v < vector_size; v++) {
                     int state = 0;
                     if (ptn+v < nptn) {
@@ -611,6 +633,131 @@ void PhyloTree::computePtnInvar() {
 //	aligned_free(state_freq);
 }
 
+void PhyloTree::updateSiteRepeatStamp() {
+    size_t orig_nptn = aln->size();
+    bool changed = (site_repeat_invar.size() != orig_nptn);
+    site_repeat_invar.resize(orig_nptn);
+    for (size_t ptn = 0; ptn < orig_nptn; ptn++)
+        if (site_repeat_invar[ptn] != (ptn_invar[ptn] != 0.0)) {
+            site_repeat_invar[ptn] = (ptn_invar[ptn] != 0.0);
+            changed = true;
+        }
+    if (changed)
+        site_repeat_stamp++;
+}
+
+void PhyloTree::computeSiteRepeats(PhyloNeighbor *dad_branch, PhyloNode *dad) {
+    PhyloNode *node = (PhyloNode*)dad_branch->node;
+    size_t orig_nptn = aln->size();
+    IntVector &ids = dad_branch->repeat_ids;
+
+    if (node->isLeaf()) {
+        // class of a tip is its state, independent of topology and invariant sites
+        dad_branch->repeat_stamp = site_repeat_stamp;
+        if (dad_branch->repeat_version > 0 && ids.size() == orig_nptn)
+            return;
+        const char *state_row = getConvertedSequenceByNumber(node->id);
+        ids.resize(orig_nptn);
+        for (size_t ptn = 0; ptn < orig_nptn; ptn++)
+            ids[ptn] = (state_row != nullptr) ? state_row[ptn] : (int)aln->at(ptn)[node->id];
+        dad_branch->repeat_src.clear();
+        dad_branch->repeat_block_src.clear();
+        dad_branch->repeat_version = ++site_repeat_version;
+        return;
+    }
+
+    if (node->degree() != 3) {
+        // multifurcating nodes are computed without site repeats
+        if (dad_branch->repeat_version == 0 || !ids.empty()) {
+            ids.clear();
+            dad_branch->repeat_src.clear();
+            dad_branch->repeat_block_src.clear();
+            dad_branch->repeat_version = ++site_repeat_version;
+        }
+        dad_branch->repeat_stamp = site_repeat_stamp;
+        return;
+    }
+
+    PhyloNeighbor *children[2];
+    int num_children = 0;
+    bool outdated = dad_branch->repeat_version == 0 || dad_branch->repeat_stamp != site_repeat_stamp ||
+        ids.size() != orig_nptn;
+    FOR_NEIGHBOR_IT(node, dad, it) {
+        PhyloNeighbor *child = (PhyloNeighbor*)*it;
+        // children in traversal_info come first; the others have valid partial_lh and only
+        // need their classes if they were never computed or the invariant sites changed
+        if (child->repeat_version == 0 || child->repeat_stamp != site_repeat_stamp)
+            computeSiteRepeats(child, node);
+        if (child != dad_branch->repeat_children[num_children] ||
+            child->repeat_version != dad_branch->repeat_child_version[num_children])
+            outdated = true;
+        children[num_children++] = child;
+    }
+    if (!outdated)
+        return;
+    PhyloNeighbor *left = children[0], *right = children[1];
+
+    // a pattern repeats another one if both subtrees repeat it and the scaling condition is the same
+    unordered_map<uint64_t, int> classes;
+    ids.resize(orig_nptn);
+    for (size_t ptn = 0; ptn < orig_nptn; ptn++) {
+        // without classes of a child (e.g. below a multifurcation) every pattern is unique
+        uint64_t left_id = left->repeat_ids.empty() ? ptn : left->repeat_ids[ptn];
+        uint64_t right_id = right->repeat_ids.empty() ? ptn : right->repeat_ids[ptn];
+        uint64_t key = ((2*left_id + (ptn_invar[ptn] != 0.0)) << 32) | right_id;
+        auto it = classes.find(key);
+        if (it == classes.end()) {
+            ids[ptn] = classes.size();
+            classes[key] = ids[ptn];
+        } else {
+            ids[ptn] = it->second;
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        dad_branch->repeat_children[i] = children[i];
+        dad_branch->repeat_child_version[i] = children[i]->repeat_version;
+    }
+    dad_branch->repeat_version = ++site_repeat_version;
+    dad_branch->repeat_stamp = site_repeat_stamp;
+
+    // the kernel computes vector_size patterns at once: a block of observed patterns is
+    // gathered pattern by pattern if each of them repeats a pattern of an earlier block
+    size_t num_blocks = orig_nptn / vector_size;
+    IntVector &src = dad_branch->repeat_src;
+    IntVector &block_src = dad_branch->repeat_block_src;
+    src.assign(num_blocks*vector_size, -1);
+    block_src.assign(num_blocks, -1);
+    // last pattern of each class in the blocks before the current one
+    IntVector last_ptn(classes.size(), -1);
+    int num_repeats = 0;
+    for (size_t b = 0; b < num_blocks; b++) {
+        size_t lower = b*vector_size;
+        int min_src = INT_MAX;
+        for (size_t ptn = lower; ptn < lower+vector_size; ptn++) {
+            src[ptn] = last_ptn[ids[ptn]];
+            min_src = min(min_src, src[ptn]);
+        }
+        for (size_t ptn = lower; ptn < lower+vector_size; ptn++)
+            last_ptn[ids[ptn]] = ptn;
+        if (min_src >= 0) {
+            block_src[b] = min_src;
+            num_repeats++;
+        }
+    }
+    if (verbose_mode >= VB_DEBUG)
+        cout << "Site repeats at node " << node->id << ": " << classes.size() << " unique of "
+             << orig_nptn << " patterns, " << num_blocks - num_repeats << " of " << num_blocks
+             << " blocks computed" << endl;
+}
+
+void PhyloTree::reportSiteRepeats() {
+    if (site_repeat_blocks == 0)
+        return;
+    cout << "Site repeats: " << site_repeat_skipped_blocks << " of " << site_repeat_blocks
+         << " pattern blocks reused (" << (100.0 * site_repeat_skipped_blocks / site_repeat_blocks)
+         << "%)" << endl;
+}
+
 /*******************************************************
  *
  * non-vectorized likelihood functions.
@@ -688,7 +835,7 @@ void PhyloTree::computePartialLikelihoodEigen(PhyloNeighbor *dad_branch, PhyloNo
                 dad_branch->scale_num = backnei->scale_num;
                 backnei->partial_lh = nullptr;
                 backnei->scale_num = nullptr;
-                backnei->partial_lh_computed &= ~1; // clear bit
+                backnei->partial_lh_computed &= ~(1 | LH_DIRTY); // clear bit
                 done = true;
                 break;
             }
@@ -1725,7 +1872,7 @@ void PhyloTree::computeAncestralLikelihood(PhyloNeighbor *dad_branch, PhyloNode
                 dad_branch->scale_num = backnei->scale_num;
                 backnei->partial_lh = nullptr;
                 backnei->scale_num = nullptr;
-                backnei->partial_lh_computed &= ~1; // clear bit
+                backnei->partial_lh_computed &= ~(1 | LH_DIRTY); // clear bit
                 done = true;
                 break;
             }
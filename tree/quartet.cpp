@@ -11,6 +11,7 @@
 
 #include "phylotree.h"
 #include "phylosupertree.h"
+#include "quartetlikelihood.h"
 #include "model/partitionmodel.h"
 #include "alignment/alignment.h"
 #if 0 // (HAS-bla)
@@ -832,6 +833,9 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
     // fprintf(stderr,"XXX - #quarts: %d; #groups: %d, A: %d, B:%d, C:%d, D:%d\n", LMGroups.uniqueQuarts, LMGroups.numGroups, sizeA, sizeB, sizeC, sizeD);
     
 
+    bool use_quartet_kernel = !params->lmap_generic_kernel && QuartetLikelihood::isSupported(this);
+    double quartet_start_time = getRealTime();
+
 #ifdef _OPENMP
     #pragma omp parallel
     {
@@ -840,6 +844,9 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
 #else
     int *rstream = randstream;
 #endif    
+    QuartetLikelihood *quartet_lh = nullptr;
+    if (use_quartet_kernel)
+        quartet_lh = new QuartetLikelihood(this);
 
 #ifdef _OPENMP
     #pragma omp for schedule(guided)
@@ -895,8 +902,10 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
         // obsolete: sort(lmap_quartet_info[qid].seqID, lmap_quartet_info[qid].seqID+4); // why sort them?!? HAS ;^)
 
         // initialize sub-alignment and sub-tree
-        Alignment *quartet_aln;
-        if (aln->isSuperAlignment()) {
+        Alignment *quartet_aln = nullptr;
+        if (quartet_lh) {
+            // the dedicated 4-taxon kernel needs no sub-alignment
+        } else if (aln->isSuperAlignment()) {
             quartet_aln = new SuperAlignment;
         } else {
             quartet_aln = new Alignment;
@@ -905,9 +914,13 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
         seq_id.insert(seq_id.begin(), lmap_quartet_info[qid].seqID, lmap_quartet_info[qid].seqID+4);
         IntVector kept_partitions;
         // only keep partitions with at least 3 sequences
-        quartet_aln->extractSubAlignment(aln, seq_id, 0, 3, &kept_partitions);
+        if (quartet_aln)
+            quartet_aln->extractSubAlignment(aln, seq_id, 0, 3, &kept_partitions);
                 
-        if (kept_partitions.size() == 0) {
+        if (quartet_lh) {
+            // dedicated 4-taxon kernel
+            quartet_lh->computeQuartetLikelihoods(lmap_quartet_info[qid].seqID, lmap_quartet_info[qid].logl);
+        } else if (kept_partitions.size() == 0) {
             // nothing kept
             for (int k = 0; k < 3; k++) {
                 lmap_quartet_info[qid].logl[k] = -1.0;
@@ -1150,6 +1163,8 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
 		}
 	}
     } /*** end draw lmap_num_quartets quartets randomly ***/
+    if (quartet_lh)
+        delete quartet_lh;
 #ifdef _OPENMP
     finish_random(rstream);
     }
@@ -1159,6 +1174,11 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
 	cout << ". : " << params->lmap_num_quartets << flush << endl << endl;
     } else cout << endl;
 
+    double quartet_time = getRealTime() - quartet_start_time;
+    cout << "Quartet likelihoods computed in " << quartet_time << " secs ("
+         << (int64_t)(params->lmap_num_quartets / max(quartet_time, 1e-6)) << " quartets/sec, "
+         << (use_quartet_kernel ? "quartet" : "generic") << " kernel)" << endl << endl;
+
 
     // restore seq_states
     /*
@@ -0,0 +1,285 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "quartetlikelihood.h"
+#include <unordered_map>
+
+/** initial length of all quartet branches */
+const double QUARTET_INIT_LENGTH = 0.1;
+
+/** maximal number of rounds over the 5 branches, as optimizeAllBranches(10, 0.1) */
+const int QUARTET_MAX_ROUNDS = 10;
+
+/** log-likelihood improvement to stop branch optimization */
+const double QUARTET_LOGL_EPSILON = 0.1;
+
+QuartetLikelihood::QuartetLikelihood(PhyloTree *tree) {
+    this->tree = tree;
+    ModelSubst *model = tree->getModel();
+    RateHeterogeneity *site_rate = tree->getRate();
+    nstates = tree->aln->num_states;
+    ncat = site_rate->getNDiscreteRate();
+    rates.resize(ncat);
+    props.resize(ncat);
+    for (size_t c = 0; c < ncat; c++) {
+        rates[c] = site_rate->getRate(c);
+        props[c] = site_rate->getProp(c);
+    }
+    p_invar = site_rate->getPInvar();
+    state_freq.resize(nstates);
+    model->getStateFrequency(&state_freq[0]);
+    eval = model->getEigenvalues();
+    evec = model->getEigenvectors();
+    inv_evec = model->getInverseEigenvectors();
+
+    size_t num_tip_states = tree->aln->STATE_UNKNOWN + 1;
+    tip_lh.resize(num_tip_states * nstates);
+    for (size_t state = 0; state < num_tip_states; state++)
+        model->computeTipLikelihood(state, &tip_lh[state * nstates]);
+
+    trans_mat.resize(5 * ncat * nstates * nstates);
+    exp_buf.resize(ncat * nstates);
+    lambda_buf.resize(ncat * nstates);
+    for (int i = 0; i < 5; i++)
+        lengths[i] = QUARTET_INIT_LENGTH;
+}
+
+bool QuartetLikelihood::isSupported(PhyloTree *tree) {
+    if (tree->isSuperTree() || tree->isTreeMix() || tree->isMixlen())
+        return false;
+    if (tree->aln->seq_type == SEQ_POMO)
+        return false;
+    ModelSubst *model = tree->getModel();
+    if (!model->useRevKernel() || model->isMixture() || model->isSiteSpecificModel())
+        return false;
+    if (!model->getEigenvalues() || !model->getEigenvectors() || !model->getInverseEigenvectors())
+        return false;
+    RateHeterogeneity *site_rate = tree->getRate();
+    if (site_rate->isSiteSpecificRate() || site_rate->isHeterotachy())
+        return false;
+    if (tree->getModelFactory()->getASC() != ASC_NONE)
+        return false;
+    return true;
+}
+
+void QuartetLikelihood::buildPatterns(int *seq_id) {
+    Alignment *aln = tree->aln;
+    size_t nptn = aln->getNPattern();
+    StateType unknown = aln->STATE_UNKNOWN;
+    unordered_map<uint64_t, int> pattern_index;
+    ptn_states.clear();
+    ptn_freq.clear();
+
+    for (size_t ptn = 0; ptn < nptn; ptn++) {
+        Pattern &pat = aln->at(ptn);
+        StateType states[4];
+        for (int i = 0; i < 4; i++)
+            states[i] = pat[seq_id[i]];
+        // all-gap columns have likelihood 1
+        if (states[0] == unknown && states[1] == unknown && states[2] == unknown && states[3] == unknown)
+            continue;
+        uint64_t key = 0;
+        for (int i = 0; i < 4; i++)
+            key = (key << 16) | states[i];
+        auto it = pattern_index.find(key);
+        if (it != pattern_index.end()) {
+            ptn_freq[it->second] += pat.frequency;
+            continue;
+        }
+        pattern_index[key] = ptn_freq.size();
+        ptn_freq.push_back(pat.frequency);
+        for (int i = 0; i < 4; i++)
+            ptn_states.push_back(states[i]);
+    }
+
+    // likelihood of invariable sites
+    size_t quartet_nptn = ptn_freq.size();
+    ptn_invar.resize(quartet_nptn);
+    for (size_t ptn = 0; ptn < quartet_nptn; ptn++) {
+        double lh_invar = 0.0;
+        if (p_invar > 0.0) {
+            for (size_t s = 0; s < nstates; s++) {
+                double lh = state_freq[s];
+                for (int i = 0; i < 4; i++)
+                    lh *= tip_lh[ptn_states[ptn*4+i]*nstates + s];
+                lh_invar += lh;
+            }
+            lh_invar *= p_invar;
+        }
+        ptn_invar[ptn] = lh_invar;
+    }
+    theta.resize(quartet_nptn * ncat * nstates);
+}
+
+void QuartetLikelihood::computeQuartetLikelihoods(int *seq_id, double *logl) {
+    // the three topologies 01|23, 02|13, 03|12
+    int qc[] = {0,1,2,3, 0,2,1,3, 0,3,1,2};
+    buildPatterns(seq_id);
+    for (int k = 0; k < 3; k++)
+        logl[k] = optimizeTopology(qc + k*4);
+}
+
+double QuartetLikelihood::optimizeTopology(const int *leaf) {
+    for (int i = 0; i < 5; i++)
+        lengths[i] = QUARTET_INIT_LENGTH;
+    if (ptn_freq.empty())
+        return 0.0;
+    double cur_logl = -DBL_MAX;
+    for (int round = 0; round < QUARTET_MAX_ROUNDS; round++) {
+        double new_logl = 0.0;
+        // inner branch first, as it changes most between the topologies
+        for (int branch = 4; branch >= 0; branch--)
+            new_logl = optimizeBranch(leaf, branch);
+        if (new_logl < cur_logl + QUARTET_LOGL_EPSILON) {
+            cur_logl = max(cur_logl, new_logl);
+            break;
+        }
+        cur_logl = new_logl;
+    }
+    return cur_logl;
+}
+
+void QuartetLikelihood::multiplyMatrix(const double *mat, const double *vec, double *res) {
+    for (size_t i = 0; i < nstates; i++) {
+        double sum = 0.0;
+        const double *row = mat + i*nstates;
+        for (size_t j = 0; j < nstates; j++)
+            sum += row[j] * vec[j];
+        res[i] = sum;
+    }
+}
+
+double QuartetLikelihood::optimizeBranch(const int *leaf, int branch) {
+    ModelSubst *model = tree->getModel();
+    size_t nptn = ptn_freq.size();
+    size_t mat_size = nstates * nstates;
+
+    // transition matrices of the fixed branches
+    for (int b = 0; b < 5; b++) {
+        if (b == branch)
+            continue;
+        for (size_t c = 0; c < ncat; c++)
+            model->computeTransMatrix(lengths[b] * rates[c], &trans_mat[(b*ncat + c)*mat_size]);
+    }
+
+    double partial[4*nstates], inner_in[nstates], inner[nstates], u[nstates], w[nstates];
+
+    // partial likelihoods at both ends of the branch, projected into eigenspace
+    for (size_t ptn = 0; ptn < nptn; ptn++) {
+        const double *tip[4];
+        for (int i = 0; i < 4; i++)
+            tip[i] = &tip_lh[ptn_states[ptn*4 + leaf[i]] * nstates];
+        for (size_t c = 0; c < ncat; c++) {
+            for (int i = 0; i < 4; i++)
+                if (i != branch)
+                    multiplyMatrix(&trans_mat[(i*ncat + c)*mat_size], tip[i], partial + i*nstates);
+            if (branch == 4) {
+                // inner branch: (leaf 0, leaf 1) on one side, (leaf 2, leaf 3) on the other side
+                for (size_t s = 0; s < nstates; s++) {
+                    u[s] = state_freq[s] * partial[s] * partial[nstates + s];
+                    w[s] = partial[2*nstates + s] * partial[3*nstates + s];
+                }
+            } else {
+                // pendant branch: sibling leaf and inner branch on one side, the leaf on the other side
+                int first = (branch < 2) ? 0 : 2;
+                int sibling = first + 1 - (branch - first);
+                int far = 2 - first;
+                for (size_t s = 0; s < nstates; s++)
+                    inner_in[s] = partial[far*nstates + s] * partial[(far+1)*nstates + s];
+                multiplyMatrix(&trans_mat[(4*ncat + c)*mat_size], inner_in, inner);
+                for (size_t s = 0; s < nstates; s++) {
+                    u[s] = state_freq[s] * partial[sibling*nstates + s] * inner[s];
+                    w[s] = tip[branch][s];
+                }
+            }
+            double *this_theta = &theta[(ptn*ncat + c)*nstates];
+            for (size_t k = 0; k < nstates; k++) {
+                double uk = 0.0, wk = 0.0;
+                for (size_t s = 0; s < nstates; s++) {
+                    uk += u[s] * evec[s*nstates + k];
+                    wk += inv_evec[k*nstates + s] * w[s];
+                }
+                this_theta[k] = uk * wk;
+            }
+        }
+    }
+
+    Params &params = tree->params[0];
+    double current_len = lengths[branch];
+    double negative_lh;
+    double optx = minimizeNewton(params.min_branch_length, current_len, params.max_branch_length,
+                                 params.min_branch_length, negative_lh);
+    double opt_lh = -computeFunction(optx);
+    double orig_lh = -computeFunction(current_len);
+    if (orig_lh > opt_lh) {
+        // Newton-Raphson did not improve
+        optx = current_len;
+        opt_lh = orig_lh;
+    }
+    lengths[branch] = optx;
+    return opt_lh;
+}
+
+double QuartetLikelihood::computeBranchLikelihood(double len, double &df, double &ddf, bool derv) {
+    size_t nptn = ptn_freq.size();
+    double *lambda = &lambda_buf[0];
+    for (size_t c = 0; c < ncat; c++)
+        for (size_t k = 0; k < nstates; k++) {
+            lambda[c*nstates + k] = eval[k] * rates[c];
+            exp_buf[c*nstates + k] = exp(lambda[c*nstates + k] * len) * props[c];
+        }
+
+    double logl = 0.0;
+    df = ddf = 0.0;
+    size_t block = ncat * nstates;
+    for (size_t ptn = 0; ptn < nptn; ptn++) {
+        const double *this_theta = &theta[ptn*block];
+        double lh = ptn_invar[ptn], lh1 = 0.0, lh2 = 0.0;
+        for (size_t i = 0; i < block; i++) {
+            double val = this_theta[i] * exp_buf[i];
+            lh += val;
+            if (derv) {
+                val *= lambda[i];
+                lh1 += val;
+                lh2 += val * lambda[i];
+            }
+        }
+        lh = max(lh, DBL_MIN);
+        logl += log(lh) * ptn_freq[ptn];
+        if (derv) {
+            double d1 = lh1 / lh;
+            df += d1 * ptn_freq[ptn];
+            ddf += (lh2 / lh - d1*d1) * ptn_freq[ptn];
+        }
+    }
+    return logl;
+}
+
+double QuartetLikelihood::computeFunction(double value) {
+    double df, ddf;
+    return -computeBranchLikelihood(value, df, ddf, false);
+}
+
+void QuartetLikelihood::computeFuncDerv(double value, double &df, double &ddf) {
+    computeBranchLikelihood(value, df, ddf, true);
+    df = -df;
+    ddf = -ddf;
+}
@@ -0,0 +1,160 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef QUARTETLIKELIHOOD_H
+#define QUARTETLIKELIHOOD_H
+
+#include "phylotree.h"
+
+/**
+    Dedicated likelihood kernel for 4-taxon trees, used for likelihood mapping.
+    The three quartet topologies are evaluated directly on the 4-taxon site
+    patterns with precomputed tip vectors, and the 5 branch lengths are optimized
+    by Newton-Raphson in the eigenspace of the model, without building a
+    sub-alignment and a PhyloTree per quartet.
+    Supported are reversible, non-mixture models with discrete rate categories
+    (+I, +G, +R) on a single alignment, see isSupported().
+    One object must be used per thread; the model is only read.
+*/
+class QuartetLikelihood : public Optimization {
+public:
+
+    /**
+        constructor
+        @param tree tree providing alignment, model and rate heterogeneity
+    */
+    QuartetLikelihood(PhyloTree *tree);
+
+    /**
+        @param tree a tree with model
+        @return TRUE if the model of tree can be handled by this class
+    */
+    static bool isSupported(PhyloTree *tree);
+
+    /**
+        compute the log-likelihoods of the three topologies 01|23, 02|13, 03|12
+        with optimized branch lengths
+        @param seq_id IDs of the four sequences
+        @param[out] logl log-likelihoods of the three topologies
+    */
+    void computeQuartetLikelihoods(int *seq_id, double *logl);
+
+    /**
+        @param value length of the branch being optimized
+        @return negative log-likelihood
+    */
+    virtual double computeFunction(double value);
+
+    /**
+        @param value length of the branch being optimized
+        @param[out] df negative first derivative of the log-likelihood
+        @param[out] ddf negative second derivative of the log-likelihood
+    */
+    virtual void computeFuncDerv(double value, double &df, double &ddf);
+
+protected:
+
+    /** compress the alignment columns of four sequences into patterns */
+    void buildPatterns(int *seq_id);
+
+    /**
+        optimize branch lengths of one quartet topology
+        @param leaf pattern columns of the four leaves, (leaf[0],leaf[1]) | (leaf[2],leaf[3])
+        @return optimized log-likelihood
+    */
+    double optimizeTopology(const int *leaf);
+
+    /**
+        optimize one branch with the other branches fixed
+        @param leaf pattern columns of the four leaves
+        @param branch 0..3 for the branch to leaf[branch], 4 for the inner branch
+        @return log-likelihood after optimization
+    */
+    double optimizeBranch(const int *leaf, int branch);
+
+    /**
+        compute the log-likelihood and its derivatives as function of the optimized branch
+        @param len branch length
+        @param[out] df first derivative
+        @param[out] ddf second derivative
+        @param derv TRUE to compute the derivatives
+        @return log-likelihood
+    */
+    double computeBranchLikelihood(double len, double &df, double &ddf, bool derv);
+
+    /** multiply a transition matrix with a vector: res = mat * vec */
+    void multiplyMatrix(const double *mat, const double *vec, double *res);
+
+    /** tree providing alignment, model and rates */
+    PhyloTree *tree;
+
+    /** number of states */
+    size_t nstates;
+
+    /** number of discrete rate categories */
+    size_t ncat;
+
+    /** state frequencies */
+    DoubleVector state_freq;
+
+    /** category rates */
+    DoubleVector rates;
+
+    /** category proportions */
+    DoubleVector props;
+
+    /** proportion of invariable sites */
+    double p_invar;
+
+    /** eigenvalues, eigenvectors and inverse eigenvectors of the model */
+    double *eval, *evec, *inv_evec;
+
+    /** tip likelihood vectors for all states up to STATE_UNKNOWN */
+    DoubleVector tip_lh;
+
+    /** states of the 4 sequences for each quartet pattern */
+    IntVector ptn_states;
+
+    /** frequencies of quartet patterns */
+    DoubleVector ptn_freq;
+
+    /** likelihood of quartet patterns under the invariable site category */
+    DoubleVector ptn_invar;
+
+    /** current branch lengths of the topology being optimized */
+    double lengths[5];
+
+    /** transition matrices of the fixed branches (branch x category x state x state) */
+    DoubleVector trans_mat;
+
+    /** products of the partial likelihoods at both ends of the optimized branch
+        in eigenspace (pattern x category x state) */
+    DoubleVector theta;
+
+    /** buffer for exp(eigenvalue * rate * length) per category and state */
+    DoubleVector exp_buf;
+
+    /** buffer for eigenvalue * rate per category and state */
+    DoubleVector lambda_buf;
+
+};
+
+#endif
@@ -0,0 +1,325 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "splitcounter.h"
+#include "mtreeset.h"
+
+SplitCounter::SplitCounter(bool is_rooted) {
+    rooted = is_rooted;
+    chunk_size = 256;
+    tree_strings = nullptr;
+    burnin = 0;
+    max_count = INT_MAX;
+    in = nullptr;
+    num_read = 0;
+    fingerprinter = nullptr;
+    num_missing = 0;
+    num_trees = 0;
+    num_rooted = 0;
+    sum_weights = 0;
+}
+
+SplitCounter::~SplitCounter() {
+    closeSource();
+    if (fingerprinter)
+        delete fingerprinter;
+}
+
+void SplitCounter::countTrees(const char *infile, int burnin, int max_count, const char *tree_weight_file) {
+    cout << "Reading tree(s) file " << infile << " ..." << endl;
+    this->infile = infile;
+    this->burnin = burnin;
+    this->max_count = max_count;
+    tree_strings = nullptr;
+    tree_weights.clear();
+    if (tree_weight_file)
+        readIntVector(tree_weight_file, burnin, max_count, tree_weights);
+    scanTrees(nullptr);
+    cout << num_trees << " tree(s) loaded (" << num_rooted << " rooted and " << num_trees - num_rooted << " unrooted)" << endl;
+    if (tree_weight_file && num_trees != tree_weights.size())
+        outError("Tree file and tree weight file have different number of entries");
+}
+
+void SplitCounter::countTrees(StrVector &trees) {
+    if (trees.empty())
+        outError("Error! The number of input trees < 1");
+    infile = "";
+    burnin = 0;
+    max_count = INT_MAX;
+    tree_strings = &trees;
+    tree_weights.clear();
+    scanTrees(nullptr);
+}
+
+bool SplitCounter::readNextTree(istream &in, string &tree_str) {
+    tree_str.clear();
+    char ch;
+    while (in.get(ch) && isspace(ch)) ;
+    if (!in)
+        return false;
+    // a semi-colon inside a comment or a quoted name does not end the tree
+    bool in_comment = false, in_quote = false;
+    do {
+        tree_str += ch;
+        if (in_quote)
+            in_quote = (ch != '\'');
+        else if (in_comment)
+            in_comment = (ch != ']');
+        else if (ch == '\'')
+            in_quote = true;
+        else if (ch == '[')
+            in_comment = true;
+        else if (ch == ';')
+            return true;
+    } while (in.get(ch));
+    return true;
+}
+
+void SplitCounter::openSource(bool verbose) {
+    num_read = 0;
+    if (tree_strings)
+        return;
+    in = new ifstream(infile.c_str());
+    if (!in->is_open())
+        outError(ERR_READ_INPUT, infile);
+    if (burnin > 0) {
+        int cnt = 0;
+        string tree_str;
+        while (cnt < burnin && readNextTree(*in, tree_str))
+            cnt++;
+        if (verbose)
+            cout << cnt << " beginning tree(s) discarded" << endl;
+        while (in->peek() != EOF && isspace(in->peek()))
+            in->get();
+        if (in->peek() == EOF)
+            outError("Burnin value is too large.");
+    }
+}
+
+void SplitCounter::closeSource() {
+    if (in) {
+        in->close();
+        delete in;
+        in = nullptr;
+    }
+}
+
+bool SplitCounter::readChunk(StrVector &chunk) {
+    chunk.clear();
+    while (chunk.size() < chunk_size && num_read < max_count) {
+        if (tree_strings) {
+            if (num_read >= tree_strings->size())
+                break;
+            chunk.push_back(tree_strings->at(num_read));
+        } else {
+            string tree_str;
+            if (!readNextTree(*in, tree_str))
+                break;
+            chunk.push_back(tree_str);
+        }
+        num_read++;
+    }
+    return !chunk.empty();
+}
+
+void SplitCounter::initTaxa(string &tree_str) {
+    MTree tree;
+    stringstream ss(tree_str);
+    bool myrooted = rooted;
+    tree.readTree(ss, myrooted);
+    taxname.resize(tree.leafNum);
+    tree.getTaxaName(taxname);
+    // same taxon IDs as MTreeSet::convertSplits()
+    sort(taxname.begin(), taxname.end());
+    for (int i = 0; i < taxname.size(); i++)
+        taxon_id[taxname[i]] = i;
+    fingerprinter = new SplitFingerprinter(taxname.size());
+    hash_table.resize(1024, -1);
+}
+
+int SplitCounter::findSplit(const SplitFingerprint &fp, bool insert) {
+    size_t mask = hash_table.size() - 1;
+    size_t pos = SplitFingerprintHash()(fp) & mask;
+    while (hash_table[pos] >= 0) {
+        if (split_fps[hash_table[pos]] == fp)
+            return hash_table[pos];
+        pos = (pos + 1) & mask;
+    }
+    if (!insert)
+        return -1;
+    int id = split_fps.size();
+    split_fps.push_back(fp);
+    split_counts.push_back(0);
+    hash_table[pos] = id;
+    if (split_fps.size() * 2 > hash_table.size()) {
+        // keep the load factor below 1/2
+        hash_table.assign(hash_table.size() * 2, -1);
+        mask = hash_table.size() - 1;
+        for (int i = 0; i < split_fps.size(); i++) {
+            pos = SplitFingerprintHash()(split_fps[i]) & mask;
+            while (hash_table[pos] >= 0)
+                pos = (pos + 1) & mask;
+            hash_table[pos] = i;
+        }
+    }
+    return id;
+}
+
+void SplitCounter::scanTrees(SplitGraph *sg) {
+    openSource(sg == nullptr);
+    StrVector chunk;
+    int tree_start = 0;
+    while (readChunk(chunk)) {
+        if (!fingerprinter)
+            initTaxa(chunk[0]);
+        int ntrees = chunk.size();
+        IntVector weights(ntrees, 1);
+        if (!tree_weights.empty()) {
+            if (tree_start + ntrees > tree_weights.size())
+                outError("Tree file and tree weight file have different number of entries");
+            for (int i = 0; i < ntrees; i++)
+                weights[i] = tree_weights[tree_start + i];
+        }
+        vector<MTree*> trees(ntrees, nullptr);
+        vector<SplitFingerprintVector> fps_vec(ntrees);
+        vector<BranchVector> branches_vec(ntrees);
+        vector<const char*> errors(ntrees, nullptr);
+        IntVector tree_rooted(ntrees, 0);
+        int ntaxa = taxname.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < ntrees; i++) {
+            MTree *tree = new MTree;
+            stringstream ss(chunk[i]);
+            bool myrooted = rooted;
+            tree->readTree(ss, myrooted);
+            tree_rooted[i] = tree->rooted;
+            if (weights[i] == 0) {
+                delete tree;
+                continue;
+            }
+            if (tree->leafNum != ntaxa) {
+                errors[i] = "Tree has different number of taxa!";
+                delete tree;
+                continue;
+            }
+            NodeVector taxa;
+            tree->getTaxa(taxa);
+            vector<bool> found(ntaxa, false);
+            for (Node *taxon : taxa) {
+                auto it = taxon_id.find(taxon->name);
+                if (it == taxon_id.end() || found[it->second]) {
+                    errors[i] = "Tree has different taxa names!";
+                    break;
+                }
+                found[it->second] = true;
+                taxon->id = it->second;
+            }
+            if (errors[i]) {
+                delete tree;
+                continue;
+            }
+            fingerprinter->computeFingerprints(tree, fps_vec[i], nullptr, sg ? &branches_vec[i] : nullptr);
+            if (sg)
+                trees[i] = tree;
+            else
+                delete tree;
+        }
+        for (int i = 0; i < ntrees; i++)
+            if (errors[i])
+                outError(errors[i]);
+
+        for (int i = 0; i < ntrees; i++) {
+            if (!sg) {
+                // first pass: count the splits
+                num_trees++;
+                num_rooted += tree_rooted[i];
+                sum_weights += weights[i];
+                if (weights[i] == 0)
+                    continue;
+                for (SplitFingerprint &fp : fps_vec[i])
+                    split_counts[findSplit(fp, true)] += weights[i];
+                continue;
+            }
+            // second pass: materialise the output splits at their first occurrence
+            if (!trees[i])
+                continue;
+            for (size_t j = 0; j < fps_vec[i].size() && num_missing > 0; j++) {
+                int id = findSplit(fps_vec[i][j], false);
+                if (id < 0 || split_slot[id] < 0 || sg->at(split_slot[id]))
+                    continue;
+                Split *sp = new Split(ntaxa, split_counts[id]);
+                trees[i]->getTaxa(*sp, branches_vec[i][j].second, branches_vec[i][j].first);
+                if (sp->shouldInvert())
+                    sp->invert();
+                sg->at(split_slot[id]) = sp;
+                num_missing--;
+            }
+            delete trees[i];
+        }
+        tree_start += ntrees;
+        if (sg && num_missing == 0)
+            break;
+    }
+    closeSource();
+}
+
+void SplitCounter::convertSplits(SplitGraph &sg, double split_threshold, double weight_threshold) {
+    sg.createBlocks();
+    for (string &name : taxname)
+        sg.getTaxa()->AddTaxonLabel(NxsString(name.c_str()));
+
+    // filter the splits in the same order as MTreeSet::convertSplits(), where a discarded
+    // split is replaced by the last one, so that ties are broken identically later on
+    IntVector order(split_fps.size());
+    for (int i = 0; i < order.size(); i++)
+        order[i] = i;
+    int discarded = 0;
+    for (size_t i = 0; i < order.size(); ) {
+        if (split_counts[order[i]] <= weight_threshold) {
+            discarded++;
+            order[i] = order.back();
+            order.pop_back();
+        } else i++;
+    }
+    if (discarded)
+        cout << discarded << " split(s) discarded because weight <= " << weight_threshold << endl;
+
+    int nsplits = order.size();
+    double threshold = split_threshold * num_trees;
+    for (size_t i = 0; i < order.size(); ) {
+        if (split_counts[order[i]] <= threshold) {
+            order[i] = order.back();
+            order.pop_back();
+        } else i++;
+    }
+    cout << nsplits - order.size() << " split(s) discarded because frequency <= " << split_threshold << endl;
+
+    split_slot.assign(split_fps.size(), -1);
+    for (int i = 0; i < order.size(); i++)
+        split_slot[order[i]] = sg.size() + i;
+    sg.resize(sg.size() + order.size(), nullptr);
+    num_missing = order.size();
+    if (num_missing > 0)
+        scanTrees(&sg);
+    ASSERT(num_missing == 0);
+}
@@ -0,0 +1,185 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef SPLITCOUNTER_H
+#define SPLITCOUNTER_H
+
+#include "splitfingerprint.h"
+#include "pda/splitgraph.h"
+
+/**
+    Count the splits of a large collection of trees without keeping the trees in memory.
+    Trees are parsed in chunks (in parallel) and only the fingerprint and the frequency
+    of each distinct split are stored in a compact open-addressing table.
+    The splits themselves are materialised in a second pass over the trees, and only
+    for those that pass the frequency threshold of the consensus.
+    The resulting split system is the same as MTreeSet::convertSplits() with SW_COUNT.
+*/
+class SplitCounter {
+public:
+
+    /**
+        constructor
+        @param is_rooted TRUE to read trees as rooted
+    */
+    SplitCounter(bool is_rooted = false);
+
+    ~SplitCounter();
+
+    /**
+        count the splits of the trees in a file
+        @param infile tree file in Newick format
+        @param burnin number of beginning trees to discard
+        @param max_count maximum number of trees to read
+        @param tree_weight_file file with one integer weight per tree, nullptr for equal weights
+    */
+    void countTrees(const char *infile, int burnin, int max_count, const char *tree_weight_file = nullptr);
+
+    /**
+        count the splits of trees given as Newick strings, the strings must stay
+        unchanged until convertSplits() is called
+        @param trees Newick strings
+    */
+    void countTrees(StrVector &trees);
+
+    /**
+        convert the counted splits into a split system, weighted by their frequency
+        @param sg (OUT) resulting split graph, taxa sorted alphabetically
+        @param split_threshold only keep splits that appear in more than this proportion of trees
+        @param weight_threshold only keep splits with frequency more than this value
+    */
+    void convertSplits(SplitGraph &sg, double split_threshold, double weight_threshold);
+
+    /** @return number of trees read */
+    int getNumTrees() { return num_trees; }
+
+    /** @return sum of the weights of all trees */
+    int sumTreeWeights() { return sum_weights; }
+
+    /** number of trees parsed together */
+    int chunk_size;
+
+protected:
+
+    /**
+        read the next Newick string from a stream
+        @param in input stream
+        @param[out] tree_str Newick string including the final semi-colon
+        @return FALSE if there is no tree left
+    */
+    bool readNextTree(istream &in, string &tree_str);
+
+    /**
+        read the next chunk of Newick strings from the current source
+        @param[out] chunk Newick strings
+        @return FALSE if there is no tree left
+    */
+    bool readChunk(StrVector &chunk);
+
+    /**
+        start reading trees from the beginning of the source
+        @param verbose TRUE to report the discarded burnin trees
+    */
+    void openSource(bool verbose);
+
+    /** stop reading trees from the source */
+    void closeSource();
+
+    /**
+        take taxon names from the first tree
+        @param tree_str Newick string of the first tree
+    */
+    void initTaxa(string &tree_str);
+
+    /**
+        read the trees of the source chunk by chunk
+        @param sg split graph to materialise the splits of split_slot into, nullptr to count splits
+    */
+    void scanTrees(SplitGraph *sg);
+
+    /**
+        @param fp split fingerprint
+        @param insert TRUE to insert the fingerprint if absent
+        @return index of the split in split_fps, -1 if absent
+    */
+    int findSplit(const SplitFingerprint &fp, bool insert);
+
+    /** TRUE to read trees as rooted */
+    bool rooted;
+
+    /** tree file, empty if trees are given as strings */
+    string infile;
+
+    /** Newick strings, nullptr if trees are read from a file */
+    StrVector *tree_strings;
+
+    /** number of beginning trees to discard from the file */
+    int burnin;
+
+    /** maximum number of trees to read */
+    int max_count;
+
+    /** stream of the tree file while reading */
+    ifstream *in;
+
+    /** number of trees read from the current source */
+    int num_read;
+
+    /** weight of each tree, empty for equal weights */
+    IntVector tree_weights;
+
+    /** taxon names, sorted alphabetically */
+    StrVector taxname;
+
+    /** taxon ID of each taxon name */
+    unordered_map<string, int> taxon_id;
+
+    /** fingerprinter of the taxon set */
+    SplitFingerprinter *fingerprinter;
+
+    /** fingerprint of each distinct split, in the order of first occurrence */
+    SplitFingerprintVector split_fps;
+
+    /** sum of the weights of the trees containing each split */
+    IntVector split_counts;
+
+    /** open-addressing hash table of indices into split_fps, -1 for empty slots */
+    IntVector hash_table;
+
+    /** for each split: position in the output split graph, -1 if it is not output */
+    IntVector split_slot;
+
+    /** number of splits still to be materialised */
+    int num_missing;
+
+    /** number of trees */
+    int num_trees;
+
+    /** number of rooted trees */
+    int num_rooted;
+
+    /** sum of tree weights */
+    int sum_weights;
+
+};
+
+#endif
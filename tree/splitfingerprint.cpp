@@ -0,0 +1,162 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "splitfingerprint.h"
+
+/** one step of the splitmix64 generator, fixed so that fingerprints are reproducible */
+static inline uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+SplitFingerprinter::SplitFingerprinter(int ntaxa) {
+    this->ntaxa = ntaxa;
+    keys.resize(ntaxa);
+    if (ntaxa <= 128) {
+        // exact: one bit per taxon
+        for (int i = 0; i < ntaxa; i++) {
+            keys[i].lo = (i < 64) ? ((uint64_t)1 << i) : 0;
+            keys[i].hi = (i < 64) ? 0 : ((uint64_t)1 << (i - 64));
+        }
+        return;
+    }
+    uint64_t state = 0x5eed5eed5eed5eedULL;
+    for (int i = 0; i < ntaxa; i++) {
+        keys[i].lo = splitmix64(state) & ~(uint64_t)1;
+        keys[i].hi = splitmix64(state);
+    }
+}
+
+void SplitFingerprinter::computeFingerprints(MTree *tree, SplitFingerprintVector &fps,
+                                             DoubleVector *lengths, BranchVector *branches)
+{
+    ASSERT(tree->leafNum == ntaxa);
+    fps.clear();
+    if (lengths)
+        lengths->clear();
+    if (branches)
+        branches->clear();
+
+    SplitFingerprint all = {0, 0};
+    for (int i = 0; i < ntaxa; i++) {
+        all.lo ^= keys[i].lo;
+        all.hi ^= keys[i].hi;
+    }
+
+    // post-order traversal without recursion, as trees can be very deep
+    struct Frame {
+        Node *node, *dad;
+        Neighbor *from_dad;
+        size_t next;
+        bool has_child, has_taxon0;
+        SplitFingerprint fp;
+    };
+    vector<Frame> stack;
+    stack.push_back({tree->root, nullptr, nullptr, 0, false, false, {0, 0}});
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        if (frame.next < frame.node->neighbors.size()) {
+            Neighbor *nei = frame.node->neighbors[frame.next++];
+            if (nei->node == frame.dad)
+                continue;
+            frame.has_child = true;
+            Node *node = frame.node;
+            stack.push_back({nei->node, node, nei, 0, false, false, {0, 0}});
+            continue;
+        }
+        Frame child = frame;
+        stack.pop_back();
+        if (!child.has_child) {
+            ASSERT(child.node->id < ntaxa);
+            child.fp = keys[child.node->id];
+            child.has_taxon0 = (child.node->id == 0);
+        }
+        if (stack.empty())
+            break;
+        Frame &parent = stack.back();
+        parent.fp.lo ^= child.fp.lo;
+        parent.fp.hi ^= child.fp.hi;
+        parent.has_taxon0 |= child.has_taxon0;
+        // the split below a node of degree 2 is the same as the one above it
+        if (parent.node->degree() == 2)
+            continue;
+        SplitFingerprint fp = child.fp;
+        if (child.has_taxon0) {
+            fp.lo ^= all.lo;
+            fp.hi ^= all.hi;
+        }
+        fp.setCounted(true);
+        fps.push_back(fp);
+        if (lengths)
+            lengths->push_back(child.from_dad->length);
+        if (branches)
+            branches->push_back(make_pair(parent.node, child.node));
+    }
+}
+
+void SplitFingerprinter::sortFingerprints(SplitFingerprintVector &fps) {
+    sort(fps.begin(), fps.end());
+    size_t last = 0;
+    for (size_t i = 1; i < fps.size(); i++) {
+        if (fps[i] == fps[last]) {
+            if (fps[i].isCounted())
+                fps[last].setCounted(true);
+        } else
+            fps[++last] = fps[i];
+    }
+    if (!fps.empty())
+        fps.resize(last + 1);
+}
+
+int SplitFingerprinter::countDifferentSplits(const SplitFingerprintVector &fps1, const SplitFingerprintVector &fps2) {
+    size_t i = 0, j = 0;
+    int diff = 0;
+    while (i < fps1.size() && j < fps2.size()) {
+        if (fps1[i] == fps2[j]) {
+            i++;
+            j++;
+        } else if (fps1[i] < fps2[j]) {
+            diff += fps1[i++].isCounted();
+        } else {
+            diff += fps2[j++].isCounted();
+        }
+    }
+    for (; i < fps1.size(); i++)
+        diff += fps1[i].isCounted();
+    for (; j < fps2.size(); j++)
+        diff += fps2[j].isCounted();
+    return diff;
+}
+
+SplitFingerprint SplitFingerprinter::digest(const SplitFingerprintVector &fps) {
+    uint64_t state_lo = 0x243f6a8885a308d3ULL, state_hi = 0x13198a2e03707344ULL;
+    SplitFingerprint res = {0, 0};
+    for (const SplitFingerprint &fp : fps) {
+        state_lo ^= fp.lo >> 1;
+        state_hi ^= fp.hi;
+        res.lo ^= splitmix64(state_lo);
+        res.hi ^= splitmix64(state_hi);
+    }
+    res.lo = (res.lo ^ fps.size()) & ~(uint64_t)1;
+    return res;
+}
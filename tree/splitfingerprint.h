@@ -0,0 +1,120 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef SPLITFINGERPRINT_H
+#define SPLITFINGERPRINT_H
+
+#include "mtree.h"
+
+/**
+    128-bit fingerprint of a split: the XOR of the keys of the taxa on the side
+    without taxon 0. Up to 128 taxa the keys are single bits, so that the
+    fingerprint is the split itself. For more taxa the keys are random and two
+    different splits collide with probability 2^-127.
+    The lowest bit is never part of a fingerprint (taxon 0 is never on the
+    fingerprinted side) and marks the split as counted for distances.
+*/
+struct SplitFingerprint {
+    uint64_t lo, hi;
+
+    bool operator==(const SplitFingerprint &other) const {
+        return ((lo ^ other.lo) >> 1) == 0 && hi == other.hi;
+    }
+
+    bool operator!=(const SplitFingerprint &other) const {
+        return !(*this == other);
+    }
+
+    bool operator<(const SplitFingerprint &other) const {
+        if (hi != other.hi)
+            return hi < other.hi;
+        return (lo >> 1) < (other.lo >> 1);
+    }
+
+    /** @return TRUE if the split is counted for distances */
+    bool isCounted() const { return lo & 1; }
+
+    /** mark the split as counted or not */
+    void setCounted(bool counted) { lo = (lo & ~(uint64_t)1) | (uint64_t)counted; }
+};
+
+struct SplitFingerprintHash {
+    size_t operator()(const SplitFingerprint &fp) const {
+        return (fp.lo >> 1) ^ (fp.hi * 0x9e3779b97f4a7c15ULL);
+    }
+};
+
+typedef vector<SplitFingerprint> SplitFingerprintVector;
+
+/**
+    computes split fingerprints of trees on the same taxon set in one post-order pass,
+    identifying taxa by the IDs of the leaves
+*/
+class SplitFingerprinter {
+public:
+
+    /**
+        constructor
+        @param ntaxa number of taxa
+    */
+    SplitFingerprinter(int ntaxa);
+
+    /**
+        compute the fingerprints of all branches of a tree, in the same order as
+        MTree::convertSplits(), ignoring the duplicated split at nodes of degree 2
+        @param tree a tree
+        @param[out] fps fingerprints, all counted
+        @param[out] lengths branch length of each split, nullptr if not needed
+        @param[out] branches (parent, child) nodes of each split, nullptr if not needed
+    */
+    void computeFingerprints(MTree *tree, SplitFingerprintVector &fps,
+                             DoubleVector *lengths = nullptr, BranchVector *branches = nullptr);
+
+    /**
+        sort fingerprints and remove duplicates, keeping a split counted if any copy is counted
+        @param[in,out] fps fingerprints
+    */
+    static void sortFingerprints(SplitFingerprintVector &fps);
+
+    /**
+        @param fps1 sorted fingerprints of the first tree
+        @param fps2 sorted fingerprints of the second tree
+        @return number of counted splits present in only one of the trees
+    */
+    static int countDifferentSplits(const SplitFingerprintVector &fps1, const SplitFingerprintVector &fps2);
+
+    /**
+        @param fps sorted fingerprints of a tree
+        @return 128-bit digest of the split set, identical for trees of the same topology
+    */
+    static SplitFingerprint digest(const SplitFingerprintVector &fps);
+
+protected:
+
+    /** number of taxa */
+    int ntaxa;
+
+    /** key of each taxon */
+    SplitFingerprintVector keys;
+
+};
+
+#endif
@@ -0,0 +1,448 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "threadtuner.h"
+#include "phylotree.h"
+#include "phylosupertree.h"
+#include "phylotreemixlen.h"
+#include "utils/timeutil.h"
+#include "utils/MPIHelper.h"
+#include <cstdio>
+#include <sstream>
+
+#if defined WIN32 || defined _WIN32 || defined __WIN32__ || defined WIN64
+#else
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/** minimum run time of a probe in seconds */
+#define PROBE_TIME 0.2
+
+/** the measured time may deviate by this factor from the prediction before re-tuning */
+#define DRIFT_FACTOR 1.33
+
+/** @return name of the host, used to keep profiles of different machines apart */
+static string getHostName() {
+#if defined WIN32 || defined _WIN32 || defined __WIN32__ || defined WIN64
+    const char *name = getenv("COMPUTERNAME");
+    return name ? name : "localhost";
+#else
+    char hostname[256];
+    if (gethostname(hostname, sizeof(hostname)) != 0)
+        return "localhost";
+    hostname[sizeof(hostname)-1] = 0;
+    return hostname;
+#endif
+}
+
+ThreadTuner::ThreadTuner(PhyloTree *tree) {
+    this->tree = tree;
+    Params &params = Params::getInstance();
+    max_procs = min(countPhysicalCPUCores()/MPIHelper::getInstance().countSameHost(), params.num_threads_max);
+    if (!tree->isSuperTree()) {
+        // PhyloTree::setNumThreads does not use more threads than this
+        max_procs = min(max_procs, max((int)(tree->getAlnNPattern()/8), 1));
+    }
+    max_procs = max(max_procs, 1);
+    num_threads = 1;
+    num_reps = 1;
+    work = (double)tree->getAlnNPattern() * tree->aln->getNSeq();
+    coef_serial = coef_parallel = coef_overhead = 0.0;
+    has_model = false;
+    over_sites = params.parallel_over_sites;
+    key = computeKey();
+}
+
+string ThreadTuner::computeKey() {
+    // the profile of a workload class applies to data of similar dimensions
+    int nstates = tree->aln->num_states;
+    int nparts = 0;
+    if (tree->isSuperTree()) {
+        PhyloSuperTree *super_tree = (PhyloSuperTree*)tree;
+        nparts = super_tree->size();
+        nstates = 0;
+        for (auto it = super_tree->begin(); it != super_tree->end(); it++)
+            nstates = max(nstates, (*it)->aln->num_states);
+    }
+    stringstream ss;
+    ss << getHostName() << "|lk" << (int)tree->sse << "|cores" << max_procs
+       << "|states" << nstates << "|cat" << tree->getNumLhCat(WSL_MIXTURE_RATECAT)
+       << "|ptn" << (int)round(2*log2((double)max(tree->getAlnNPattern(), (size_t)1)))
+       << "|taxa" << (int)round(log2((double)max(tree->aln->getNSeq(), (size_t)1)))
+       << "|parts" << (nparts ? (int)round(log2((double)nparts)) + 1 : 0);
+    return ss.str();
+}
+
+double ThreadTuner::predict(int nthreads) {
+    return work * (coef_serial + coef_parallel/nthreads + coef_overhead*(nthreads-1));
+}
+
+void ThreadTuner::setThreads(int nthreads, bool sites) {
+    if (tree->isSuperTree())
+        ((PhyloSuperTree*)tree)->parallel_over_sites = sites;
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+    tree->setNumThreads(nthreads);
+    num_threads = nthreads;
+}
+
+double ThreadTuner::timeEvaluation() {
+    double begin_time = getRealTime();
+    for (int rep = 0; rep < num_reps; rep++) {
+        tree->clearAllPartialLH();
+        tree->computeLikelihood();
+    }
+    return (getRealTime() - begin_time) / num_reps;
+}
+
+double ThreadTuner::probe(int nthreads, bool sites) {
+    setThreads(nthreads, sites);
+    tree->initializeAllPartialLh();
+    // warm up the freshly allocated buffers
+    tree->clearAllPartialLH();
+    tree->computeLikelihood();
+    double time = timeEvaluation();
+    tree->deleteAllPartialLh();
+    return time;
+}
+
+void ThreadTuner::fitModel(IntVector &threads, DoubleVector &times) {
+    // least squares for every subset of the three terms, keeping the best fit
+    // with non-negative coefficients
+    int n = threads.size();
+    double best_rss = -1.0;
+    for (int mask = 1; mask < 8; mask++) {
+        int nterms = (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1);
+        if (nterms > n)
+            continue;
+        // normal equations A^T A x = A^T y
+        double ata[3][4];
+        memset(ata, 0, sizeof(ata));
+        for (int i = 0; i < n; i++) {
+            double row[3], y = times[i] / work;
+            int k = 0;
+            if (mask & 1) row[k++] = 1.0;
+            if (mask & 2) row[k++] = 1.0/threads[i];
+            if (mask & 4) row[k++] = threads[i] - 1.0;
+            for (int j = 0; j < nterms; j++) {
+                for (int l = 0; l < nterms; l++)
+                    ata[j][l] += row[j]*row[l];
+                ata[j][3] += row[j]*y;
+            }
+        }
+        // Gaussian elimination with partial pivoting
+        bool singular = false;
+        for (int j = 0; j < nterms && !singular; j++) {
+            int pivot = j;
+            for (int l = j+1; l < nterms; l++)
+                if (fabs(ata[l][j]) > fabs(ata[pivot][j]))
+                    pivot = l;
+            if (fabs(ata[pivot][j]) < 1e-300) {
+                singular = true;
+                break;
+            }
+            for (int l = 0; l < 4; l++)
+                swap(ata[j][l], ata[pivot][l]);
+            for (int l = 0; l < nterms; l++) {
+                if (l == j)
+                    continue;
+                double factor = ata[l][j] / ata[j][j];
+                for (int m = j; m < 4; m++)
+                    ata[l][m] -= factor * ata[j][m];
+            }
+        }
+        if (singular)
+            continue;
+        double coef[3] = {0.0, 0.0, 0.0};
+        int k = 0;
+        bool negative = false;
+        for (int j = 0; j < 3; j++) {
+            if (!(mask & (1 << j)))
+                continue;
+            coef[j] = ata[k][3] / ata[k][k];
+            k++;
+            if (coef[j] < 0.0)
+                negative = true;
+        }
+        if (negative)
+            continue;
+        double rss = 0.0;
+        for (int i = 0; i < n; i++) {
+            double diff = work * (coef[0] + coef[1]/threads[i] + coef[2]*(threads[i]-1)) - times[i];
+            rss += diff*diff;
+        }
+        if (best_rss < 0.0 || rss < best_rss) {
+            best_rss = rss;
+            coef_serial = coef[0];
+            coef_parallel = coef[1];
+            coef_overhead = coef[2];
+        }
+    }
+    has_model = (best_rss >= 0.0 && predict(1) > 0.0);
+}
+
+int ThreadTuner::bestFromModel() {
+    double best_time = predict(1);
+    for (int p = 2; p <= max_procs; p++)
+        best_time = min(best_time, predict(p));
+    for (int p = 1; p <= max_procs; p++) {
+        double time = predict(p);
+        if (time <= best_time*1.05 && predict(1) >= time*p*0.5)
+            return p;
+    }
+    return 1;
+}
+
+bool ThreadTuner::readCache(int &best) {
+    Params &params = Params::getInstance();
+    if (params.thread_cache_file.empty())
+        return false;
+    ifstream in(params.thread_cache_file);
+    if (!in.is_open())
+        return false;
+    string line;
+    bool found = false;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        istringstream ss(line);
+        string line_key;
+        int line_best, line_sites;
+        double serial, parallel, overhead;
+        if (!(ss >> line_key >> line_best >> line_sites >> serial >> parallel >> overhead))
+            continue;
+        if (line_key != key || line_best < 1)
+            continue;
+        // later entries override earlier ones
+        best = line_best;
+        over_sites = line_sites || params.parallel_over_sites;
+        coef_serial = serial;
+        coef_parallel = parallel;
+        coef_overhead = overhead;
+        found = true;
+    }
+    has_model = found && predict(1) > 0.0;
+    return found;
+}
+
+void ThreadTuner::writeCache(int best) {
+    Params &params = Params::getInstance();
+    if (params.thread_cache_file.empty() || MPIHelper::getInstance().isWorker())
+        return;
+    // keep the entries of other workload classes
+    StrVector lines;
+    ifstream in(params.thread_cache_file);
+    if (in.is_open()) {
+        string line;
+        while (getline(in, line)) {
+            if (line.compare(0, key.length()+1, key + "\t") != 0)
+                lines.push_back(line);
+        }
+        in.close();
+    }
+    stringstream entry;
+    entry.precision(6);
+    entry << key << "\t" << best << "\t" << (int)over_sites << "\t" << coef_serial << "\t"
+          << coef_parallel << "\t" << coef_overhead;
+    lines.push_back(entry.str());
+    // write to a temporary file first so that concurrent runs do not see a partial file
+    string tmp_file = params.thread_cache_file + "." + convertIntToString(MPIHelper::getInstance().getProcessID()) + ".tmp";
+    ofstream out(tmp_file);
+    if (!out.is_open()) {
+        if (verbose_mode >= VB_MED)
+            outWarning("Cannot write thread profile " + params.thread_cache_file);
+        return;
+    }
+    for (auto &line : lines)
+        out << line << endl;
+    out.close();
+    if (rename(tmp_file.c_str(), params.thread_cache_file.c_str()) != 0) {
+        remove(tmp_file.c_str());
+        if (verbose_mode >= VB_MED)
+            outWarning("Cannot write thread profile " + params.thread_cache_file);
+    }
+}
+
+int ThreadTuner::tune() {
+#ifndef _OPENMP
+    return 1;
+#else
+    Params &params = Params::getInstance();
+    int best;
+    if (readCache(best)) {
+        best = min(best, max_procs);
+        cout << "Using " << best << " threads from thread profile " << params.thread_cache_file;
+        if (tree->isSuperTree() && best > 1)
+            cout << " (multi-threading over " << (over_sites ? "sites" : "partitions") << ")";
+        cout << endl;
+        cout << "BEST NUMBER OF THREADS: " << best << endl << endl;
+        setThreads(best, over_sites);
+        return best;
+    }
+
+    cout << "Measuring multi-threading efficiency up to " << max_procs << " CPU cores" << endl;
+    double saved_score = tree->getCurScore();
+    tree->setLikelihoodKernel(tree->sse);
+    int nparts = tree->isSuperTree() ? ((PhyloSuperTree*)tree)->size() : 0;
+    // multi-threading over partitions is only possible with at most one thread per partition
+    bool try_partitions = nparts > 0 && !params.parallel_over_sites;
+
+    // calibrate the number of evaluations per probe from a single one after a warm-up
+    setThreads(1, over_sites);
+    tree->initializeAllPartialLh();
+    tree->clearAllPartialLH();
+    tree->computeLikelihood();
+    double begin_time = getRealTime();
+    tree->clearAllPartialLH();
+    tree->computeLikelihood();
+    double first_time = getRealTime() - begin_time;
+    tree->deleteAllPartialLh();
+    num_reps = max(1, min(1000, (int)ceil(PROBE_TIME / max(first_time, 1e-6))));
+
+    IntVector threads;
+    DoubleVector times;
+    BoolVector sites_mode;
+    int best_measured = 0;
+    for (int p = 1; ; p = min(p*2, max_procs)) {
+        bool sites = nparts > 0 && (!try_partitions || p > nparts);
+        double time = probe(p, sites);
+        if (try_partitions && p > 1 && p <= nparts) {
+            // also try multi-threading over sites within each partition
+            double time_sites = probe(p, true);
+            if (verbose_mode >= VB_MED)
+                cout << "Threads: " << p << " / over partitions: " << time << " sec / over sites: "
+                     << time_sites << " sec" << endl;
+            if (time_sites < time) {
+                time = time_sites;
+                sites = true;
+            }
+        }
+        threads.push_back(p);
+        times.push_back(time);
+        sites_mode.push_back(sites);
+        double speedup = times[0] / time;
+        cout << "Threads: " << p << " / Time: " << time*num_reps << " sec / Speedup: " << speedup
+             << " / Efficiency: " << (int)round(speedup*100/p) << "%";
+        if (nparts > 0 && p > 1)
+            cout << " / Over " << (sites ? "sites" : "partitions");
+        cout << endl;
+        if (time <= times[best_measured]*0.95)
+            best_measured = threads.size()-1;
+        // stop if too bad efficiency ( < 50%) or worse than 10% of the best run time
+        if (p >= max_procs || speedup*2 <= p || time > times[best_measured]*1.1)
+            break;
+    }
+
+    fitModel(threads, times);
+    best = threads[best_measured];
+    if (has_model) {
+        int model_best = bestFromModel();
+        // do not extrapolate beyond the probed range
+        if (model_best <= threads.back())
+            best = model_best;
+        if (verbose_mode >= VB_MED)
+            cout << "Run time model per pattern and taxon: " << coef_serial << " + " << coef_parallel
+                 << "/p + " << coef_overhead << "*(p-1) sec" << endl;
+    }
+    // multi-threading mode of the closest probe
+    for (int i = 0; i < threads.size() && threads[i] <= best; i++)
+        over_sites = sites_mode[i];
+    if (!has_model) {
+        // fall back to a model matching the best probe
+        coef_parallel = times[best_measured] * threads[best_measured] / work;
+        has_model = true;
+    }
+
+    cout << "BEST NUMBER OF THREADS: " << best << endl << endl;
+    writeCache(best);
+    setThreads(best, over_sites);
+    tree->setCurScore(saved_score);
+
+    // clear the relative treelength arrays if it is GHOST model
+    if (tree->isMixlen()) {
+        ((PhyloTreeMixlen*)tree)->clear_relative_treelen();
+    }
+    return best;
+#endif
+}
+
+void ThreadTuner::checkEfficiency() {
+#ifdef _OPENMP
+    if (!has_model || max_procs <= 1)
+        return;
+    double expected = predict(num_threads);
+    num_reps = max(1, min(1000, (int)ceil(PROBE_TIME / max(expected, 1e-6))));
+    double time = timeEvaluation();
+    if (verbose_mode >= VB_MED)
+        cout << "Likelihood evaluation with " << num_threads << " threads: " << time
+             << " sec (predicted " << expected << " sec)" << endl;
+    if (time <= expected*DRIFT_FACTOR && time*DRIFT_FACTOR >= expected)
+        return;
+
+    int cur_threads = num_threads;
+    int best = num_threads;
+    double best_time = time;
+    IntVector candidates;
+    if (num_threads > 1)
+        candidates.push_back(num_threads/2);
+    if (num_threads < max_procs)
+        candidates.push_back(min(num_threads*2, max_procs));
+    for (int p : candidates) {
+        tree->deleteAllPartialLh();
+        setThreads(p, over_sites);
+        tree->initializeAllPartialLh();
+        tree->clearAllPartialLH();
+        tree->computeLikelihood();
+        double p_time = timeEvaluation();
+        if (verbose_mode >= VB_MED)
+            cout << "Likelihood evaluation with " << p << " threads: " << p_time << " sec" << endl;
+        if (p_time <= best_time*0.95) {
+            best = p;
+            best_time = p_time;
+        }
+    }
+    if (num_threads != best) {
+        tree->deleteAllPartialLh();
+        setThreads(best, over_sites);
+        tree->initializeAllPartialLh();
+    }
+    // adapt the model to the current conditions of the machine
+    double scale = best_time / predict(best);
+    coef_serial *= scale;
+    coef_parallel *= scale;
+    coef_overhead *= scale;
+
+    cout << "Multi-threading efficiency changed, ";
+    if (best != cur_threads)
+        cout << "switching from " << cur_threads << " to " << best << " threads" << endl;
+    else
+        cout << "keeping " << best << " threads" << endl;
+    Params::getInstance().num_threads = best;
+    writeCache(best);
+    tree->clearAllPartialLH();
+    tree->setCurScore(tree->computeLikelihood());
+#endif
+}
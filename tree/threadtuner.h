@@ -0,0 +1,151 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef THREADTUNER_H
+#define THREADTUNER_H
+
+#include "utils/tools.h"
+
+class PhyloTree;
+
+/**
+    determines the number of threads for -T AUTO.
+    The run time of a full likelihood evaluation with p threads is modelled as
+    T(p) = W * (a + b/p + c*(p-1)), where W = #patterns * #taxa is the amount of work,
+    a the serial part, b the parallel part and c the synchronisation overhead per thread.
+    The coefficients are fitted from a few probes with 1, 2, 4, ... threads and stored
+    per host and workload class in a cache file, so that later runs on similar data
+    skip the probes. During the tree search the prediction is compared with the
+    measured time and the number of threads is re-tuned if they drift apart.
+*/
+class ThreadTuner {
+public:
+
+    /**
+        constructor
+        @param tree the tree to tune, with model and alignment already set up
+    */
+    ThreadTuner(PhyloTree *tree);
+
+    /**
+        determine the best number of threads, either from the cache file or by probing,
+        and set it for the tree. For a super tree it also chooses between multi-threading
+        over partitions and over alignment sites.
+        @return the best number of threads
+    */
+    int tune();
+
+    /**
+        time a likelihood evaluation with the current number of threads and, if it is
+        far off the prediction, probe half and twice as many threads and switch to the
+        fastest one. Must be called with the partial likelihood buffers allocated.
+    */
+    void checkEfficiency();
+
+protected:
+
+    /** the tree being tuned */
+    PhyloTree *tree;
+
+    /** maximum number of threads */
+    int max_procs;
+
+    /** current number of threads */
+    int num_threads;
+
+    /** number of likelihood evaluations per probe */
+    int num_reps;
+
+    /** amount of work of a likelihood evaluation: #patterns * #taxa */
+    double work;
+
+    /** coefficients of the run time model, per unit of work */
+    double coef_serial, coef_parallel, coef_overhead;
+
+    /** TRUE if the run time model was fitted or read from the cache */
+    bool has_model;
+
+    /** TRUE to multi-thread a super tree over alignment sites instead of partitions */
+    bool over_sites;
+
+    /** key of the workload class in the cache file */
+    string key;
+
+    /** @return the key of the workload class of the tree */
+    string computeKey();
+
+    /**
+        @param nthreads number of threads
+        @return predicted run time of one likelihood evaluation
+    */
+    double predict(int nthreads);
+
+    /**
+        set the number of threads and the multi-threading mode of the tree
+        @param nthreads number of threads
+        @param sites TRUE to multi-thread a super tree over alignment sites
+    */
+    void setThreads(int nthreads, bool sites);
+
+    /**
+        time num_reps likelihood evaluations with the current number of threads
+        @return run time of one likelihood evaluation
+    */
+    double timeEvaluation();
+
+    /**
+        allocate the buffers for a number of threads, time the likelihood evaluation
+        and free the buffers again
+        @param nthreads number of threads
+        @param sites TRUE to multi-thread a super tree over alignment sites
+        @return run time of one likelihood evaluation
+    */
+    double probe(int nthreads, bool sites);
+
+    /**
+        fit the run time model by non-negative least squares
+        @param threads numbers of threads probed
+        @param times run time of one likelihood evaluation for each of them
+    */
+    void fitModel(IntVector &threads, DoubleVector &times);
+
+    /**
+        @return the number of threads for which the model predicts the best run time,
+        taking the smallest one within 5% of the optimum with at least 50% efficiency
+    */
+    int bestFromModel();
+
+    /**
+        read the entry of the workload class from the cache file
+        @param[out] best best number of threads
+        @return TRUE if found
+    */
+    bool readCache(int &best);
+
+    /**
+        write the entry of the workload class to the cache file, replacing an old one
+        @param best best number of threads
+    */
+    void writeCache(int best);
+
+};
+
+#endif
@@ -0,0 +1,517 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "transferbootstrap.h"
+
+/**
+    bootstrap tree rooted at its root leaf, with a heavy-path decomposition
+    and a segment tree over the positions of the decomposition.
+    For a reference cluster A the segment tree stores for each bootstrap node v
+    the Hamming distance |A| + |B_v| - 2|A ∩ B_v| between A and the cluster B_v below v.
+    Adding a taxon to A increases all distances by 1 and decreases the distances
+    on the path from the taxon to the root by 2, which are O(log n) ranges.
+*/
+struct TransferAltTree {
+
+    /** number of nodes */
+    int nnodes;
+
+    /** parent node of each node, -1 for the root */
+    IntVector parent;
+
+    /** top of the heavy path of each node */
+    IntVector head;
+
+    /** position of each node, subtrees occupy consecutive positions */
+    IntVector pos;
+
+    /** number of nodes in the subtree of each node */
+    IntVector size;
+
+    /** node ID at each position */
+    IntVector pos_node;
+
+    /** leaf node of each reference taxon */
+    IntVector taxon_node;
+
+    /** reference taxon of each node, -1 for internal nodes */
+    IntVector node_taxon;
+
+    /** number of taxa below each node */
+    IntVector num_taxa;
+
+    /** minimum, maximum and pending addition of each segment */
+    IntVector seg_min, seg_max, seg_add;
+
+    /**
+        prepare a bootstrap tree
+        @param tree bootstrap tree
+        @param taxon_index reference taxon index of each taxon name
+        @param ntaxa number of taxa
+        @return FALSE if the tree does not have the reference taxa
+    */
+    bool init(MTree *tree, unordered_map<string, int> &taxon_index, int ntaxa) {
+        if (tree->leafNum != ntaxa + (tree->rooted ? 1 : 0))
+            return false;
+        nnodes = tree->nodeNum;
+        parent.assign(nnodes, -1);
+        head.assign(nnodes, 0);
+        pos.assign(nnodes, 0);
+        size.assign(nnodes, 1);
+        pos_node.assign(nnodes, 0);
+        taxon_node.assign(ntaxa, -1);
+        node_taxon.assign(nnodes, -1);
+        num_taxa.assign(nnodes, 0);
+
+        // pre-order traversal without recursion, as trees can be very deep
+        NodeVector nodes(nnodes, nullptr);
+        IntVector order;
+        order.reserve(nnodes);
+        vector<pair<Node*, Node*> > stack;
+        stack.push_back(make_pair(tree->root, (Node*)nullptr));
+        while (!stack.empty()) {
+            Node *node = stack.back().first;
+            Node *dad = stack.back().second;
+            stack.pop_back();
+            nodes[node->id] = node;
+            order.push_back(node->id);
+            if (node->isLeaf() && node->name != ROOT_NAME) {
+                auto it = taxon_index.find(node->name);
+                if (it == taxon_index.end() || taxon_node[it->second] >= 0)
+                    return false;
+                taxon_node[it->second] = node->id;
+                node_taxon[node->id] = it->second;
+                num_taxa[node->id] = 1;
+            }
+            FOR_NEIGHBOR_IT(node, dad, it) {
+                parent[(*it)->node->id] = node->id;
+                stack.push_back(make_pair((*it)->node, node));
+            }
+        }
+        if (order.size() != nnodes)
+            return false;
+
+        // subtree sizes and heavy children bottom-up
+        IntVector heavy(nnodes, -1);
+        for (auto it = order.rbegin(); it != order.rend(); it++) {
+            int p = parent[*it];
+            if (p < 0)
+                continue;
+            size[p] += size[*it];
+            num_taxa[p] += num_taxa[*it];
+            if (heavy[p] < 0 || size[*it] > size[heavy[p]])
+                heavy[p] = *it;
+        }
+
+        // positions: heavy child immediately after its parent
+        int next_pos = 0;
+        IntVector node_stack;
+        node_stack.push_back(tree->root->id);
+        while (!node_stack.empty()) {
+            int id = node_stack.back();
+            node_stack.pop_back();
+            pos[id] = next_pos;
+            pos_node[next_pos++] = id;
+            head[id] = (parent[id] >= 0 && heavy[parent[id]] == id) ? head[parent[id]] : id;
+            FOR_NEIGHBOR_IT(nodes[id], (parent[id] >= 0 ? nodes[parent[id]] : nullptr), it)
+                if ((*it)->node->id != heavy[id])
+                    node_stack.push_back((*it)->node->id);
+            if (heavy[id] >= 0)
+                node_stack.push_back(heavy[id]);
+        }
+
+        // empty reference cluster: the distance to B_v is |B_v|
+        seg_min.assign(4*nnodes, 0);
+        seg_max.assign(4*nnodes, 0);
+        seg_add.assign(4*nnodes, 0);
+        build(1, 0, nnodes-1);
+        return true;
+    }
+
+    void build(int seg, int left, int right) {
+        if (left == right) {
+            seg_min[seg] = seg_max[seg] = num_taxa[pos_node[left]];
+            return;
+        }
+        int mid = (left + right) / 2;
+        build(2*seg, left, mid);
+        build(2*seg+1, mid+1, right);
+        seg_min[seg] = min(seg_min[2*seg], seg_min[2*seg+1]);
+        seg_max[seg] = max(seg_max[2*seg], seg_max[2*seg+1]);
+    }
+
+    /** add value to all positions in [from, to] */
+    void add(int seg, int left, int right, int from, int to, int value) {
+        if (to < left || right < from)
+            return;
+        if (from <= left && right <= to) {
+            seg_min[seg] += value;
+            seg_max[seg] += value;
+            seg_add[seg] += value;
+            return;
+        }
+        int mid = (left + right) / 2;
+        add(2*seg, left, mid, from, to, value);
+        add(2*seg+1, mid+1, right, from, to, value);
+        seg_min[seg] = min(seg_min[2*seg], seg_min[2*seg+1]) + seg_add[seg];
+        seg_max[seg] = max(seg_max[2*seg], seg_max[2*seg+1]) + seg_add[seg];
+    }
+
+    /**
+        add or remove a taxon from the reference cluster
+        @param taxon reference taxon index
+        @param sign +1 to add, -1 to remove
+    */
+    void update(int taxon, int sign) {
+        add(1, 0, nnodes-1, 0, nnodes-1, sign);
+        for (int id = taxon_node[taxon]; id >= 0; id = parent[head[id]])
+            add(1, 0, nnodes-1, pos[head[id]], pos[id], -2*sign);
+    }
+
+    /** @return minimum Hamming distance over all bootstrap clusters */
+    int getMin() { return seg_min[1]; }
+
+    /** @return maximum Hamming distance over all bootstrap clusters */
+    int getMax() { return seg_max[1]; }
+
+    /**
+        @param value minimum or maximum distance
+        @param is_max TRUE to search for the maximum
+        @return node with this distance
+    */
+    int findNode(int value, bool is_max) {
+        int seg = 1, left = 0, right = nnodes-1;
+        while (left < right) {
+            value -= seg_add[seg];
+            int mid = (left + right) / 2;
+            if ((is_max ? seg_max[2*seg] : seg_min[2*seg]) == value) {
+                seg = 2*seg;
+                right = mid;
+            } else {
+                seg = 2*seg+1;
+                left = mid+1;
+            }
+        }
+        return pos_node[left];
+    }
+
+};
+
+TransferBootstrap::TransferBootstrap(MTree *ref_tree) {
+    dist_cutoff = 0.3;
+    compute_moved = false;
+    num_trees = 0;
+    tree.copyTree(ref_tree);
+    int nnodes = tree.nodeNum;
+
+    // the root of a rooted tree is not a taxon, as the transfer distance is defined on unrooted trees
+    NodeVector taxa;
+    tree.getTaxa(taxa);
+    IntVector node_taxon(nnodes, -1);
+    for (Node *node : taxa) {
+        if (node->name == ROOT_NAME)
+            continue;
+        if (taxon_index.find(node->name) != taxon_index.end())
+            outError("Duplicated taxon name in reference tree: ", node->name);
+        node_taxon[node->id] = taxon_names.size();
+        taxon_index[node->name] = taxon_names.size();
+        taxon_names.push_back(node->name);
+    }
+    ntaxa = taxon_names.size();
+
+    // pre-order traversal from the root, collecting the parent of each node
+    NodeVector parent(nnodes, nullptr);
+    NodeVector order;
+    vector<pair<Node*, Node*> > stack;
+    stack.push_back(make_pair(tree.root, (Node*)nullptr));
+    while (!stack.empty()) {
+        Node *node = stack.back().first;
+        Node *dad = stack.back().second;
+        stack.pop_back();
+        parent[node->id] = dad;
+        order.push_back(node);
+        // old supports are replaced
+        if (!node->isLeaf())
+            node->name = "";
+        FOR_NEIGHBOR_IT(node, dad, it)
+            stack.push_back(make_pair((*it)->node, node));
+    }
+
+    // number of taxa and heavy child of each node
+    IntVector num_taxa(nnodes, 0);
+    NodeVector heavy(nnodes, nullptr);
+    for (auto it = order.rbegin(); it != order.rend(); it++) {
+        Node *node = *it;
+        if (node == tree.root)
+            continue;
+        if (node_taxon[node->id] >= 0)
+            num_taxa[node->id] = 1;
+        Node *dad = parent[node->id];
+        num_taxa[dad->id] += num_taxa[node->id];
+        if (!heavy[dad->id] || num_taxa[node->id] > num_taxa[heavy[dad->id]->id])
+            heavy[dad->id] = node;
+    }
+
+    // taxa in depth-first order below the root, heavy child first;
+    // the taxon at the root is never part of a reference cluster
+    leaf_pos.assign(ntaxa, -1);
+    leaf_start.assign(nnodes, 0);
+    light_start.assign(nnodes, 0);
+    leaf_end.assign(nnodes, 0);
+    depth.assign(nnodes, 0);
+    branch_id.assign(nnodes, -1);
+    NodeVector node_stack;
+    FOR_NEIGHBOR_IT(tree.root, nullptr, it)
+        node_stack.push_back((*it)->node);
+    while (!node_stack.empty()) {
+        Node *node = node_stack.back();
+        node_stack.pop_back();
+        int id = node->id;
+        Node *dad = parent[id];
+        leaf_start[id] = leaf_order.size();
+        leaf_end[id] = leaf_start[id] + num_taxa[id];
+        light_start[id] = leaf_start[id] + (heavy[id] ? num_taxa[heavy[id]->id] : 0);
+        branch_id[id] = node->findNeighbor(dad)->id;
+        if (node_taxon[id] >= 0) {
+            leaf_pos[node_taxon[id]] = leaf_order.size();
+            leaf_order.push_back(node_taxon[id]);
+        } else if (num_taxa[id] >= 2 && ntaxa - num_taxa[id] >= 2) {
+            // below the root of a rooted tree, the two subtrees define the same split
+            bool root_split = (dad != tree.root && num_taxa[dad->id] == ntaxa && heavy[dad->id] != node
+                               && num_taxa[id] + num_taxa[heavy[dad->id]->id] == ntaxa);
+            if (!root_split) {
+                depth[id] = min(num_taxa[id], ntaxa - num_taxa[id]);
+                branch_nodes.push_back(node);
+            }
+        }
+        // a node starts a new heavy path unless it is the heavy child of its parent
+        if (dad == tree.root || heavy[dad->id] != node) {
+            IntVector path;
+            for (Node *path_node = node; path_node; path_node = heavy[path_node->id])
+                path.push_back(path_node->id);
+            reverse(path.begin(), path.end());
+            heavy_paths.push_back(path);
+        }
+        FOR_NEIGHBOR_IT(node, dad, it)
+            if ((*it)->node != heavy[id])
+                node_stack.push_back((*it)->node);
+        if (heavy[id])
+            node_stack.push_back(heavy[id]);
+    }
+
+    sort(branch_nodes.begin(), branch_nodes.end(), [&](Node *a, Node *b) {
+        return branch_id[a->id] < branch_id[b->id];
+    });
+    dist_sum.assign(nnodes, 0);
+    moved_sum.assign(ntaxa, 0.0);
+}
+
+int TransferBootstrap::computeTransferDistance(TransferAltTree &alt, IntVector &dist, vector<TransferMove> &moves) {
+    int min_depth = (int)ceil(1.0/dist_cutoff + 1.0);
+    int num_close = 0;
+    moves.clear();
+    for (IntVector &path : heavy_paths) {
+        // grow the cluster from the bottom of the path to its top
+        for (int id : path) {
+            for (int i = light_start[id]; i < leaf_end[id]; i++)
+                alt.update(leaf_order[i], 1);
+            if (depth[id] == 0)
+                continue;
+            int dist_min = alt.getMin();
+            int dist_flip = ntaxa - alt.getMax();
+            dist[id] = min(dist_min, dist_flip);
+            if ((double)dist[id] / (depth[id] - 1) <= dist_cutoff && depth[id] >= min_depth) {
+                num_close++;
+                if (!compute_moved)
+                    continue;
+                TransferMove move;
+                move.node = id;
+                move.flip = dist_flip < dist_min;
+                int alt_node = move.flip ? alt.findNode(alt.getMax(), true) : alt.findNode(alt.getMin(), false);
+                move.alt_start = alt.pos[alt_node];
+                move.alt_end = move.alt_start + alt.size[alt_node];
+                moves.push_back(move);
+            }
+        }
+        for (int i = leaf_start[path.back()]; i < leaf_end[path.back()]; i++)
+            alt.update(leaf_order[i], -1);
+    }
+    return num_close;
+}
+
+void TransferBootstrap::countMovedTaxa(TransferAltTree &alt, vector<TransferMove> &moves, IntVector &moved) {
+    // a taxon moves around a branch if it is in A xor B for the reference cluster A and the
+    // closest bootstrap cluster B, or in neither or both if the complement of B is closer:
+    // [A xor B] = [A] + [B] - 2[A and B], the last term as rectangles (A range, B range)
+    int nleaves = leaf_order.size();
+    IntVector ref_add(nleaves+1, 0), alt_add(alt.nnodes+1, 0);
+    IntVector first_move(nleaves+2, 0), move_order(2*moves.size());
+    int all_add = 0;
+    for (TransferMove &move : moves) {
+        int sign = move.flip ? -1 : 1;
+        all_add += move.flip ? 1 : 0;
+        ref_add[leaf_start[move.node]] += sign;
+        ref_add[leaf_end[move.node]] -= sign;
+        alt_add[move.alt_start] += sign;
+        alt_add[move.alt_end] -= sign;
+        first_move[leaf_start[move.node]+1]++;
+        first_move[leaf_end[move.node]+1]++;
+    }
+    // bucket the rectangle borders by reference position
+    for (int i = 0; i <= nleaves; i++)
+        first_move[i+1] += first_move[i];
+    IntVector next_move(first_move.begin(), first_move.end()-1);
+    for (int i = 0; i < (int)moves.size(); i++) {
+        move_order[next_move[leaf_start[moves[i].node]]++] = i;
+        move_order[next_move[leaf_end[moves[i].node]]++] = ~i;
+    }
+
+    // Fenwick tree over the bootstrap positions: range addition, point query
+    IntVector fenwick(alt.nnodes+1, 0);
+    auto fenwickAdd = [&](int pos, int value) {
+        for (pos++; pos <= alt.nnodes; pos += pos & (-pos))
+            fenwick[pos] += value;
+    };
+    auto fenwickGet = [&](int pos) {
+        int value = 0;
+        for (pos++; pos > 0; pos -= pos & (-pos))
+            value += fenwick[pos];
+        return value;
+    };
+
+    int ref_sum = 0;
+    for (int i = 0; i < nleaves; i++) {
+        for (int j = first_move[i]; j < first_move[i+1]; j++) {
+            bool open = move_order[j] >= 0;
+            TransferMove &move = moves[open ? move_order[j] : ~move_order[j]];
+            int value = (move.flip ? 2 : -2) * (open ? 1 : -1);
+            fenwickAdd(move.alt_start, value);
+            fenwickAdd(move.alt_end, -value);
+        }
+        int taxon = leaf_order[i];
+        ref_sum += ref_add[i];
+        moved[taxon] = all_add + ref_sum + fenwickGet(alt.pos[alt.taxon_node[taxon]]);
+    }
+    // the taxon at the root of the reference tree is in no reference cluster
+    for (int taxon = 0; taxon < ntaxa; taxon++)
+        if (leaf_pos[taxon] < 0)
+            moved[taxon] = all_add;
+    int alt_sum = 0;
+    for (int p = 0; p < alt.nnodes; p++) {
+        alt_sum += alt_add[p];
+        int taxon = alt.node_taxon[alt.pos_node[p]];
+        if (taxon >= 0)
+            moved[taxon] += alt_sum;
+    }
+}
+
+int TransferBootstrap::addTrees(MTreeSet &trees) {
+    int ntrees = trees.size();
+    int num_used = 0;
+    size_t nnodes = tree.nodeNum;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        TransferAltTree alt;
+        IntVector dist(nnodes, 0), moved(ntaxa, 0);
+        vector<TransferMove> moves;
+        vector<int64_t> local_dist(nnodes, 0);
+        DoubleVector local_moved(ntaxa, 0.0);
+        int local_used = 0;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int i = 0; i < ntrees; i++) {
+            if (!alt.init(trees[i], taxon_index, ntaxa))
+                continue;
+            local_used++;
+            int num_close = computeTransferDistance(alt, dist, moves);
+            for (Node *node : branch_nodes)
+                local_dist[node->id] += dist[node->id];
+            if (num_close > 0 && compute_moved) {
+                countMovedTaxa(alt, moves, moved);
+                for (int taxon = 0; taxon < ntaxa; taxon++)
+                    local_moved[taxon] += (double)moved[taxon] / num_close;
+            }
+        }
+#ifdef _OPENMP
+#pragma omp critical(transfer_bootstrap)
+#endif
+        {
+            num_used += local_used;
+            for (size_t id = 0; id < nnodes; id++)
+                dist_sum[id] += local_dist[id];
+            for (int taxon = 0; taxon < ntaxa; taxon++)
+                moved_sum[taxon] += local_moved[taxon];
+        }
+    }
+    if (num_used < ntrees)
+        outWarning(convertIntToString(ntrees - num_used) + " trees with different taxa than the reference tree were skipped");
+    num_trees += num_used;
+    return num_used;
+}
+
+void TransferBootstrap::getSupport(DoubleVector &support) {
+    support.assign(tree.nodeNum, -1.0);
+    if (num_trees == 0)
+        return;
+    for (Node *node : branch_nodes) {
+        double mean_dist = (double)dist_sum[node->id] / num_trees;
+        support[node->id] = 1.0 - mean_dist / (depth[node->id] - 1.0);
+    }
+}
+
+void TransferBootstrap::writeTree(const char *file_name, bool raw) {
+    DoubleVector support;
+    getSupport(support);
+    for (Node *node : branch_nodes) {
+        stringstream ss;
+        ss.precision(6);
+        ss << fixed;
+        if (raw)
+            ss << branch_id[node->id] << "|" << (double)dist_sum[node->id] / max(num_trees, 1)
+               << "|" << depth[node->id];
+        else
+            ss << support[node->id];
+        node->name = ss.str();
+    }
+    tree.printTree(file_name, WT_BR_LEN | WT_NEWLINE);
+}
+
+void TransferBootstrap::writeStatistics(const char *file_name) {
+    try {
+        ofstream out;
+        out.exceptions(ios::failbit | ios::badbit);
+        out.open(file_name);
+        out << fixed << setprecision(6);
+        out << "EdgeId\tDepth\tMeanMinDist" << endl;
+        for (Node *node : branch_nodes)
+            out << branch_id[node->id] << "\t" << depth[node->id] << "\t"
+                << (double)dist_sum[node->id] / max(num_trees, 1) << endl;
+        out << "Taxon\ttIndex" << endl;
+        for (int taxon = 0; taxon < ntaxa; taxon++)
+            out << taxon_names[taxon] << "\t" << moved_sum[taxon] * 100.0 / max(num_trees, 1) << endl;
+        out.close();
+    } catch (ios::failure &) {
+        outError(ERR_WRITE_OUTPUT, file_name);
+    }
+}
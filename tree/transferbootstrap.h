@@ -0,0 +1,163 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef TRANSFERBOOTSTRAP_H
+#define TRANSFERBOOTSTRAP_H
+
+#include "mtreeset.h"
+
+struct TransferAltTree;
+
+/** closest bootstrap cluster of a reference branch, for the transfer index of the taxa */
+struct TransferMove {
+    /** reference node below the branch */
+    int node;
+    /** positions of the bootstrap cluster in TransferAltTree */
+    int alt_start, alt_end;
+    /** TRUE if the complement of the bootstrap cluster is the closer one */
+    bool flip;
+};
+
+/**
+    Transfer bootstrap expectation (TBE, Lemoine et al. 2018) of the branches
+    of a reference tree computed directly on in-memory trees.
+    The transfer distance of all reference branches to one bootstrap tree is
+    computed in O(n log^3 n) instead of O(n^2): the reference tree is traversed
+    along its heavy paths, so that each taxon is added to the current cluster
+    O(log n) times, and the Hamming distances of the cluster to all bootstrap
+    clusters are maintained in a segment tree over a heavy-path decomposition
+    of the bootstrap tree. Bootstrap trees are processed in parallel.
+    The output files are the same as those of booster.
+*/
+class TransferBootstrap {
+public:
+
+    /**
+        constructor
+        @param ref_tree reference tree, a copy is kept
+    */
+    TransferBootstrap(MTree *ref_tree);
+
+    /**
+        add the transfer distances of a set of bootstrap trees
+        @param trees bootstrap trees on the same taxa as the reference tree
+        @return number of trees used, trees with different taxa are skipped
+    */
+    int addTrees(MTreeSet &trees);
+
+    /**
+        @param[out] support TBE support of each internal branch of the reference tree,
+        indexed by the ID of the node below the branch, -1 for other nodes
+    */
+    void getSupport(DoubleVector &support);
+
+    /**
+        write the reference tree with TBE supports as internal node names
+        @param file_name output tree file
+        @param raw TRUE to write "branch_id|mean_distance|depth" instead of the support
+    */
+    void writeTree(const char *file_name, bool raw = false);
+
+    /**
+        write mean transfer distance of each branch and transfer index of each taxon
+        @param file_name output statistic file
+    */
+    void writeStatistics(const char *file_name);
+
+    /** normalized distance cutoff for a branch to count taxon moves (booster default) */
+    double dist_cutoff;
+
+    /** TRUE to compute the transfer index of each taxon, needed for writeStatistics() */
+    bool compute_moved;
+
+protected:
+
+    /**
+        compute the transfer distance of all reference branches to one bootstrap tree
+        @param alt bootstrap tree prepared for the computation
+        @param[out] dist transfer distance of each reference branch
+        @param[out] moves closest bootstrap cluster of each close branch, if compute_moved is set
+        @return number of close branches
+    */
+    int computeTransferDistance(TransferAltTree &alt, IntVector &dist, vector<TransferMove> &moves);
+
+    /**
+        count for each taxon the close branches around which it moves, i.e. the taxa in
+        the symmetric difference of the reference and the closest bootstrap cluster.
+        Each cluster is a range of positions, so all branches are counted together in
+        O((n + k) log n) with a sweep over the reference positions.
+        @param alt bootstrap tree
+        @param moves closest bootstrap cluster of the k close branches
+        @param[out] moved number of close branches around which each taxon moves
+    */
+    void countMovedTaxa(TransferAltTree &alt, vector<TransferMove> &moves, IntVector &moved);
+
+    /** reference tree */
+    MTree tree;
+
+    /** number of taxa */
+    int ntaxa;
+
+    /** taxon names in the order of the reference tree */
+    StrVector taxon_names;
+
+    /** taxon index of each taxon name */
+    unordered_map<string, int> taxon_index;
+
+    /** taxa in depth-first order of the reference tree, heavy subtree first */
+    IntVector leaf_order;
+
+    /** position of each taxon in leaf_order, -1 for the taxon at the root */
+    IntVector leaf_pos;
+
+    /** for each reference node: first position of its taxa in leaf_order */
+    IntVector leaf_start;
+
+    /** for each reference node: first position of the taxa outside its heavy child */
+    IntVector light_start;
+
+    /** for each reference node: position after its last taxon in leaf_order */
+    IntVector leaf_end;
+
+    /** heavy paths of the reference tree from the bottom to the top, as node IDs */
+    vector<IntVector> heavy_paths;
+
+    /** for each reference node: depth of its branch to the parent, 0 for external branches */
+    IntVector depth;
+
+    /** for each reference node: ID of the branch to the parent */
+    IntVector branch_id;
+
+    /** nodes below the internal branches of the reference tree */
+    NodeVector branch_nodes;
+
+    /** sum of transfer distances over bootstrap trees for each reference node */
+    vector<int64_t> dist_sum;
+
+    /** sum over bootstrap trees of the proportion of close branches around which each taxon moves */
+    DoubleVector moved_sum;
+
+    /** number of bootstrap trees added */
+    int num_trees;
+
+};
+
+#endif
@@ -670,28 +670,28 @@
     clear_pl_lh[0] = clear_pl_lh[1] = clear_pl_lh[2] = clear_pl_lh[3] = 1;
 
     double* T1_partial_lh;
-    if(((PhyloNeighbor*) (*nniMoves[0].node1Nei_it))->get_partial_lh_computed() == 0){
+    if((((PhyloNeighbor*) (*nniMoves[0].node1Nei_it))->get_partial_lh_computed() & 1) == 0){
     	tree->computePartialLikelihood((PhyloNeighbor*) (*nniMoves[0].node1Nei_it), node1);
     	clear_pl_lh[0] = 0;
     }
     T1_partial_lh = ((PhyloNeighbor*) (*nniMoves[0].node1Nei_it))->get_partial_lh();
 
     double* T2_partial_lh;
-    if(((PhyloNeighbor*) (*node1Nei2_it))->get_partial_lh_computed() == 0){
+    if((((PhyloNeighbor*) (*node1Nei2_it))->get_partial_lh_computed() & 1) == 0){
     	tree->computePartialLikelihood(((PhyloNeighbor*) (*node1Nei2_it)), node1);
     	clear_pl_lh[1] = 0;
     }
     T2_partial_lh = ((PhyloNeighbor*) (*node1Nei2_it))->get_partial_lh();
 
     double* T3_partial_lh;
-    if(((PhyloNeighbor*) (*nniMoves[0].node2Nei_it))->get_partial_lh_computed() == 0){
+    if((((PhyloNeighbor*) (*nniMoves[0].node2Nei_it))->get_partial_lh_computed() & 1) == 0){
     	tree->computePartialLikelihood(((PhyloNeighbor*) (*nniMoves[0].node2Nei_it)), node1);
     	clear_pl_lh[2] = 0;
     }
     T3_partial_lh = ((PhyloNeighbor*) (*nniMoves[0].node2Nei_it))->get_partial_lh();
 
     double* T4_partial_lh;
-    if(((PhyloNeighbor*) (*nniMoves[1].node2Nei_it))->get_partial_lh_computed() == 0){
+    if((((PhyloNeighbor*) (*nniMoves[1].node2Nei_it))->get_partial_lh_computed() & 1) == 0){
     	tree->computePartialLikelihood(((PhyloNeighbor*) (*nniMoves[1].node2Nei_it)), node1);
     	clear_pl_lh[3] = 0;
     }
@@ -840,13 +840,13 @@
 //	int loglh = tree->computeLikelihood();
 
     double* T1_partial_lh;
-    if(nei1->get_partial_lh_computed() == 0){
+    if((nei1->get_partial_lh_computed() & 1) == 0){
     	tree->computePartialLikelihood(nei1, node1);
     }
     T1_partial_lh = nei1->get_partial_lh();
 
     double* T2_partial_lh;
-    if(nei2->get_partial_lh_computed() == 0){
+    if((nei2->get_partial_lh_computed() & 1) == 0){
     	tree->computePartialLikelihood(nei2, node2);
     }
     T2_partial_lh = nei2->get_partial_lh();
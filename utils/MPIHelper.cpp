@@ -31,6 +31,7 @@ void MPIHelper::init(int argc, char *argv[]) {
     setNumTreeReceived(0);
     setNumTreeSent(0);
     setNumNNISearch(0);
+    wait_time = 0.0;
 #endif
 }
 
@@ -125,7 +126,9 @@ void MPIHelper::sendCheckpoint(Checkpoint *ckp, int dest) {
 
 int MPIHelper::recvString(string &str, int src, int tag) {
     MPI_Status status;
+    double start = getRealTime();
     MPI_Probe(src, tag, MPI_COMM_WORLD, &status);
+    addWaitTime(getRealTime() - start);
     int msgCount;
     MPI_Get_count(&status, MPI_CHAR, &msgCount);
     // receive the message
@@ -155,7 +158,9 @@ void MPIHelper::broadcastCheckpoint(Checkpoint *ckp) {
     }
 
     // broadcast the count for workers
+    double start = getRealTime();
     MPI_Bcast(&msgCount, 1, MPI_INT, PROC_MASTER, MPI_COMM_WORLD);
+    addWaitTime(getRealTime() - start);
 
     char *recvBuffer = new char[msgCount];
     if (isMaster())
@@ -187,7 +192,9 @@ void MPIHelper::gatherCheckpoint(Checkpoint *ckp) {
         msgCounts = new int[getNumProcesses()];
         displ = new int[getNumProcesses()];
     }
+    double start = getRealTime();
     MPI_Gather(&msgCount, 1, MPI_INT, msgCounts, 1, MPI_INT, PROC_MASTER, MPI_COMM_WORLD);
+    addWaitTime(getRealTime() - start);
 
     // now real contents to MASTER
     if (isMaster()) {
@@ -213,7 +220,93 @@ void MPIHelper::gatherCheckpoint(Checkpoint *ckp) {
     }
 }
 
+void MPIHelper::isendBuffer(const string &buf, int dest, int tag) {
+    pending_sends.emplace_back();
+    pending_sends.back().second = buf;
+    string &data = pending_sends.back().second;
+    // synchronous mode: the send completes only once the receiver got it, see IQTree::finishGossip()
+    MPI_Issend((void*)data.data(), data.size(), MPI_BYTE, dest, tag, MPI_COMM_WORLD, &pending_sends.back().first);
+}
+
+bool MPIHelper::testSends() {
+    for (auto it = pending_sends.begin(); it != pending_sends.end(); ) {
+        int flag = 0;
+        MPI_Test(&it->first, &flag, MPI_STATUS_IGNORE);
+        if (flag)
+            it = pending_sends.erase(it);
+        else
+            it++;
+    }
+    return pending_sends.empty();
+}
+
+int MPIHelper::probeBuffer(string &buf, int src, int tag) {
+    int flag = 0;
+    MPI_Status status;
+    MPI_Iprobe(src, tag, MPI_COMM_WORLD, &flag, &status);
+    if (!flag)
+        return -1;
+    int msgCount;
+    MPI_Get_count(&status, MPI_BYTE, &msgCount);
+    buf.resize(msgCount);
+    // the message has arrived, thus this does not wait
+    MPI_Recv(&buf[0], msgCount, MPI_BYTE, status.MPI_SOURCE, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    return status.MPI_SOURCE;
+}
+
+void MPIHelper::allgatherBuffer(const string &buf, vector<string> &all) {
+    int nproc = getNumProcesses();
+    int msgCount = buf.size();
+    vector<int> msgCounts(nproc), displ(nproc);
+    double start = getRealTime();
+    MPI_Allgather(&msgCount, 1, MPI_INT, &msgCounts[0], 1, MPI_INT, MPI_COMM_WORLD);
+    int totalCount = 0;
+    for (int i = 0; i < nproc; i++) {
+        displ[i] = totalCount;
+        totalCount += msgCounts[i];
+    }
+    string recvBuffer(totalCount, 0);
+    MPI_Allgatherv((void*)buf.data(), msgCount, MPI_BYTE, &recvBuffer[0], &msgCounts[0], &displ[0], MPI_BYTE,
+                   MPI_COMM_WORLD);
+    addWaitTime(getRealTime() - start);
+    all.resize(nproc);
+    for (int i = 0; i < nproc; i++)
+        all[i] = recvBuffer.substr(displ[i], msgCounts[i]);
+}
+
+void MPIHelper::startBarrier() {
+    MPI_Ibarrier(MPI_COMM_WORLD, &barrier_request);
+}
+
+bool MPIHelper::testBarrier() {
+    int flag = 0;
+    MPI_Test(&barrier_request, &flag, MPI_STATUS_IGNORE);
+    return flag;
+}
+
+#endif
+
+void MPIHelper::sumAllProcesses(double *values, int n) {
+#ifdef _IQTREE_MPI
+    double start = getRealTime();
+    MPI_Allreduce(MPI_IN_PLACE, values, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    addWaitTime(getRealTime() - start);
 #endif
+}
+
+void MPIHelper::reportWaitTime(const char *scheme) {
+#ifdef _IQTREE_MPI
+    DoubleVector times(getNumProcesses());
+    MPI_Gather(&wait_time, 1, MPI_DOUBLE, &times[0], 1, MPI_DOUBLE, PROC_MASTER, MPI_COMM_WORLD);
+    if (isMaster()) {
+        ostringstream ss;
+        ss << fixed << setprecision(3);
+        for (int i = 0; i < getNumProcesses(); i++)
+            ss << " " << i << ":" << times[i] << "s";
+        cout << "Time waiting for other processes (" << scheme << " tree exchange):" << ss.str() << endl;
+    }
+#endif
+}
 
 MPIHelper::~MPIHelper() {
 //    cleanUpMessages();
@@ -24,6 +24,7 @@
 
 #include <string>
 #include <vector>
+#include <list>
 #include "utils/tools.h"
 #include "utils/checkpoint.h"
 
@@ -37,6 +38,7 @@
 #define BOOT_TAG 3 // Message to please send bootstrap trees
 #define BOOT_TREE_TAG 4 // bootstrap tree tag
 #define LOGL_CUTOFF_TAG 5 // send logl_cutoff for ultrafast bootstrap
+#define GOSSIP_TAG 6 // binary encoded candidate trees exchanged between any processes
 
 // using namespace std;
 
@@ -140,8 +142,67 @@ public:
         @param ckp Checkpoint object
     */
     void gatherCheckpoint(Checkpoint *ckp);
+
+    /**
+        non-blocking synchronous send of a binary buffer, completed once it is received;
+        the buffer is copied and kept until the send completed
+        @param buf buffer to send
+        @param dest destination process
+        @param tag message tag
+    */
+    void isendBuffer(const string &buf, int dest, int tag);
+
+    /**
+        release buffers of completed non-blocking sends
+        @return true if no send is pending any more
+    */
+    bool testSends();
+
+    /**
+        receive a binary buffer if a message has arrived, without waiting
+        @param[out] buf buffer received
+        @param src source process or MPI_ANY_SOURCE
+        @param tag message tag
+        @return the source process, -1 if no message has arrived
+    */
+    int probeBuffer(string &buf, int src, int tag);
+
+    /**
+        wrapper for MPI_Allgatherv of binary buffers of different lengths
+        @param buf buffer of this process
+        @param[out] all buffers of all processes
+    */
+    void allgatherBuffer(const string &buf, vector<string> &all);
+
+    /** start a non-blocking barrier */
+    void startBarrier();
+
+    /** @return true if the barrier started by startBarrier() is completed */
+    bool testBarrier();
 #endif
 
+    /**
+        sum values over all processes (MPI_Allreduce), every process gets the sums
+        @param[in,out] values values of this process, replaced by the sums
+        @param n number of values
+    */
+    void sumAllProcesses(double *values, int n);
+
+    /** add time spent waiting for other processes */
+    void addWaitTime(double time) {
+        wait_time += time;
+    }
+
+    double getWaitTime() const {
+        return wait_time;
+    }
+
+    /**
+        gather the wait time of all processes and print it at the master
+        @param scheme name of the tree exchange scheme
+    */
+    void reportWaitTime(const char *scheme);
+
     void increaseTreeSent(int inc = 1) {
         numTreeSent += inc;
     }
@@ -165,6 +226,17 @@ private:
 
     int numProcesses;
 
+    /** time in seconds spent waiting for other processes */
+    double wait_time;
+
+#ifdef _IQTREE_MPI
+    /** requests and buffers of pending non-blocking sends */
+    list<pair<MPI_Request, string> > pending_sends;
+
+    /** request of the non-blocking barrier */
+    MPI_Request barrier_request;
+#endif
+
 public:
     int getNumTreeReceived() const {
         return numTreeReceived;
@@ -8,6 +8,7 @@
 #include "checkpoint.h"
 #include "tools.h"
 #include "timeutil.h"
+#include "profiler.h"
 #include "gzstream.h"
 #include <cstdio>
 
@@ -151,6 +152,7 @@ void Checkpoint::dump(bool force) {
         return;
     }
     prev_dump_time = getRealTime();
+    PROFILE_SCOPE("checkpoint");
     string filename_tmp = filename + ".tmp";
     if (fileExists(filename_tmp)) {
         outWarning("IQ-TREE was killed while writing temporary checkpoint file " + filename_tmp);
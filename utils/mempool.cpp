@@ -0,0 +1,62 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "mempool.h"
+#include "tools.h"
+#include <algorithm>
+
+/** bytes per chunk taken from the system */
+const size_t MEMPOOL_CHUNK_SIZE = 1 << 16;
+
+thread_local void *MemPool::free_list[MemPool::MAX_POOLS];
+
+int MemPool::num_pools = 0;
+
+MemPool::MemPool(size_t obj_size) {
+    this->obj_size = obj_size;
+    size_t align = alignof(max_align_t);
+    stride = (max(obj_size, sizeof(void*)) + align - 1) / align * align;
+    chunk_objs = max((size_t)1, MEMPOOL_CHUNK_SIZE / stride);
+#ifdef _OPENMP
+#pragma omp critical(mempool)
+#endif
+    pool_id = num_pools++;
+    ASSERT(pool_id < MAX_POOLS);
+}
+
+void MemPool::addChunk() {
+    char *chunk = (char*) ::operator new(chunk_objs * stride);
+#ifdef _OPENMP
+#pragma omp critical(mempool)
+#endif
+    chunks.push_back(chunk);
+    // link the objects in address order
+    void *&head = free_list[pool_id];
+    for (size_t i = chunk_objs; i > 0; i--) {
+        void *obj = chunk + (i-1) * stride;
+        *(void**)obj = head;
+        head = obj;
+    }
+}
+
+size_t MemPool::getAllocatedBytes() {
+    return chunks.size() * chunk_objs * stride;
+}
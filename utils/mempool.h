@@ -0,0 +1,109 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+    Pool of objects of one size, used for the nodes and neighbors of the trees.
+    Memory is taken from the system in chunks and never given back: a deleted
+    object goes to the free list of the calling thread and is reused by the next
+    allocation, so that rebuilding a tree (readTreeString(), copyTree()) does not
+    call the system allocator. Only taking a new chunk is synchronized.
+    Objects of another size (derived classes) are passed to the system allocator.
+*/
+class MemPool {
+public:
+
+    /** maximum number of pools in the program */
+    static const int MAX_POOLS = 8;
+
+    /**
+        constructor
+        @param obj_size size of the objects in bytes
+    */
+    explicit MemPool(size_t obj_size);
+
+    /**
+        @param size size of the object in bytes
+        @return memory for an object
+    */
+    inline void *allocate(size_t size) {
+        if (size != obj_size)
+            return ::operator new(size);
+        void *&head = free_list[pool_id];
+        if (!head)
+            addChunk();
+        void *obj = head;
+        head = *(void**)obj;
+        return obj;
+    }
+
+    /**
+        give an object back to the pool
+        @param obj the object
+        @param size size of the object in bytes
+    */
+    inline void deallocate(void *obj, size_t size) {
+        if (size != obj_size) {
+            ::operator delete(obj);
+            return;
+        }
+        void *&head = free_list[pool_id];
+        *(void**)obj = head;
+        head = obj;
+    }
+
+    /** @return number of bytes taken from the system */
+    size_t getAllocatedBytes();
+
+protected:
+
+    /** put a new chunk into the free list of the calling thread */
+    void addChunk();
+
+    /** size of the objects */
+    size_t obj_size;
+
+    /** distance of the objects in a chunk, keeping the alignment of operator new */
+    size_t stride;
+
+    /** number of objects per chunk */
+    size_t chunk_objs;
+
+    /** index of the free list of this pool */
+    int pool_id;
+
+    /** chunks taken from the system */
+    std::vector<char*> chunks;
+
+    /** heads of the free lists of the calling thread, one per pool */
+    static thread_local void *free_list[MAX_POOLS];
+
+    /** number of pools created */
+    static int num_pools;
+};
+
+#endif
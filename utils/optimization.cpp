@@ -11,6 +11,7 @@
 //
 #include "optimization.h"
 #include <cmath>
+#include <cfloat>
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
@@ -1115,7 +1116,7 @@ double Optimization::minimizeNewton(double xmin, double xguess, double xmax, dou
 #undef JMAX*/
 
 
-double Optimization::L_BFGS_B(int n, double* x, double* l, double* u, double pgtol, int maxit) {
+double Optimization::L_BFGS_B(int n, double* x, double* l, double* u, double pgtol, int maxit, double ftol) {
 	int i;
 	double Fmin;
 	int fail;
@@ -1156,7 +1157,7 @@ double Optimization::L_BFGS_B(int n, double* x, double* l, double* u, double pgt
 #else*/
 
 	lbfgsb(n, m, x, l, u, nbd, &Fmin, &fail,
-			factr, pgtol, &fncount, &grcount, maxit, msg, trace, nREPORT);
+			factr, pgtol, &fncount, &grcount, maxit, ftol, msg, trace, nREPORT);
 //#endif
 
     if (fail == 51 || fail == 52) {
@@ -1171,11 +1172,12 @@ double Optimization::L_BFGS_B(int n, double* x, double* l, double* u, double pgt
 void Optimization::lbfgsb(int n, int m, double *x, double *l, double *u, int *nbd,
 		double *Fmin, int *fail,
 		double factr, double pgtol,
-		int *fncount, int *grcount, int maxit, char *msg,
+		int *fncount, int *grcount, int maxit, double ftol, char *msg,
 		int trace, int nREPORT)
 {
 	char task[60];
 	double f, *g, dsave[29], *wa;
+	double prev_f = DBL_MAX; // function value at the previous iterate
 	int tr = -1, iter = 0, *iwa, isave[44], lsave[4];
 
 	/* shut up gcc -Wall in 4.6.x */
@@ -1230,6 +1232,11 @@ void Optimization::lbfgsb(int n, int m, double *x, double *l, double *u, int *nb
 				*fail = 1;
 				break;
 			}
+			if (ftol > 0.0 && prev_f - f < ftol) {
+				strcpy(task, "CONVERGENCE: REDUCTION_OF_F < FTOL");
+				break;
+			}
+			prev_f = f;
 		} else if (strncmp(task, "WARN", 4) == 0) {
 			*fail = 51;
 			break;
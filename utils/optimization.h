@@ -189,10 +189,11 @@ public:
      4. double* upper : upper bounds of the variables
      5. double pgtol: gradient tolerance
      5. int maxit : max # of iterations
+     6. double ftol : stop when an iteration decreases the function by less (0: not used)
      @return minimized function value
      After the function is invoked, the values of x will be updated
     */
-    double L_BFGS_B(int nvar, double* vars, double* lower, double* upper, double pgtol = 1e-5, int maxit = 5); // changed maxit 1000 -> 5 by Thomas on Sept 11, 15
+    double L_BFGS_B(int nvar, double* vars, double* lower, double* upper, double pgtol = 1e-5, int maxit = 5, double ftol = 0.0); // changed maxit 1000 -> 5 by Thomas on Sept 11, 15
 
     /** internal function called by L_BFGS_B
         should return function value 
@@ -234,7 +235,7 @@ private:
     void lbfgsb(int n, int m, double *x, double *l, double *u, int *nbd,
 		double *Fmin, int *fail,
 		double factr, double pgtol,
-		int *fncount, int *grcount, int maxit, char *msg,
+		int *fncount, int *grcount, int maxit, double ftol, char *msg,
 		int trace, int nREPORT);
     
 };
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "profiler.h"
+#include "tools.h"
+#include <atomic>
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+/** names of the counters in the report */
+static const char *counter_names[PC_NUM_COUNTERS] = {
+    "lh_branch_calls", "lh_derv_calls", "lh_buffer_calls", "partial_lh_computations",
+    "patterns_processed", "trans_matrices", "memslot_evictions", "partial_lh_invalidated",
+    "topology_moves", "move_invalidated"
+};
+
+/** head of the list of all thread data */
+static std::atomic<ProfileThreadData*> thread_list(nullptr);
+
+/** number of registered threads */
+static std::atomic<int> num_threads(0);
+
+bool Profiler::enabled = false;
+
+const std::chrono::steady_clock::time_point Profiler::start_time = std::chrono::steady_clock::now();
+
+ProfileThreadData *Profiler::registerThread() {
+    ProfileThreadData *data = new ProfileThreadData;
+    data->thread_id = num_threads++;
+    for (int i = 0; i < PC_NUM_COUNTERS; i++)
+        data->counters[i] = 0;
+    data->num_dropped = 0;
+    // push to the front of the list, never removed
+    data->next = thread_list.load();
+    while (!thread_list.compare_exchange_weak(data->next, data)) {}
+    return data;
+}
+
+void Profiler::addEvent(const char *name, int64_t begin) {
+    ProfileThreadData *data = getThreadData();
+    if (data->events.size() >= MAX_EVENTS) {
+        data->num_dropped++;
+        return;
+    }
+    ProfileEvent event;
+    event.name = name;
+    event.begin = begin;
+    event.duration = now() - begin;
+    data->events.push_back(event);
+}
+
+uint64_t Profiler::getCounter(ProfileCounter counter) {
+    uint64_t sum = 0;
+    for (ProfileThreadData *data = thread_list.load(); data; data = data->next)
+        sum += data->counters[counter];
+    return sum;
+}
+
+/** call count and total time of scopes with the same name */
+struct ProfileStat {
+    uint64_t calls = 0;
+    int64_t total = 0;
+};
+
+void Profiler::printSummary(ostream &out) {
+    map<string, ProfileStat> stats;
+    uint64_t num_dropped = 0;
+    for (ProfileThreadData *data = thread_list.load(); data; data = data->next) {
+        for (auto &event : data->events) {
+            ProfileStat &stat = stats[event.name];
+            stat.calls++;
+            stat.total += event.duration;
+        }
+        num_dropped += data->num_dropped;
+    }
+    vector<pair<string, ProfileStat> > sorted(stats.begin(), stats.end());
+    sort(sorted.begin(), sorted.end(), [](const pair<string, ProfileStat> &a, const pair<string, ProfileStat> &b) {
+        return a.second.total > b.second.total;
+    });
+
+    out << endl << "PROFILE (time summed over threads, nested phases included in their parents)" << endl;
+    out << left << setw(24) << "Phase" << right << setw(12) << "Calls" << setw(14) << "Time (s)" << endl;
+    for (auto &stat : sorted)
+        out << left << setw(24) << stat.first << right << setw(12) << stat.second.calls
+            << setw(14) << fixed << setprecision(3) << stat.second.total * 1e-9 << endl;
+    if (num_dropped)
+        out << num_dropped << " scopes beyond " << MAX_EVENTS << " per thread were not recorded" << endl;
+    out << endl << left << setw(24) << "Counter" << right << setw(20) << "Value" << endl;
+    for (int i = 0; i < PC_NUM_COUNTERS; i++)
+        out << left << setw(24) << counter_names[i] << right << setw(20) << getCounter((ProfileCounter)i) << endl;
+    uint64_t num_moves = getCounter(PC_TOPOLOGY_MOVES);
+    if (num_moves)
+        out << left << setw(24) << "invalidated_per_move" << right << setw(20) << fixed << setprecision(1)
+            << (double)getCounter(PC_MOVE_INVALIDATED) / num_moves << endl;
+    out << endl;
+    out.unsetf(ios_base::floatfield);
+    out << setprecision(6);
+}
+
+void Profiler::writeTrace(const char *filename) {
+    ofstream out;
+    out.exceptions(ios::failbit | ios::badbit);
+    try {
+        out.open(filename);
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+        int64_t end_time = now();
+        bool first = true;
+        out << fixed << setprecision(3);
+        for (ProfileThreadData *data = thread_list.load(); data; data = data->next) {
+            out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": "
+                << data->thread_id << ", \"args\": {\"name\": \"thread " << data->thread_id << "\"}}";
+            first = false;
+            for (auto &event : data->events)
+                out << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+                    << data->thread_id << ", \"ts\": " << event.begin * 1e-3
+                    << ", \"dur\": " << event.duration * 1e-3 << "}";
+            // counters as totals at the end of the run
+            out << ",\n{\"name\": \"counters thread " << data->thread_id << "\", \"ph\": \"C\", \"pid\": 0, \"tid\": "
+                << data->thread_id << ", \"ts\": " << end_time * 1e-3 << ", \"args\": {";
+            for (int i = 0; i < PC_NUM_COUNTERS; i++)
+                out << (i ? ", " : "") << "\"" << counter_names[i] << "\": " << data->counters[i];
+            out << "}}";
+        }
+        out << endl << "]}" << endl;
+        out.close();
+    } catch (ios::failure &) {
+        outError(ERR_WRITE_OUTPUT, filename);
+    }
+}
@@ -0,0 +1,180 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+/** hot-path counters of the profiler */
+enum ProfileCounter {
+    PC_LH_BRANCH,       // calls of computeLikelihoodBranch
+    PC_LH_DERV,         // calls of computeLikelihoodDerv
+    PC_LH_BUFFER,       // calls of computeLikelihoodFromBuffer
+    PC_PARTIAL_LH,      // partial likelihood vectors recomputed
+    PC_PATTERNS,        // patterns processed by the partial likelihood kernel
+    PC_TRANS_MATRIX,    // transition matrices computed
+    PC_MEM_EVICT,       // partial likelihood vectors evicted from memory slots
+    PC_LH_INVALIDATED,  // partial likelihood vectors marked stale after a change of the tree
+    PC_TOPOLOGY_MOVES,  // NNI and SPR moves applied to the tree
+    PC_MOVE_INVALIDATED,// partial likelihood vectors marked stale by topology moves
+    PC_NUM_COUNTERS
+};
+
+/** a timed scope as written to the trace file */
+struct ProfileEvent {
+    /** name of the scope, must be a string literal */
+    const char *name;
+
+    /** begin and duration in nanoseconds since the start of the profiler */
+    int64_t begin, duration;
+};
+
+/**
+    profiling data of one thread, only ever written by that thread
+*/
+struct ProfileThreadData {
+    /** index of the thread in order of its first profiling call */
+    int thread_id;
+
+    /** hot-path counters */
+    uint64_t counters[PC_NUM_COUNTERS];
+
+    /** timed scopes, in order of their end */
+    std::vector<ProfileEvent> events;
+
+    /** number of scopes not stored because events was full */
+    uint64_t num_dropped;
+
+    /** next thread in the global list */
+    ProfileThreadData *next;
+};
+
+/**
+    Low-overhead profiler for the phases and hot paths of IQ-TREE.
+    Counters are always collected: an increment of a thread-local array.
+    Scoped timers only read the clock if the profiler is enabled (--profile) and
+    are placed around phases, not inside the kernels. Every thread keeps its own
+    data, registered once in a lock-free list, so no locks are taken on the way.
+    At the end the data is merged into a report for the log and a trace file in
+    the Chrome trace-event format (chrome://tracing, Perfetto).
+*/
+class Profiler {
+public:
+
+    /** TRUE to time the scopes */
+    static bool enabled;
+
+    /** maximum number of events stored per thread; further scopes are only counted */
+    static const size_t MAX_EVENTS = 1 << 20;
+
+    /** @return the profiling data of the calling thread */
+    static inline ProfileThreadData *getThreadData() {
+        static thread_local ProfileThreadData *data = nullptr;
+        if (!data)
+            data = registerThread();
+        return data;
+    }
+
+    /**
+        increase a counter of the calling thread
+        @param counter the counter
+        @param value the increment
+    */
+    static inline void count(ProfileCounter counter, uint64_t value = 1) {
+        getThreadData()->counters[counter] += value;
+    }
+
+    /** @return nanoseconds since the start of the profiler */
+    static inline int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    /**
+        store a timed scope of the calling thread
+        @param name name of the scope
+        @param begin begin of the scope from now()
+    */
+    static void addEvent(const char *name, int64_t begin);
+
+    /** @return the sum of a counter over all threads */
+    static uint64_t getCounter(ProfileCounter counter);
+
+    /**
+        print the time per scope and the counters summed over all threads
+        @param out output stream
+    */
+    static void printSummary(std::ostream &out);
+
+    /**
+        write all scopes and counters as a Chrome trace-event JSON file
+        @param filename file name
+    */
+    static void writeTrace(const char *filename);
+
+protected:
+
+    /** time point of the start of the profiler */
+    static const std::chrono::steady_clock::time_point start_time;
+
+    /** @return new profiling data of the calling thread, added to the global list */
+    static ProfileThreadData *registerThread();
+
+};
+
+/**
+    times its lifetime as a scope of the profiler
+*/
+class ProfileScope {
+public:
+    /**
+        @param name name of the scope, must be a string literal
+    */
+    explicit ProfileScope(const char *name) {
+        if (Profiler::enabled) {
+            this->name = name;
+            begin = Profiler::now();
+        } else {
+            this->name = nullptr;
+        }
+    }
+
+    ~ProfileScope() {
+        if (name)
+            Profiler::addEvent(name, begin);
+    }
+
+protected:
+    const char *name;
+    int64_t begin;
+};
+
+#define PROFILE_CONCAT2(a, b) a ## b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
+/** time the rest of the enclosing block as a scope of the profiler */
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+
+#endif
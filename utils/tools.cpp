@@ -2055,6 +2055,10 @@ void parseArg(int argc, char *argv[], Params &params) {
             if (strcmp(argv[cnt], "--estimate-model") == 0) {
                 params.topotest_optimize_model = true;
                 continue;
+            }
+            if (strcmp(argv[cnt], "--test-parallel") == 0) {
+                params.topotest_parallel = true;
+                continue;
             }
 			if (strcmp(argv[cnt], "-zw") == 0 || strcmp(argv[cnt], "--test-weight") == 0) {
 				params.do_weighted_test = true;
@@ -2368,6 +2372,11 @@ void parseArg(int argc, char *argv[], Params &params) {
                 continue;
             }
             
+            if (strcmp(argv[cnt], "-g_count") == 0) {
+                params.terrace_count_only = true;
+                continue;
+            }
+            
             if (strcmp(argv[cnt], "-m_only") == 0) {
                 params.matrix_order = true;
                 params.print_pr_ab_matrix = true;
@@ -3168,6 +3177,16 @@ void parseArg(int argc, char *argv[], Params &params) {
                 continue;
             }
 
+            if (strcmp(argv[cnt], "--freq-eps") == 0) {
+                cnt++;
+                if (cnt >= argc)
+                    throw "Use --freq-eps <epsilon_to_merge_site_frequencies>";
+                params.site_freq_epsilon = convert_double(argv[cnt]);
+                if (params.site_freq_epsilon < 0.0 || params.site_freq_epsilon >= 1.0)
+                    throw "--freq-eps must be in [0,1)";
+                continue;
+            }
+
 			if (strcmp(argv[cnt], "-fconst") == 0) {
 				cnt++;
 				if (cnt >= argc)
@@ -3356,6 +3375,10 @@ void parseArg(int argc, char *argv[], Params &params) {
 				params.optimize_model_rate_joint = true;
 				continue;
 			}
+			if (strcmp(argv[cnt], "--joint-brlen") == 0) {
+				params.optimize_brlen_joint = true;
+				continue;
+			}
 			if (strcmp(argv[cnt], "-brent_ginvar") == 0) {
 				params.optimize_model_rate_joint = false;
 				continue;
@@ -3509,7 +3532,6 @@ void parseArg(int argc, char *argv[], Params &params) {
                 continue;
             }
 
-#ifdef USE_BOOSTER
             if (strcmp(argv[cnt], "--tbe") == 0) {
                 params.transfer_bootstrap = 1;
                 continue;
@@ -3519,7 +3541,12 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.transfer_bootstrap = 2;
                 continue;
             }
-#endif
+
+            if (strcmp(argv[cnt], "--tbe-stat") == 0) {
+                params.transfer_bootstrap = max(params.transfer_bootstrap, 1);
+                params.transfer_bootstrap_stat = true;
+                continue;
+            }
 
             if (strcmp(argv[cnt], "-bc") == 0 || strcmp(argv[cnt], "--bcon") == 0) {
 				params.multi_tree = true;
@@ -4102,6 +4129,10 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.buffer_mem_save = false;
                 continue;
             }
+            if (strcmp(argv[cnt], "--site-repeats") == 0) {
+                params.site_repeats = true;
+                continue;
+            }
 //			if (strcmp(argv[cnt], "-storetrees") == 0) {
 //				params.store_candidate_trees = true;
 //				continue;
@@ -4296,6 +4327,14 @@ void parseArg(int argc, char *argv[], Params &params) {
 				ASSERT(params.popSize < params.numInitTrees);
 				continue;
 			}
+			if (strcmp(argv[cnt], "--mpi-gossip") == 0) {
+				params.mpi_gossip = true;
+				continue;
+			}
+			if (strcmp(argv[cnt], "--mpi-patterns") == 0) {
+				params.mpi_patterns = true;
+				continue;
+			}
 			if (strcmp(argv[cnt], "-beststart") == 0) {
 				params.bestStart = true;
 				cnt++;
@@ -4576,6 +4615,34 @@ void parseArg(int argc, char *argv[], Params &params) {
                 continue;
             }
             
+            if (strcmp(argv[cnt], "--thread-cache") == 0) {
+                cnt++;
+                if (cnt >= argc)
+                    throw "Use --thread-cache <file>";
+                params.thread_cache_file = argv[cnt];
+                continue;
+            }
+
+            if (strcmp(argv[cnt], "--no-thread-cache") == 0) {
+                params.thread_cache_file = "";
+                continue;
+            }
+
+            if (strcmp(argv[cnt], "--thread-retune") == 0) {
+                cnt++;
+                if (cnt >= argc)
+                    throw "Use --thread-retune <num_iterations>";
+                params.thread_retune = convert_int(argv[cnt]);
+                if (params.thread_retune < 0)
+                    throw "Number of iterations for --thread-retune must not be negative";
+                continue;
+            }
+
+            if (strcmp(argv[cnt], "--profile") == 0) {
+                params.profile = true;
+                continue;
+            }
+
             if (strcmp(argv[cnt], "--thread-model") == 0) {
                 params.openmp_by_model = true;
                 continue;
@@ -4610,6 +4677,15 @@ void parseArg(int argc, char *argv[], Params &params) {
 				params.sprDist = convert_int(argv[cnt]);
 				continue;
 			}
+			if (strcmp(argv[cnt], "--spr-radius") == 0) {
+				cnt++;
+				if (cnt >= argc)
+					throw "Use --spr-radius <radius of ML SPR moves>";
+				params.ml_spr_radius = convert_int(argv[cnt]);
+				if (params.ml_spr_radius < 0)
+					throw "SPR radius must not be negative";
+				continue;
+			}
             
             if (strcmp(argv[cnt], "--mpcost") == 0) {
                 cnt++;
@@ -4948,6 +5024,11 @@ void parseArg(int argc, char *argv[], Params &params) {
 				continue;
 			}
 
+			if (strcmp(argv[cnt], "--lmap-generic") == 0) {
+				params.lmap_generic_kernel = true;
+				continue;
+			}
+
 			if (strcmp(argv[cnt], "-mixlen") == 0) {
 				cnt++;
 				if (cnt >= argc)
@@ -5532,6 +5613,19 @@ void parseArg(int argc, char *argv[], Params &params) {
     if (params.num_bootstrap_samples && params.partition_type == TOPO_UNLINKED)
         outError("-b bootstrap option does not work with -S yet.");
 
+    if (params.mpi_patterns) {
+        // every process must evaluate the same trees and models on its share of the patterns
+        if (params.min_iterations != 0)
+            outError("--mpi-patterns requires a fixed tree topology (-te or --tree-fix)");
+        if (params.model_name.empty() || params.model_name.substr(0, 4) == "TEST" || params.model_name.substr(0, 2) == "MF" ||
+            params.model_name.find("+MF") != string::npos)
+            outError("--mpi-patterns requires a substitution model (-m), ModelFinder is not supported");
+        if (params.partition_file)
+            outError("--mpi-patterns does not support partition models");
+        if (params.num_runs > 1 || params.gbo_replicates || params.num_bootstrap_samples)
+            outError("--mpi-patterns cannot be combined with --runs and bootstrap");
+    }
+
     //added to remove situations where we're optimizing a linked rate matrix when we really shouldn't be -JD
     if (params.optimize_linked_gtr && params.model_name.find("GTR") == string::npos && params.model_joint.find("GTR") == string::npos)
         outError("Must have either GTR or GTR20 as part of the model when using --link-exchange-rates.");
@@ -5781,6 +5875,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --prefix STRING      Prefix for all output files (default: aln/partition)" << endl
     << "  --seed NUM           Random seed number, normally used for debugging purpose" << endl
     << "  --safe               Safe likelihood kernel to avoid numerical underflow" << endl
+    << "  --site-repeats       Reuse partial likelihoods of repeated subtree patterns" << endl
     << "  --mem NUM[G|M|%]     Maximal RAM usage in GB | MB | %" << endl
     << "  --runs NUM           Number of indepedent runs (default: 1)" << endl
     << "  -v, --verbose        Verbose mode, printing more messages to screen" << endl
@@ -5788,9 +5883,14 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --quiet              Quiet mode, suppress printing to screen (stdout)" << endl
     << "  -fconst f1,...,fN    Add constant patterns into alignment (N=no. states)" << endl
     << "  --epsilon NUM        Likelihood epsilon for parameter estimate (default 0.01)" << endl
+    << "  --joint-brlen        Optimize branch lengths jointly with model parameters" << endl
+    << "  --profile            Write time per phase and kernel counters to .profile.json" << endl
 #ifdef _OPENMP
     << "  -T NUM|AUTO          No. cores/threads or AUTO-detect (default: 1)" << endl
     << "  --threads-max NUM    Max number of threads for -T AUTO (default: all cores)" << endl
+    << "  --thread-cache FILE  Thread profiles for -T AUTO (default: ~/.iqtree_threads)" << endl
+    << "  --no-thread-cache    Always measure the best number of threads for -T AUTO" << endl
+    << "  --thread-retune NUM  Iterations between re-tuning -T AUTO (default: 100, 0: off)" << endl
 #endif
     << endl << "CHECKPOINT:" << endl
     << "  --redo               Redo both ModelFinder and tree search" << endl
@@ -5809,15 +5909,19 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --lmap NUM           Number of quartets for likelihood mapping analysis" << endl
     << "  --lmclust FILE       NEXUS file containing clusters for likelihood mapping" << endl
     << "  --quartetlh          Print quartet log-likelihoods to .quartetlh file" << endl
+    << "  --lmap-generic       Use generic tree kernel for quartet likelihoods" << endl
     << endl << "TREE SEARCH ALGORITHM:" << endl
 //            << "  -pll                 Use phylogenetic likelihood library (PLL) (default: off)" << endl
     << "  --ninit NUM          Number of initial parsimony trees (default: 100)" << endl
     << "  --ntop NUM           Number of top initial trees (default: 20)" << endl
     << "  --nbest NUM          Number of best trees retained during search (default: 5)" << endl
+    << "  --mpi-gossip         Exchange trees between MPI processes without master (MPI)" << endl
+    << "  --mpi-patterns       Distribute alignment patterns over MPI processes (MPI, -te)" << endl
     << "  -n NUM               Fix number of iterations to stop (default: OFF)" << endl
     << "  --nstop NUM          Number of unsuccessful iterations to stop (default: 100)" << endl
     << "  --perturb NUM        Perturbation strength for randomized NNI (default: 0.5)" << endl
     << "  --radius NUM         Radius for parsimony SPR search (default: 6)" << endl
+    << "  --spr-radius NUM     Radius of ML SPR rounds after NNI search (default: 0, off)" << endl
     << "  --allnni             Perform more thorough NNI search (default: OFF)" << endl
     << "  -g FILE              (Multifurcating) topological constraint tree file" << endl
     << "  --fast               Fast search to resemble FastTree" << endl
@@ -5849,9 +5953,8 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --jack-prop NUM      Subsampling proportion for jackknife (default: 0.5)" << endl
     << "  --bcon NUM           Replicates for bootstrap + consensus tree" << endl
     << "  --bonly NUM          Replicates for bootstrap only" << endl
-#ifdef USE_BOOSTER
     << "  --tbe                Transfer bootstrap expectation" << endl
-#endif
+    << "  --tbe-stat           Also write transfer index of taxa (.tbe.stat)" << endl
 //            << "  -t <threshold>       Minimum bootstrap support [0...1) for consensus tree" << endl
     << endl << "SINGLE BRANCH TEST:" << endl
     << "  --alrt NUM           Replicates for SH approximate likelihood ratio test" << endl
@@ -5978,12 +6081,14 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --tree-freq FILE     Input tree to infer site frequency model" << endl
     << "  --site-freq FILE     Input site frequency model file" << endl
     << "  --freq-max           Posterior maximum instead of mean approximation" << endl
+    << "  --freq-eps NUM       Merge site frequency vectors differing by < NUM (default: 0)" << endl
 
     << endl << "TREE TOPOLOGY TEST:" << endl
     << "  --trees FILE         Set of trees to evaluate log-likelihoods" << endl
     << "  --test NUM           Replicates for topology test" << endl
     << "  --test-weight        Perform weighted KH and SH tests" << endl
     << "  --test-au            Approximately unbiased (AU) test (Shimodaira 2002)" << endl
+    << "  --test-parallel      Evaluate trees concurrently, one tree per thread" << endl
     << "  --au-epsilon NUM     Epsilon for AU test: if |deltaL| < NUM, keep tree regardless of p-value (default: 0.001)" << endl
     << "  --sitelh             Write site log-likelihoods to .sitelh file" << endl
 
@@ -6025,6 +6130,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  -g_stop_i NUM        Stop after NUM intermediate trees were visited, or use 0 to turn off this stopping rule. Default: 10MLN trees." << endl
     << "  -g_stop_h NUM        Stop after NUM hours (CPU time), or use 0 to turn off this stopping rule. Default: 7 days." << endl
     << "  -g_non_stop          Turn off all stopping rules." << endl
+    << "  -g_count             Only count species-trees, do not generate them at the last step." << endl
     << "  -g_query FILE        Species-trees to test for identical set of subtrees." << endl
     << "  -g_print             Write all generated species-trees. WARNING: there might be millions of trees!" << endl
     << "  -g_print_lim NUM     Limit on the number of species-trees to be written." << endl
@@ -7098,6 +7204,7 @@ void Params::setDefault() {
     num_bootstrap_samples = 0;
     bootstrap_spec = nullptr;
     transfer_bootstrap = 0;
+    transfer_bootstrap_stat = false;
 
     aln_file = nullptr;
     phylip_sequential_format = false;
@@ -7112,6 +7219,7 @@ void Params::setDefault() {
     //treeset_file = nullptr;
     topotest_replicates = 0;
     topotest_optimize_model = false;
+    topotest_parallel = false;
     do_weighted_test = false;
     do_au_test = false;
     au_epsilon = 0.001;
@@ -7154,6 +7262,8 @@ void Params::setDefault() {
     ls_var_type = OLS;
     maxCandidates = 20;
     popSize = 5;
+    mpi_gossip = false;
+    mpi_patterns = false;
     p_delete = -1;
     min_iterations = -1;
     max_iterations = 1000;
@@ -7201,6 +7311,7 @@ void Params::setDefault() {
     gamma_median = false;
     p_invar_sites = -1.0;
     optimize_model_rate_joint = false;
+    optimize_brlen_joint = false;
     optimize_by_newton = true;
     optimize_alg_freerate = "2-BFGS,EM";
     optimize_alg_mixlen = "EM";
@@ -7355,6 +7466,7 @@ void Params::setDefault() {
     numSupportTrees = 20;
 //    sprDist = 20;
     sprDist = 6;
+    ml_spr_radius = 0;
     sankoff_cost_file = nullptr;
     numNNITrees = 20;
     avh_test = 0;
@@ -7362,8 +7474,15 @@ void Params::setDefault() {
     bootlh_partitions = nullptr;
     site_freq_file = nullptr;
     tree_freq_file = nullptr;
+    site_freq_epsilon = 0.0;
     num_threads = 1;
     num_threads_max = 10000;
+    if (getenv("HOME"))
+        thread_cache_file = string(getenv("HOME")) + "/.iqtree_threads";
+    else if (getenv("USERPROFILE"))
+        thread_cache_file = string(getenv("USERPROFILE")) + "/.iqtree_threads";
+    thread_retune = 100;
+    profile = false;
     openmp_by_model = false;
     model_test_criterion = MTC_BIC;
 //    model_test_stop_rule = MTC_ALL;
@@ -7382,6 +7501,7 @@ void Params::setDefault() {
     print_branch_lengths = false;
     lh_mem_save = LM_PER_NODE; // auto detect
     buffer_mem_save = false;
+    site_repeats = false;
     start_tree = STT_PLL_PARSIMONY;
     start_tree_subtype_name = StartTree::Factory::getNameOfDefaultTreeBuilder();
 
@@ -7400,6 +7520,7 @@ void Params::setDefault() {
     lmap_num_quartets = -1;
     lmap_cluster_file = nullptr;
     print_lmap_quartet_lh = false;
+    lmap_generic_kernel = false;
     num_mixlen = 1;
     link_alpha = false;
     link_model = false;
@@ -7441,6 +7562,7 @@ void Params::setDefault() {
     terrace_stop_time = -1;
     terrace_non_stop = false;
     terrace_print_lim = 0;
+    terrace_count_only = false;
     terrace_remove_m_leaves = 0;
     matrix_order = false;
     gen_all_NNI = false;
@@ -738,6 +738,9 @@ public:
 	 */
 	int sprDist;
 
+    /** radius of the SPR rounds by maximum likelihood after each NNI search, 0 to use NNI only */
+    int ml_spr_radius;
+
     /** cost matrix file for Sankoff parsimony */
     char *sankoff_cost_file;
     
@@ -753,6 +756,18 @@ public:
 	 */
 	int popSize;
 
+	/**
+	 *  TRUE to exchange candidate trees between MPI processes by non-blocking gossip
+	 *  instead of the blocking master-worker exchange
+	 */
+	bool mpi_gossip;
+
+	/**
+	 *  TRUE to distribute the alignment patterns over MPI processes and sum up
+	 *  the likelihood of each evaluation (fixed tree topology only)
+	 */
+	bool mpi_patterns;
+
 
 	/**
 	 *  heuristics for speeding up NNI evaluation
@@ -997,6 +1012,10 @@ public:
      FALSE (default) to only optimize branch lengths */
     bool topotest_optimize_model;
 
+    /** TRUE to evaluate several user trees concurrently, each on one thread,
+     sharing the model of the main tree (only when the model is not re-optimized) */
+    bool topotest_parallel;
+
     /** true to perform weighted SH and KH test */
     bool do_weighted_test;
 
@@ -1092,6 +1111,11 @@ public:
      */
     int terrace_print_lim;
     
+    /**
+        only count the trees on a stand at the last insertion step instead of generating them
+     */
+    bool terrace_count_only;
+    
     /**
         flag: only order pr_ab_matrix
      */
@@ -1785,6 +1809,9 @@ public:
     /** TRUE to optimize all model and rate parameters jointly by BFGS, default: FALSE */
     bool optimize_model_rate_joint;
 
+    /** TRUE to optimize branch lengths together with model and rate parameters by L-BFGS-B, default: FALSE */
+    bool optimize_brlen_joint;
+
     /**
             TRUE if you want to optimize branch lengths by Newton-Raphson method
      */
@@ -1907,6 +1934,9 @@ public:
 
     /** 1 or 2 to perform transfer boostrap expectation (TBE) */
     int transfer_bootstrap;
+
+    /** TRUE to write transfer distances and transfer index of taxa (.tbe.stat) */
+    bool transfer_bootstrap_stat;
     
     /** subsampling some number of partitions / sites for analysis */
     int subsampling;
@@ -2358,11 +2388,26 @@ public:
     */
     char *tree_freq_file;
 
+    /**
+        site frequency vectors differing by less than this value in every state are merged,
+        0 to merge only identical vectors
+    */
+    double site_freq_epsilon;
+
     /** number of threads for OpenMP version     */
     int num_threads;
     
     /** maximum number of threads, default: #CPU scores  */
     int num_threads_max;
+
+    /** file storing the thread profiles of -T AUTO per host, empty to disable */
+    string thread_cache_file;
+
+    /** number of search iterations between checks of the multi-threading efficiency, 0 to disable */
+    int thread_retune;
+
+    /** true to time the phases of the analysis and write them to .profile.json */
+    bool profile;
     
     /** true to parallel ModelFinder by models instead of sites */
     bool openmp_by_model;
@@ -2425,6 +2470,9 @@ public:
     /** true to save buffer, default: false */
     bool buffer_mem_save;
 
+    /** true to skip pattern blocks whose partial likelihoods repeat an earlier block in the subtree */
+    bool site_repeats;
+
     /** maximum size of memory allowed to use */
     double max_mem_size;
 
@@ -2470,6 +2518,9 @@ public:
     /** TRUE to print quartet log-likelihoods to .quartetlh file */
     bool print_lmap_quartet_lh;
 
+    /** TRUE to compute quartet likelihoods with the generic tree kernel instead of QuartetLikelihood */
+    bool lmap_generic_kernel;
+
     /** true if ignoring the "finished" flag in checkpoint file */
     bool force_unfinished;
     